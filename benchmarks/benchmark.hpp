@@ -0,0 +1,259 @@
+/*
+ * PoPS model - dependency-free timing harness for benchmarks
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_BENCHMARK_HPP
+#define POPS_BENCHMARK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef POPS_VERSION
+#define POPS_VERSION "unknown"
+#endif
+
+/*! Ordered list of benchmark parameters (name and value as text)
+ *
+ * The parameters are reported together with the timing, so that results
+ * from different runs can be matched.
+ */
+typedef std::vector<std::pair<std::string, std::string>> BenchmarkParameters;
+
+/*! Convert a value to text for use in BenchmarkParameters
+ */
+template<typename T>
+std::string to_text(const T& value)
+{
+    std::ostringstream stream;
+    stream << value;
+    return stream.str();
+}
+
+/*! Stopwatch passed to the benchmarked function
+ *
+ * Only the time between start() and stop() is measured, so the benchmarked
+ * function can prepare its (fresh) input data before calling start().
+ * The *checksum* is reported in the output and it should be set to a value
+ * derived from the result of the benchmarked code. This prevents the
+ * compiler from optimizing the code away and it also allows to spot
+ * changes in behavior between versions.
+ */
+class BenchmarkTimer
+{
+public:
+    void start()
+    {
+        start_ = std::chrono::steady_clock::now();
+    }
+
+    void stop()
+    {
+        auto end = std::chrono::steady_clock::now();
+        elapsed_ += std::chrono::duration<double>(end - start_).count();
+    }
+
+    double elapsed() const
+    {
+        return elapsed_;
+    }
+
+    void reset()
+    {
+        elapsed_ = 0;
+    }
+
+    double checksum{0};
+
+private:
+    std::chrono::steady_clock::time_point start_;
+    double elapsed_{0};
+};
+
+/*! Runs benchmarks and reports their results in a machine-readable format.
+ *
+ * The output is either JSON Lines (one JSON object per line, default) or CSV.
+ * Command line options (all optional):
+ *
+ * ```
+ * --repetitions N   number of timed repetitions (default 5)
+ * --format F        json or csv (default json)
+ * --output FILE     append results to a file instead of standard output
+ * --filter TEXT     run only benchmarks with TEXT in their name
+ * --rows N          number of rows of the synthetic landscape
+ * --cols N          number of columns of the synthetic landscape
+ * --help            print usage and exit
+ * ```
+ *
+ * The rows and columns are not used by the runner itself, but they are
+ * available to the benchmarks through rows() and cols().
+ */
+class BenchmarkRunner
+{
+public:
+    BenchmarkRunner(int argc, char** argv, const std::string& suite)
+        : suite_(suite)
+    {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--help") {
+                std::cout << "Usage: " << argv[0]
+                          << " [--repetitions N] [--format json|csv] [--output FILE]"
+                             " [--filter TEXT] [--rows N] [--cols N]\n";
+                std::exit(EXIT_SUCCESS);
+            }
+            if (i + 1 >= argc)
+                throw std::invalid_argument("Missing value for option " + arg);
+            std::string value = argv[++i];
+            if (arg == "--repetitions")
+                repetitions_ = std::stoi(value);
+            else if (arg == "--format")
+                format_ = value;
+            else if (arg == "--output")
+                output_file_ = value;
+            else if (arg == "--filter")
+                filter_ = value;
+            else if (arg == "--rows")
+                rows_ = std::stoi(value);
+            else if (arg == "--cols")
+                cols_ = std::stoi(value);
+            else
+                throw std::invalid_argument("Unknown option " + arg);
+        }
+        if (repetitions_ < 1)
+            throw std::invalid_argument("Number of repetitions must be at least 1");
+        if (format_ != "json" && format_ != "csv")
+            throw std::invalid_argument("Unknown format " + format_);
+        bool write_header = true;
+        if (!output_file_.empty()) {
+            // Header is written only once when appending to an existing file.
+            std::ifstream existing(output_file_);
+            if (existing && existing.peek() != std::ifstream::traits_type::eof())
+                write_header = false;
+            file_.open(output_file_, std::ios::app);
+            if (!file_)
+                throw std::runtime_error("Cannot open output file " + output_file_);
+        }
+        if (format_ == "csv" && write_header)
+            stream() << "suite,benchmark,parameters,version,repetitions,"
+                        "min_seconds,median_seconds,mean_seconds,max_seconds,"
+                        "checksum\n";
+    }
+
+    int rows() const
+    {
+        return rows_;
+    }
+
+    int cols() const
+    {
+        return cols_;
+    }
+
+    /*! Run one benchmark and report the result
+     *
+     * The *function* is called once without timing (warm-up) and then
+     * repeatedly with timing. It takes BenchmarkTimer as a parameter.
+     */
+    template<typename Function>
+    void run(
+        const std::string& name,
+        const BenchmarkParameters& parameters,
+        Function function)
+    {
+        if (!filter_.empty() && name.find(filter_) == std::string::npos)
+            return;
+        BenchmarkTimer timer;
+        function(timer);
+        std::vector<double> times;
+        times.reserve(repetitions_);
+        for (int i = 0; i < repetitions_; ++i) {
+            timer.reset();
+            function(timer);
+            times.push_back(timer.elapsed());
+        }
+        report(name, parameters, times, timer.checksum);
+    }
+
+private:
+    std::string suite_;
+    int repetitions_{5};
+    std::string format_{"json"};
+    std::string output_file_;
+    std::string filter_;
+    int rows_{500};
+    int cols_{500};
+    std::ofstream file_;
+
+    std::ostream& stream()
+    {
+        if (file_.is_open())
+            return file_;
+        return std::cout;
+    }
+
+    void report(
+        const std::string& name,
+        const BenchmarkParameters& parameters,
+        std::vector<double> times,
+        double checksum)
+    {
+        std::sort(times.begin(), times.end());
+        double sum = 0;
+        for (double time : times)
+            sum += time;
+        double median = times.size() % 2
+                            ? times[times.size() / 2]
+                            : (times[times.size() / 2 - 1] + times[times.size() / 2])
+                                  / 2;
+        std::ostream& out = stream();
+        out.precision(9);
+        if (format_ == "json") {
+            out << "{\"suite\": \"" << suite_ << "\", \"benchmark\": \"" << name
+                << "\", \"parameters\": {";
+            for (size_t i = 0; i < parameters.size(); ++i) {
+                if (i)
+                    out << ", ";
+                out << "\"" << parameters[i].first << "\": \"" << parameters[i].second
+                    << "\"";
+            }
+            out << "}, \"version\": \"" << POPS_VERSION
+                << "\", \"repetitions\": " << times.size()
+                << ", \"min_seconds\": " << times.front()
+                << ", \"median_seconds\": " << median
+                << ", \"mean_seconds\": " << sum / times.size()
+                << ", \"max_seconds\": " << times.back()
+                << ", \"checksum\": " << checksum << "}\n";
+        }
+        else {
+            out << suite_ << "," << name << ",\"";
+            for (size_t i = 0; i < parameters.size(); ++i) {
+                if (i)
+                    out << ";";
+                out << parameters[i].first << "=" << parameters[i].second;
+            }
+            out << "\"," << POPS_VERSION << "," << times.size() << "," << times.front()
+                << "," << median << "," << sum / times.size() << "," << times.back()
+                << "," << checksum << "\n";
+        }
+        out.flush();
+    }
+};
+
+#endif  // POPS_BENCHMARK_HPP
@@ -0,0 +1,370 @@
+/*
+ * PoPS model - benchmarks for dispersal kernels
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "benchmark.hpp"
+#include "landscape.hpp"
+
+#include <pops/alias_kernel.hpp>
+#include <pops/kernel.hpp>
+#include <pops/raster.hpp>
+#include <pops/simulation.hpp>
+#include <pops/tiled_raster.hpp>
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace pops;
+
+/*! Benchmark Simulation::disperse() with the given kernel
+ *
+ * Dispersers are generated once (deterministically) and only the dispersal
+ * and establishment is timed.
+ */
+template<typename KernelFactory>
+void run_disperse(
+    BenchmarkRunner& runner,
+    const std::string& name,
+    const BenchmarkParameters& parameters,
+    const SyntheticLandscape& landscape,
+    const Raster<int>& dispersers,
+    KernelFactory create_kernel)
+{
+    int rows = landscape.infected.rows();
+    int cols = landscape.infected.cols();
+    runner.run(name, parameters, [&](BenchmarkTimer& timer) {
+        Simulation<Raster<int>, Raster<double>> simulation(42, rows, cols);
+        auto susceptible = landscape.susceptible;
+        auto infected = landscape.infected;
+        Raster<int> mortality_tracker(rows, cols, 0);
+        std::vector<std::tuple<int, int>> outside_dispersers;
+        timer.start();
+        auto kernel = create_kernel();
+        simulation.disperse(
+            dispersers,
+            susceptible,
+            infected,
+            mortality_tracker,
+            landscape.total_hosts,
+            outside_dispersers,
+            true,
+            landscape.weather_coefficient,
+            kernel,
+            landscape.suitable_cells);
+        timer.stop();
+        timer.checksum = raster_sum(infected) + outside_dispersers.size();
+    });
+}
+
+/*! Kernel which provides only sample() of the wrapped kernel
+ *
+ * Used to compare dispersal with and without the sample_counts() function.
+ */
+template<typename Kernel>
+class SampleOnlyKernel
+{
+public:
+    explicit SampleOnlyKernel(const Kernel& kernel) : kernel_(kernel) {}
+
+    template<typename Generator>
+    void sample(
+        Generator& generator,
+        int row,
+        int col,
+        int count,
+        std::vector<std::tuple<int, int>>& targets)
+    {
+        kernel_.sample(generator, row, col, count, targets);
+    }
+
+private:
+    Kernel kernel_;
+};
+
+int main(int argc, char** argv)
+{
+    BenchmarkRunner runner(argc, argv, "kernels");
+    auto parameters = landscape_parameters(runner);
+    auto landscape = generate_landscape(parameters);
+    int rows = landscape.infected.rows();
+    int cols = landscape.infected.cols();
+    auto reported = benchmark_parameters(parameters);
+
+    Raster<int> dispersers(rows, cols, 0);
+    Simulation<Raster<int>, Raster<double>> simulation(
+        42, rows, cols, ModelType::SusceptibleInfected, 0, false);
+    simulation.generate(
+        dispersers,
+        landscape.infected,
+        true,
+        landscape.weather_coefficient,
+        4.4,
+        landscape.suitable_cells);
+
+    double resolution = 30;
+    double scale = 50;
+    // Exponential power and logistic are left out because RadialDispersalKernel
+    // currently dispatches both to an exponential power sampling which does not
+    // always converge.
+    std::vector<std::string> radial_kernels = {
+        "cauchy",
+        "exponential",
+        "power law",
+        "hyperbolic secant",
+        "gamma",
+        "weibull",
+        "normal",
+        "log normal"};
+    for (const auto& kernel_name : radial_kernels) {
+        auto kernel_type = kernel_type_from_string(kernel_name);
+        // Shape is used only by some of the kernels.
+        double shape = 1.5;
+        if (kernel_type == DispersalKernelType::PowerLaw)
+            shape = 3;
+        auto kernel_parameters = reported;
+        kernel_parameters.emplace_back("kernel", kernel_name);
+        run_disperse(
+            runner,
+            "disperse_radial",
+            kernel_parameters,
+            landscape,
+            dispersers,
+            [&]() {
+                return RadialDispersalKernel<Raster<int>>(
+                    resolution,
+                    resolution,
+                    kernel_type,
+                    scale,
+                    Direction::None,
+                    0,
+                    shape);
+            });
+        kernel_parameters.emplace_back("direction", "NE");
+        run_disperse(
+            runner,
+            "disperse_radial",
+            kernel_parameters,
+            landscape,
+            dispersers,
+            [&]() {
+                return RadialDispersalKernel<Raster<int>>(
+                    resolution,
+                    resolution,
+                    kernel_type,
+                    scale,
+                    Direction::NE,
+                    2,
+                    shape);
+            });
+    }
+
+    auto uniform_parameters = reported;
+    uniform_parameters.emplace_back("kernel", "uniform");
+    run_disperse(
+        runner,
+        "disperse_uniform",
+        uniform_parameters,
+        landscape,
+        dispersers,
+        [&]() { return UniformDispersalKernel(rows - 1, cols - 1); });
+
+    auto neighbor_parameters = reported;
+    neighbor_parameters.emplace_back("kernel", "deterministic neighbor");
+    run_disperse(
+        runner,
+        "disperse_neighbor",
+        neighbor_parameters,
+        landscape,
+        dispersers,
+        [&]() { return DeterministicNeighborDispersalKernel(Direction::E); });
+
+    for (const auto& kernel_name : {"cauchy", "exponential"}) {
+        auto kernel_parameters = reported;
+        kernel_parameters.emplace_back("kernel", kernel_name);
+        kernel_parameters.emplace_back("dispersal_percentage", "0.99");
+        // Construction is timed too because it builds the probability window.
+        run_disperse(
+            runner,
+            "disperse_deterministic",
+            kernel_parameters,
+            landscape,
+            dispersers,
+            [&]() {
+                return DeterministicDispersalKernel<Raster<int>>(
+                    kernel_type_from_string(kernel_name),
+                    dispersers,
+                    0.99,
+                    resolution,
+                    resolution,
+                    scale);
+            });
+    }
+
+    // Same kernels as the radial ones sampled from an alias table.
+    for (const auto& kernel_name : {"cauchy", "exponential", "normal"}) {
+        auto kernel_type = kernel_type_from_string(kernel_name);
+        for (auto direction : {Direction::None, Direction::NE}) {
+            auto kernel_parameters = reported;
+            kernel_parameters.emplace_back("kernel", kernel_name);
+            kernel_parameters.emplace_back("dispersal_percentage", "0.99");
+            if (direction != Direction::None)
+                kernel_parameters.emplace_back("direction", "NE");
+            // Construction is timed too because it builds the table.
+            run_disperse(
+                runner,
+                "disperse_alias",
+                kernel_parameters,
+                landscape,
+                dispersers,
+                [&]() {
+                    return AliasDispersalKernel(
+                        resolution,
+                        resolution,
+                        kernel_type,
+                        scale,
+                        0.99,
+                        direction,
+                        2);
+                });
+        }
+    }
+
+    // Heavily infested cells dispersed with counts per target cell (bulk)
+    // and one disperser at a time.
+    Raster<int> many_dispersers = dispersers;
+    many_dispersers *= 100;
+    for (bool bulk : {true, false}) {
+        auto kernel_parameters = reported;
+        kernel_parameters.emplace_back("kernel", "exponential");
+        kernel_parameters.emplace_back("dispersers_multiplier", "100");
+        kernel_parameters.emplace_back("bulk", bulk ? "yes" : "no");
+        auto create_kernel = [&]() {
+            return AliasDispersalKernel(
+                resolution,
+                resolution,
+                DispersalKernelType::Exponential,
+                scale,
+                0.99);
+        };
+        if (bulk) {
+            run_disperse(
+                runner,
+                "disperse_bulk",
+                kernel_parameters,
+                landscape,
+                many_dispersers,
+                create_kernel);
+        }
+        else {
+            run_disperse(
+                runner,
+                "disperse_bulk",
+                kernel_parameters,
+                landscape,
+                many_dispersers,
+                [&]() {
+                    return SampleOnlyKernel<AliasDispersalKernel>(create_kernel());
+                });
+        }
+    }
+
+    // Kernel as constructed by Model (natural and anthropogenic kernel).
+    auto combined_parameters = reported;
+    combined_parameters.emplace_back("kernel", "cauchy+cauchy");
+    run_disperse(
+        runner,
+        "disperse_natural_anthropogenic",
+        combined_parameters,
+        landscape,
+        dispersers,
+        [&]() {
+            RadialDispersalKernel<Raster<int>> natural_radial(
+                resolution, resolution, DispersalKernelType::Cauchy, scale);
+            RadialDispersalKernel<Raster<int>> anthro_radial(
+                resolution, resolution, DispersalKernelType::Cauchy, 20 * scale);
+            DeterministicDispersalKernel<Raster<int>> deterministic(
+                DispersalKernelType::None,
+                dispersers,
+                0.99,
+                resolution,
+                resolution,
+                scale);
+            UniformDispersalKernel uniform(rows - 1, cols - 1);
+            SwitchDispersalKernel<Raster<int>> natural(
+                DispersalKernelType::Cauchy, natural_radial, deterministic, uniform);
+            SwitchDispersalKernel<Raster<int>> anthro(
+                DispersalKernelType::Cauchy, anthro_radial, deterministic, uniform);
+            return DispersalKernel<Raster<int>>(natural, anthro, true, 0.9);
+        });
+
+    // Same dispersal with row-major and tiled storage, both going through
+    // the cells tile by tile.
+    auto tiled_cells = tile_ordered_cells(landscape.suitable_cells);
+    auto layout_parameters = reported;
+    layout_parameters.emplace_back("kernel", "cauchy");
+    layout_parameters.emplace_back("cell_order", "tiles");
+    layout_parameters.emplace_back("layout", "row-major");
+    runner.run("disperse_layout", layout_parameters, [&](BenchmarkTimer& timer) {
+        Simulation<Raster<int>, Raster<double>> simulation(42, rows, cols);
+        auto susceptible = landscape.susceptible;
+        auto infected = landscape.infected;
+        Raster<int> mortality_tracker(rows, cols, 0);
+        std::vector<std::tuple<int, int>> outside_dispersers;
+        RadialDispersalKernel<Raster<int>> kernel(
+            resolution, resolution, DispersalKernelType::Cauchy, scale);
+        timer.start();
+        simulation.disperse(
+            dispersers,
+            susceptible,
+            infected,
+            mortality_tracker,
+            landscape.total_hosts,
+            outside_dispersers,
+            true,
+            landscape.weather_coefficient,
+            kernel,
+            tiled_cells);
+        timer.stop();
+        timer.checksum = raster_sum(infected) + outside_dispersers.size();
+    });
+    typedef TiledRaster<int> IntTiles;
+    typedef TiledRaster<double> FloatTiles;
+    IntTiles tiled_dispersers(dispersers);
+    IntTiles tiled_total_hosts(landscape.total_hosts);
+    FloatTiles tiled_weather(landscape.weather_coefficient);
+    layout_parameters.back().second = "tiled";
+    runner.run("disperse_layout", layout_parameters, [&](BenchmarkTimer& timer) {
+        Simulation<IntTiles, FloatTiles> simulation(42, rows, cols);
+        IntTiles susceptible(landscape.susceptible);
+        IntTiles infected(landscape.infected);
+        IntTiles mortality_tracker(rows, cols);
+        std::vector<std::tuple<int, int>> outside_dispersers;
+        RadialDispersalKernel<IntTiles> kernel(
+            resolution, resolution, DispersalKernelType::Cauchy, scale);
+        timer.start();
+        simulation.disperse(
+            tiled_dispersers,
+            susceptible,
+            infected,
+            mortality_tracker,
+            tiled_total_hosts,
+            outside_dispersers,
+            true,
+            tiled_weather,
+            kernel,
+            tiled_cells);
+        timer.stop();
+        timer.checksum = raster_sum(infected) + outside_dispersers.size();
+    });
+    return 0;
+}
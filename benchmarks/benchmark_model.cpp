@@ -0,0 +1,231 @@
+/*
+ * PoPS model - benchmarks for the Model class
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "benchmark.hpp"
+#include "landscape.hpp"
+
+#include <pops/model.hpp>
+#include <pops/raster.hpp>
+
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace pops;
+
+/*! Configuration shared by all model benchmarks (monthly steps for two years)
+ */
+Config create_config(int rows, int cols)
+{
+    Config config;
+    config.random_seed = 42;
+    config.rows = rows;
+    config.cols = cols;
+    config.ew_res = 30;
+    config.ns_res = 30;
+    config.weather = true;
+    config.reproductive_rate = 0.5;
+    config.model_type = "SI";
+    config.latency_period_steps = 0;
+    config.natural_kernel_type = "cauchy";
+    config.natural_scale = 30;
+    config.natural_direction = "none";
+    config.natural_kappa = 0;
+    config.use_anthropogenic_kernel = true;
+    config.percent_natural_dispersal = 0.95;
+    config.anthro_kernel_type = "cauchy";
+    config.anthro_scale = 1000;
+    config.anthro_direction = "none";
+    config.anthro_kappa = 0;
+    config.use_spreadrates = false;
+    config.output_frequency = "year";
+    config.output_frequency_n = 1;
+    config.set_date_start(2020, 1, 1);
+    config.set_date_end(2021, 12, 31);
+    config.set_step_unit(StepUnit::Month);
+    config.set_step_num_units(1);
+    return config;
+}
+
+/*! Run all steps of a simulation with the given configuration
+ */
+void run_model(
+    BenchmarkRunner& runner,
+    const std::string& name,
+    const BenchmarkParameters& parameters,
+    const SyntheticLandscape& landscape,
+    Config config,
+    const std::vector<std::vector<int>>& movements)
+{
+    int rows = landscape.infected.rows();
+    int cols = landscape.infected.cols();
+    config.create_schedules();
+    unsigned num_steps = config.scheduler().get_num_steps();
+    auto model_parameters = parameters;
+    model_parameters.emplace_back("steps", to_text(num_steps));
+    // Quarantine areas are the left half of the landscape.
+    Raster<int> quarantine_areas(rows, cols, 0);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols / 2; ++j)
+            quarantine_areas(i, j) = 1;
+    runner.run(name, model_parameters, [&](BenchmarkTimer& timer) {
+        auto infected = landscape.infected;
+        auto susceptible = landscape.susceptible;
+        auto total_hosts = landscape.total_hosts;
+        Raster<int> dispersers(rows, cols, 0);
+        Raster<int> resistant(rows, cols, 0);
+        Raster<int> died(rows, cols, 0);
+        std::vector<Raster<int>> exposed(
+            config.latency_period_steps + 1, Raster<int>(rows, cols, 0));
+        std::vector<Raster<int>> mortality_tracker(
+            config.num_mortality_years(), Raster<int>(rows, cols, 0));
+        std::vector<Raster<double>> temperatures(
+            config.scheduler().get_num_steps(), landscape.temperature);
+        std::vector<std::tuple<int, int>> outside_dispersers;
+        Treatments<Raster<int>, Raster<double>> treatments(config.scheduler());
+        if (config.use_treatments) {
+            Raster<double> treatment_map(rows, cols, 0);
+            for (int i = rows / 4; i < rows / 2; ++i)
+                for (int j = cols / 4; j < cols / 2; ++j)
+                    treatment_map(i, j) = 1;
+            treatments.add_treatment(
+                treatment_map, Date(2020, 6, 1), 0, TreatmentApplication::Ratio);
+            treatments.add_treatment(
+                treatment_map, Date(2021, 3, 1), 60, TreatmentApplication::Ratio);
+        }
+        unsigned rate_num_steps = config.use_spreadrates ? config.rate_num_steps() : 0;
+        unsigned quarantine_num_steps =
+            config.use_quarantine ? config.quarantine_num_steps() : 0;
+        SpreadRate<Raster<int>> spread_rate(
+            infected,
+            config.ew_res,
+            config.ns_res,
+            rate_num_steps,
+            landscape.suitable_cells);
+        QuarantineEscape<Raster<int>> quarantine(
+            quarantine_areas,
+            config.ew_res,
+            config.ns_res,
+            quarantine_num_steps,
+            landscape.suitable_cells);
+        timer.start();
+        Model<Raster<int>, Raster<double>, Raster<double>::IndexType> model(config);
+        for (unsigned step = 0; step < num_steps; ++step) {
+            model.run_step(
+                step,
+                infected,
+                susceptible,
+                total_hosts,
+                dispersers,
+                exposed,
+                mortality_tracker,
+                died,
+                temperatures,
+                landscape.weather_coefficient,
+                treatments,
+                resistant,
+                outside_dispersers,
+                spread_rate,
+                quarantine,
+                quarantine_areas,
+                movements,
+                landscape.suitable_cells);
+        }
+        timer.stop();
+        timer.checksum = raster_sum(infected) + outside_dispersers.size();
+    });
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkRunner runner(argc, argv, "model");
+    auto parameters = landscape_parameters(runner);
+    auto landscape = generate_landscape(parameters);
+    int rows = landscape.infected.rows();
+    int cols = landscape.infected.cols();
+    auto reported = benchmark_parameters(parameters);
+    std::vector<std::vector<int>> no_movements;
+
+    auto si_parameters = reported;
+    si_parameters.emplace_back("model_type", "SI");
+    run_model(
+        runner,
+        "run_step",
+        si_parameters,
+        landscape,
+        create_config(rows, cols),
+        no_movements);
+
+    Config sei_config = create_config(rows, cols);
+    sei_config.model_type = "SEI";
+    sei_config.latency_period_steps = 8;
+    auto sei_parameters = reported;
+    sei_parameters.emplace_back("model_type", "SEI");
+    run_model(runner, "run_step", sei_parameters, landscape, sei_config, no_movements);
+
+    Config deterministic_config = create_config(rows, cols);
+    deterministic_config.generate_stochasticity = false;
+    deterministic_config.establishment_stochasticity = false;
+    deterministic_config.establishment_probability = 0.5;
+    deterministic_config.deterministic = true;
+    deterministic_config.use_anthropogenic_kernel = false;
+    auto deterministic_parameters = reported;
+    deterministic_parameters.emplace_back("model_type", "SI");
+    deterministic_parameters.emplace_back("deterministic", "true");
+    run_model(
+        runner,
+        "run_step",
+        deterministic_parameters,
+        landscape,
+        deterministic_config,
+        no_movements);
+
+    // Most of the optional features together.
+    Config full_config = create_config(rows, cols);
+    full_config.use_lethal_temperature = true;
+    full_config.lethal_temperature = -15;
+    full_config.lethal_temperature_month = 1;
+    full_config.use_mortality = true;
+    full_config.mortality_rate = 0.1;
+    full_config.first_mortality_year = 1;
+    full_config.use_treatments = true;
+    full_config.use_spreadrates = true;
+    full_config.spreadrate_frequency = "month";
+    full_config.spreadrate_frequency_n = 1;
+    full_config.use_quarantine = true;
+    full_config.quarantine_frequency = "month";
+    full_config.quarantine_frequency_n = 1;
+    full_config.use_overpopulation_movements = true;
+    full_config.overpopulation_percentage = 0.75;
+    full_config.leaving_percentage = 0.5;
+    full_config.use_movements = true;
+    std::vector<std::vector<int>> movements;
+    std::default_random_engine generator(1);
+    std::uniform_int_distribution<size_t> cell_distribution(
+        0, landscape.suitable_cells.size() - 1);
+    unsigned num_movements = 10000;
+    for (unsigned i = 0; i < num_movements; ++i) {
+        const auto& from = landscape.suitable_cells[cell_distribution(generator)];
+        const auto& to = landscape.suitable_cells[cell_distribution(generator)];
+        movements.push_back({from[0], from[1], to[0], to[1], 5});
+        // 24 monthly steps in two years
+        full_config.movement_schedule.push_back(i * 24 / num_movements);
+    }
+    auto full_parameters = reported;
+    full_parameters.emplace_back("model_type", "SI");
+    full_parameters.emplace_back("features", "all");
+    full_parameters.emplace_back("movements", to_text(num_movements));
+    run_model(runner, "run_step", full_parameters, landscape, full_config, movements);
+    return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * PoPS model - benchmarks for quarantine escape computation
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "benchmark.hpp"
+#include "landscape.hpp"
+
+#include <pops/quarantine.hpp>
+#include <pops/raster.hpp>
+
+#include <vector>
+
+using namespace pops;
+
+/*! Quarantine areas forming a grid of *zones* by *zones* rectangles
+ *
+ * The areas cover the whole landscape, so the infection never escapes
+ * and all infected cells are always evaluated.
+ */
+Raster<int> create_quarantine_areas(int rows, int cols, int zones)
+{
+    Raster<int> areas(rows, cols, 0);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            areas(i, j) = 1 + (i * zones / rows) * zones + (j * zones / cols);
+    return areas;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkRunner runner(argc, argv, "quarantine");
+    auto parameters = landscape_parameters(runner);
+    auto landscape = generate_landscape(parameters);
+    int rows = landscape.infected.rows();
+    int cols = landscape.infected.cols();
+    auto reported = benchmark_parameters(parameters);
+    unsigned num_steps = 20;
+
+    for (int zones : {1, 4, 16}) {
+        auto areas = create_quarantine_areas(rows, cols, zones);
+        auto zone_parameters = reported;
+        zone_parameters.emplace_back("zones", to_text(zones * zones));
+        zone_parameters.emplace_back("steps", to_text(num_steps));
+        runner.run("construct", zone_parameters, [&](BenchmarkTimer& timer) {
+            timer.start();
+            QuarantineEscape<Raster<int>> quarantine(
+                areas, 30, 30, num_steps, landscape.suitable_cells);
+            timer.stop();
+            timer.checksum = quarantine.escaped(0);
+        });
+        runner.run(
+            "infection_escape_quarantine", zone_parameters, [&](BenchmarkTimer& timer) {
+                QuarantineEscape<Raster<int>> quarantine(
+                    areas, 30, 30, num_steps, landscape.suitable_cells);
+                timer.start();
+                for (unsigned step = 0; step < num_steps; ++step)
+                    quarantine.infection_escape_quarantine(
+                        landscape.infected, areas, step, landscape.suitable_cells);
+                timer.stop();
+                timer.checksum = quarantine.distance(num_steps - 1);
+            });
+        runner.run("construct_boundary", zone_parameters, [&](BenchmarkTimer& timer) {
+            timer.start();
+            QuarantineEscape<Raster<int>> quarantine(
+                areas,
+                30,
+                30,
+                num_steps,
+                landscape.suitable_cells,
+                QuarantineDistance::Boundary);
+            timer.stop();
+            timer.checksum = quarantine.escaped(0);
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * PoPS model - benchmarks for creating schedules
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "benchmark.hpp"
+
+#include <pops/config.hpp>
+#include <pops/date.hpp>
+#include <pops/scheduling.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using namespace pops;
+
+int main(int argc, char** argv)
+{
+    BenchmarkRunner runner(argc, argv, "scheduling");
+
+    for (int num_years : {10, 100}) {
+        BenchmarkParameters reported;
+        reported.emplace_back("years", to_text(num_years));
+        Date start(2000, 1, 1);
+        Date end(2000 + num_years - 1, 12, 31);
+        // Schedules created by Config::create_schedules() for a daily simulation.
+        runner.run("create_daily_schedules", reported, [&](BenchmarkTimer& timer) {
+            timer.start();
+            Scheduler scheduler(start, end, StepUnit::Day, 1);
+            auto spread = scheduler.schedule_spread(Season(3, 10));
+            auto lethal = scheduler.schedule_action_yearly(1, 1);
+            auto mortality = scheduler.schedule_action_end_of_year();
+            auto output = schedule_from_string(scheduler, "month");
+            unsigned treatment = scheduler.schedule_action_date(Date(2000, 6, 1));
+            timer.stop();
+            timer.checksum = std::count(spread.begin(), spread.end(), true)
+                             + std::count(lethal.begin(), lethal.end(), true)
+                             + std::count(mortality.begin(), mortality.end(), true)
+                             + std::count(output.begin(), output.end(), true)
+                             + treatment;
+        });
+        // Ensemble of configurations which differ only in model parameters
+        runner.run("create_ensemble_schedules", reported, [&](BenchmarkTimer& timer) {
+            unsigned num_configs = 1000;
+            std::vector<Config> configs(num_configs);
+            timer.start();
+            for (unsigned i = 0; i < num_configs; ++i) {
+                Config& config = configs[i];
+                config.reproductive_rate = 1 + 0.001 * i;
+                config.output_frequency = "year";
+                config.use_spreadrates = false;
+                config.set_date_start(start);
+                config.set_date_end(end);
+                config.set_step_unit(StepUnit::Week);
+                config.create_schedules();
+            }
+            timer.stop();
+            timer.checksum = configs.back().scheduler().get_num_steps();
+        });
+        runner.run("add_days", reported, [&](BenchmarkTimer& timer) {
+            Date date(start);
+            timer.start();
+            for (int year = 0; year < num_years; ++year)
+                date.add_days(365);
+            timer.stop();
+            timer.checksum = date.year();
+        });
+    }
+    return 0;
+}
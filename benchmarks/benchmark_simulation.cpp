@@ -0,0 +1,354 @@
+/*
+ * PoPS model - benchmarks for the Simulation class
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "benchmark.hpp"
+#include "landscape.hpp"
+
+#include <pops/lethal_temperature.hpp>
+#include <pops/movements.hpp>
+#include <pops/radial_kernel.hpp>
+#include <pops/raster.hpp>
+#include <pops/simulation.hpp>
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace pops;
+
+/*! Create random movements between host cells
+ *
+ * Movements are spread evenly over *num_steps* steps.
+ */
+void create_movements(
+    const SyntheticLandscape& landscape,
+    unsigned num_movements,
+    unsigned num_steps,
+    std::vector<std::vector<int>>& movements,
+    std::vector<unsigned>& movement_schedule)
+{
+    std::default_random_engine generator(1);
+    std::uniform_int_distribution<size_t> cell_distribution(
+        0, landscape.suitable_cells.size() - 1);
+    std::uniform_int_distribution<int> hosts_distribution(1, 20);
+    for (unsigned i = 0; i < num_movements; ++i) {
+        const auto& from = landscape.suitable_cells[cell_distribution(generator)];
+        const auto& to = landscape.suitable_cells[cell_distribution(generator)];
+        movements.push_back(
+            {from[0], from[1], to[0], to[1], hosts_distribution(generator)});
+        movement_schedule.push_back(i * num_steps / num_movements);
+    }
+}
+
+/*! Run SEI steps with exposed hosts stored in *exposed*
+ *
+ * The same dispersers are used in each step. Returns the number of infected
+ * hosts at the end.
+ */
+template<typename Exposed>
+double run_sei_steps(
+    const SyntheticLandscape& landscape,
+    const Raster<int>& dispersers,
+    unsigned latency_period,
+    unsigned num_steps,
+    Exposed& exposed)
+{
+    int rows = landscape.infected.rows();
+    int cols = landscape.infected.cols();
+    Simulation<Raster<int>, Raster<double>> simulation(
+        42, rows, cols, ModelType::SusceptibleExposedInfected, latency_period);
+    RadialDispersalKernel<Raster<int>> kernel(
+        30, 30, DispersalKernelType::Exponential, 50);
+    auto susceptible = landscape.susceptible;
+    auto infected = landscape.infected;
+    Raster<int> mortality_tracker(rows, cols);
+    mortality_tracker.zero();
+    std::vector<std::tuple<int, int>> outside_dispersers;
+    for (unsigned step = 0; step < num_steps; ++step) {
+        simulation.disperse_and_infect(
+            step,
+            dispersers,
+            susceptible,
+            exposed,
+            infected,
+            mortality_tracker,
+            landscape.total_hosts,
+            outside_dispersers,
+            true,
+            landscape.weather_coefficient,
+            kernel,
+            landscape.suitable_cells);
+    }
+    return raster_sum(infected);
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkRunner runner(argc, argv, "simulation");
+    auto parameters = landscape_parameters(runner);
+    auto landscape = generate_landscape(parameters);
+    int rows = landscape.infected.rows();
+    int cols = landscape.infected.cols();
+    auto reported = benchmark_parameters(parameters);
+
+    runner.run("generate", reported, [&](BenchmarkTimer& timer) {
+        Simulation<Raster<int>, Raster<double>> simulation(42, rows, cols);
+        Raster<int> dispersers(rows, cols, 0);
+        timer.start();
+        simulation.generate(
+            dispersers,
+            landscape.infected,
+            true,
+            landscape.weather_coefficient,
+            4.4,
+            landscape.suitable_cells);
+        timer.stop();
+        timer.checksum = raster_sum(dispersers);
+    });
+
+    runner.run("generate_deterministic", reported, [&](BenchmarkTimer& timer) {
+        Simulation<Raster<int>, Raster<double>> simulation(
+            42, rows, cols, ModelType::SusceptibleInfected, 0, false);
+        Raster<int> dispersers(rows, cols, 0);
+        timer.start();
+        simulation.generate(
+            dispersers,
+            landscape.infected,
+            true,
+            landscape.weather_coefficient,
+            4.4,
+            landscape.suitable_cells);
+        timer.stop();
+        timer.checksum = raster_sum(dispersers);
+    });
+
+    runner.run("remove_lethal_temperature", reported, [&](BenchmarkTimer& timer) {
+        Simulation<Raster<int>, Raster<double>> simulation(42, rows, cols);
+        auto infected = landscape.infected;
+        auto susceptible = landscape.susceptible;
+        timer.start();
+        simulation.remove(
+            infected,
+            susceptible,
+            landscape.temperature,
+            -10,
+            landscape.suitable_cells);
+        timer.stop();
+        timer.checksum = raster_sum(infected);
+    });
+
+    // Cells with lethal temperature are found once and shared by all runs.
+    std::vector<Raster<double>> temperatures(1, landscape.temperature);
+    runner.run("lethal_temperature_cells", reported, [&](BenchmarkTimer& timer) {
+        timer.start();
+        LethalTemperatureCells cells(temperatures, -10, landscape.suitable_cells);
+        timer.stop();
+        timer.checksum = cells[0].size();
+    });
+    LethalTemperatureCells lethal_cells(temperatures, -10, landscape.suitable_cells);
+    runner.run("remove_lethal_cells", reported, [&](BenchmarkTimer& timer) {
+        Simulation<Raster<int>, Raster<double>> simulation(42, rows, cols);
+        auto infected = landscape.infected;
+        auto susceptible = landscape.susceptible;
+        timer.start();
+        simulation.remove(infected, susceptible, lethal_cells[0]);
+        timer.stop();
+        timer.checksum = raster_sum(infected);
+    });
+
+    runner.run("mortality", reported, [&](BenchmarkTimer& timer) {
+        Simulation<Raster<int>, Raster<double>> simulation(42, rows, cols);
+        auto infected = landscape.infected;
+        std::vector<Raster<int>> mortality_tracker(10, landscape.infected);
+        Raster<int> died(rows, cols, 0);
+        timer.start();
+        simulation.mortality(
+            infected, 0.05, 9, 0, died, mortality_tracker, landscape.suitable_cells);
+        timer.stop();
+        timer.checksum = raster_sum(died);
+    });
+
+    unsigned num_steps = 50;
+    for (unsigned num_movements : {1000u, 100000u}) {
+        std::vector<std::vector<int>> movements;
+        std::vector<unsigned> movement_schedule;
+        create_movements(
+            landscape, num_movements, num_steps, movements, movement_schedule);
+        auto movement_parameters = reported;
+        movement_parameters.emplace_back("movements", to_text(num_movements));
+        movement_parameters.emplace_back("steps", to_text(num_steps));
+        runner.run("movement", movement_parameters, [&](BenchmarkTimer& timer) {
+            Simulation<Raster<int>, Raster<double>> simulation(42, rows, cols);
+            auto infected = landscape.infected;
+            auto susceptible = landscape.susceptible;
+            auto total_hosts = landscape.total_hosts;
+            Raster<int> mortality_tracker(rows, cols, 0);
+            unsigned last_index = 0;
+            timer.start();
+            for (unsigned step = 0; step < num_steps; ++step) {
+                last_index = simulation.movement(
+                    infected,
+                    susceptible,
+                    mortality_tracker,
+                    total_hosts,
+                    step,
+                    last_index,
+                    movements,
+                    movement_schedule);
+            }
+            timer.stop();
+            timer.checksum = raster_sum(infected);
+        });
+        runner.run("movement_table", movement_parameters, [&](BenchmarkTimer& timer) {
+            Simulation<Raster<int>, Raster<double>> simulation(42, rows, cols);
+            auto infected = landscape.infected;
+            auto susceptible = landscape.susceptible;
+            auto total_hosts = landscape.total_hosts;
+            Raster<int> mortality_tracker(rows, cols, 0);
+            timer.start();
+            MovementTable<int> table(movements, movement_schedule);
+            for (unsigned step = 0; step < num_steps; ++step) {
+                simulation.movement(
+                    infected, susceptible, mortality_tracker, total_hosts, step, table);
+            }
+            timer.stop();
+            timer.checksum = raster_sum(infected);
+        });
+        MovementTable<int> table(movements, movement_schedule);
+        for (unsigned num_threads : {1u, 4u}) {
+            auto batched_parameters = movement_parameters;
+            batched_parameters.emplace_back("threads", to_text(num_threads));
+            runner.run(
+                "batched_movement", batched_parameters, [&](BenchmarkTimer& timer) {
+                    Simulation<Raster<int>, Raster<double>> simulation(42, rows, cols);
+                    auto infected = landscape.infected;
+                    auto susceptible = landscape.susceptible;
+                    auto total_hosts = landscape.total_hosts;
+                    Raster<int> mortality_tracker(rows, cols, 0);
+                    timer.start();
+                    for (unsigned step = 0; step < num_steps; ++step) {
+                        simulation.batched_movement(
+                            infected,
+                            susceptible,
+                            mortality_tracker,
+                            total_hosts,
+                            step,
+                            table,
+                            num_threads);
+                    }
+                    timer.stop();
+                    timer.checksum = raster_sum(infected);
+                });
+        }
+    }
+
+    // Establishment interleaved with dispersal and after all dispersal
+    // (with weather, so that two-phase establishment applies it to arrivals).
+    Raster<int> dispersers(rows, cols, 0);
+    Simulation<Raster<int>, Raster<double>> generating_simulation(42, rows, cols);
+    generating_simulation.generate(
+        dispersers,
+        landscape.infected,
+        true,
+        landscape.weather_coefficient,
+        4.4,
+        landscape.suitable_cells);
+    for (bool two_phase : {false, true}) {
+        auto establishment_parameters = reported;
+        establishment_parameters.emplace_back("two_phase", two_phase ? "yes" : "no");
+        runner.run(
+            "disperse_establishment",
+            establishment_parameters,
+            [&](BenchmarkTimer& timer) {
+                Simulation<Raster<int>, Raster<double>> simulation(
+                    42,
+                    rows,
+                    cols,
+                    ModelType::SusceptibleInfected,
+                    0,
+                    true,
+                    true,
+                    true,
+                    two_phase);
+                RadialDispersalKernel<Raster<int>> kernel(
+                    30, 30, DispersalKernelType::Exponential, 50);
+                auto susceptible = landscape.susceptible;
+                auto infected = landscape.infected;
+                Raster<int> mortality_tracker(rows, cols, 0);
+                std::vector<std::tuple<int, int>> outside_dispersers;
+                timer.start();
+                simulation.disperse(
+                    dispersers,
+                    susceptible,
+                    infected,
+                    mortality_tracker,
+                    landscape.total_hosts,
+                    outside_dispersers,
+                    true,
+                    landscape.weather_coefficient,
+                    kernel,
+                    landscape.suitable_cells);
+                timer.stop();
+                timer.checksum = raster_sum(infected);
+            });
+    }
+
+    // SEI steps with exposed hosts stored as full rasters or as cohorts of cells.
+    // Only few hosts are exposed in each step (one disperser from every
+    // hundredth cell), so the storage of exposed hosts is a large part
+    // of the work.
+    unsigned latency_period = 52;
+    unsigned num_sei_steps = 60;
+    Raster<int> sparse_dispersers(rows, cols);
+    sparse_dispersers.zero();
+    for (std::size_t i = 0; i < landscape.suitable_cells.size(); i += 100) {
+        const auto& cell = landscape.suitable_cells[i];
+        sparse_dispersers(cell[0], cell[1]) = 1;
+    }
+    for (bool cohorts : {false, true}) {
+        auto sei_parameters = reported;
+        sei_parameters.emplace_back("latency_period", std::to_string(latency_period));
+        sei_parameters.emplace_back("steps", std::to_string(num_sei_steps));
+        sei_parameters.emplace_back("exposed", cohorts ? "cohorts" : "rasters");
+        runner.run(
+            "disperse_and_infect_sei",
+            sei_parameters,
+            [&](BenchmarkTimer& timer) {
+                timer.start();
+                if (cohorts) {
+                    ExposedCohorts exposed(rows, cols, latency_period);
+                    timer.checksum = run_sei_steps(
+                        landscape,
+                        sparse_dispersers,
+                        latency_period,
+                        num_sei_steps,
+                        exposed);
+                }
+                else {
+                    Raster<int> zeros(rows, cols);
+                    zeros.zero();
+                    std::vector<Raster<int>> exposed(latency_period + 1, zeros);
+                    timer.checksum = run_sei_steps(
+                        landscape,
+                        sparse_dispersers,
+                        latency_period,
+                        num_sei_steps,
+                        exposed);
+                }
+                timer.stop();
+            });
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * PoPS model - benchmarks for spread rate computation
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "benchmark.hpp"
+#include "landscape.hpp"
+
+#include <pops/raster.hpp>
+#include <pops/spread_rate.hpp>
+
+#include <tuple>
+#include <vector>
+
+using namespace pops;
+
+int main(int argc, char** argv)
+{
+    BenchmarkRunner runner(argc, argv, "spread_rate");
+    auto parameters = landscape_parameters(runner);
+
+    for (double infected_fraction : {0.001, 0.05, 0.5}) {
+        parameters.infected_fraction = infected_fraction;
+        auto landscape = generate_landscape(parameters);
+        auto reported = benchmark_parameters(parameters);
+        unsigned num_steps = 20;
+        reported.emplace_back("steps", to_text(num_steps));
+        runner.run("compute_step_spread_rate", reported, [&](BenchmarkTimer& timer) {
+            timer.start();
+            SpreadRate<Raster<int>> spread_rate(
+                landscape.infected, 30, 30, num_steps, landscape.suitable_cells);
+            for (unsigned step = 0; step < num_steps; ++step)
+                spread_rate.compute_step_spread_rate(
+                    landscape.infected, step, landscape.suitable_cells);
+            timer.stop();
+            double north, south, east, west;
+            std::tie(north, south, east, west) = spread_rate.step_rate(0);
+            timer.checksum = north + south + east + west;
+        });
+        // Infection of one cell changes in each step, so the extent is updated
+        // only for that cell.
+        runner.run(
+            "compute_step_spread_rate_incremental",
+            reported,
+            [&](BenchmarkTimer& timer) {
+                InfectionExtent extent(landscape.infected, landscape.suitable_cells);
+                timer.start();
+                SpreadRate<Raster<int>> spread_rate(extent, 30, 30, num_steps);
+                for (unsigned step = 0; step < num_steps; ++step) {
+                    const auto& cell = landscape.suitable_cells
+                        [step % landscape.suitable_cells.size()];
+                    extent.update(cell[0], cell[1], 1);
+                    spread_rate.compute_step_spread_rate(extent, step);
+                }
+                timer.stop();
+                double north, south, east, west;
+                std::tie(north, south, east, west) = spread_rate.step_rate(0);
+                timer.checksum = north + south + east + west;
+            });
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+/*
+ * PoPS model - benchmarks for treatments
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#include "benchmark.hpp"
+#include "landscape.hpp"
+
+#include <pops/date.hpp>
+#include <pops/raster.hpp>
+#include <pops/scheduling.hpp>
+#include <pops/treatments.hpp>
+
+#include <cmath>
+#include <vector>
+
+using namespace pops;
+
+/*! Treatment map covering a square in the middle of the landscape
+ *
+ * The square covers *coverage* fraction of the area.
+ */
+Raster<double> create_treatment_map(int rows, int cols, double coverage)
+{
+    Raster<double> map(rows, cols, 0);
+    int size_rows = std::sqrt(coverage) * rows;
+    int size_cols = std::sqrt(coverage) * cols;
+    int top = (rows - size_rows) / 2;
+    int left = (cols - size_cols) / 2;
+    for (int i = top; i < top + size_rows; ++i)
+        for (int j = left; j < left + size_cols; ++j)
+            map(i, j) = 0.8;
+    return map;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkRunner runner(argc, argv, "treatments");
+    auto parameters = landscape_parameters(runner);
+    auto landscape = generate_landscape(parameters);
+    int rows = landscape.infected.rows();
+    int cols = landscape.infected.cols();
+    auto reported = benchmark_parameters(parameters);
+
+    // Weekly steps over ten years.
+    Scheduler scheduler(Date(2020, 1, 1), Date(2029, 12, 31), StepUnit::Week, 1);
+    unsigned num_steps = scheduler.get_num_steps();
+
+    for (double coverage : {0.01, 0.25}) {
+        for (int num_treatments : {1, 20}) {
+            for (int num_days : {0, 30}) {
+                auto map = create_treatment_map(rows, cols, coverage);
+                auto treatment_parameters = reported;
+                treatment_parameters.emplace_back("coverage", to_text(coverage));
+                treatment_parameters.emplace_back(
+                    "treatments", to_text(num_treatments));
+                treatment_parameters.emplace_back("days", to_text(num_days));
+                treatment_parameters.emplace_back("steps", to_text(num_steps));
+                runner.run("manage", treatment_parameters, [&](BenchmarkTimer& timer) {
+                    auto infected = landscape.infected;
+                    auto susceptible = landscape.susceptible;
+                    Raster<int> resistant(rows, cols, 0);
+                    std::vector<Raster<int>> exposed;
+                    timer.start();
+                    Treatments<Raster<int>, Raster<double>> treatments(scheduler);
+                    for (int i = 0; i < num_treatments; ++i) {
+                        Date date(2020 + i % 10, 1 + (i * 5) % 12, 1);
+                        treatments.add_treatment(
+                            map, date, num_days, TreatmentApplication::Ratio);
+                    }
+                    for (unsigned step = 0; step < num_steps; ++step) {
+                        treatments.manage(
+                            step,
+                            infected,
+                            exposed,
+                            susceptible,
+                            resistant,
+                            landscape.suitable_cells);
+                    }
+                    timer.stop();
+                    timer.checksum = raster_sum(infected) + raster_sum(susceptible);
+                });
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,224 @@
+/*
+ * PoPS model - synthetic landscape generator for benchmarks
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_BENCHMARK_LANDSCAPE_HPP
+#define POPS_BENCHMARK_LANDSCAPE_HPP
+
+#include "benchmark.hpp"
+
+#include <pops/raster.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+/*! Parameters of a synthetic landscape
+ *
+ * *host_density* is the fraction of cells which contain hosts,
+ * *infected_fraction* is the fraction of host cells which are infected,
+ * and *clustering* goes from 0 (cells are selected independently at random)
+ * to 1 (hosts and infection form large contiguous patches).
+ */
+struct LandscapeParameters
+{
+    int rows{500};
+    int cols{500};
+    double host_density{0.6};
+    int max_hosts{100};
+    double infected_fraction{0.05};
+    double clustering{0.5};
+    unsigned seed{42};
+};
+
+/*! Default landscape parameters with size taken from the command line
+ */
+inline LandscapeParameters landscape_parameters(const BenchmarkRunner& runner)
+{
+    LandscapeParameters parameters;
+    parameters.rows = runner.rows();
+    parameters.cols = runner.cols();
+    return parameters;
+}
+
+/*! Synthetic landscape with all the rasters needed to run a simulation
+ *
+ * The rasters can be copied to get a fresh state for each benchmark
+ * repetition.
+ */
+struct SyntheticLandscape
+{
+    pops::Raster<int> total_hosts;
+    pops::Raster<int> susceptible;
+    pops::Raster<int> infected;
+    pops::Raster<double> weather_coefficient;
+    pops::Raster<double> temperature;
+    std::vector<std::vector<int>> suitable_cells;
+};
+
+/*! Smooth random field with values between 0 and 1
+ *
+ * White noise is smoothed by repeated box blur (approximating a Gaussian
+ * filter). The blur radius grows with *clustering*, so that higher
+ * clustering gives larger patches.
+ */
+template<typename Generator>
+pops::Raster<double>
+smooth_random_field(int rows, int cols, double clustering, Generator& generator)
+{
+    std::uniform_real_distribution<double> uniform(0, 1);
+    pops::Raster<double> field(rows, cols);
+    field.for_each([&uniform, &generator](double& value) {
+        value = uniform(generator);
+    });
+    int radius = std::round(clustering * std::min(rows, cols) / 20.0);
+    if (radius < 1)
+        return field;
+    std::vector<double> line;
+    // Three passes of box blur in each direction.
+    for (int pass = 0; pass < 3; ++pass) {
+        for (int i = 0; i < rows; ++i) {
+            line.assign(cols + 1, 0);
+            for (int j = 0; j < cols; ++j)
+                line[j + 1] = line[j] + field(i, j);
+            for (int j = 0; j < cols; ++j) {
+                int start = std::max(0, j - radius);
+                int end = std::min(cols, j + radius + 1);
+                field(i, j) = (line[end] - line[start]) / (end - start);
+            }
+        }
+        for (int j = 0; j < cols; ++j) {
+            line.assign(rows + 1, 0);
+            for (int i = 0; i < rows; ++i)
+                line[i + 1] = line[i] + field(i, j);
+            for (int i = 0; i < rows; ++i) {
+                int start = std::max(0, i - radius);
+                int end = std::min(rows, i + radius + 1);
+                field(i, j) = (line[end] - line[start]) / (end - start);
+            }
+        }
+    }
+    // Stretch the values back to the 0-1 range.
+    double min = *std::min_element(field.data(), field.data() + rows * cols);
+    double max = *std::max_element(field.data(), field.data() + rows * cols);
+    if (max > min)
+        field.for_each([min, max](double& value) {
+            value = (value - min) / (max - min);
+        });
+    return field;
+}
+
+/*! Value of a field above which there is the given fraction of cells
+ */
+inline double field_threshold(const pops::Raster<double>& field, double fraction)
+{
+    std::vector<double> values(
+        field.data(), field.data() + field.rows() * field.cols());
+    if (fraction <= 0)
+        return *std::max_element(values.begin(), values.end()) + 1;
+    if (fraction >= 1)
+        return *std::min_element(values.begin(), values.end()) - 1;
+    auto nth = values.begin() + static_cast<long>((1 - fraction) * values.size());
+    std::nth_element(values.begin(), nth, values.end());
+    return *nth;
+}
+
+/*! Generate a synthetic landscape based on the parameters
+ *
+ * The same parameters (including the seed) always give the same landscape.
+ */
+inline SyntheticLandscape generate_landscape(const LandscapeParameters& parameters)
+{
+    if (parameters.rows < 1 || parameters.cols < 1)
+        throw std::invalid_argument("Landscape must have at least one cell");
+    int rows = parameters.rows;
+    int cols = parameters.cols;
+    std::default_random_engine generator(parameters.seed);
+    std::uniform_int_distribution<int> hosts_distribution(1, parameters.max_hosts);
+    std::uniform_real_distribution<double> uniform(0, 1);
+
+    auto host_field =
+        smooth_random_field(rows, cols, parameters.clustering, generator);
+    auto infection_field =
+        smooth_random_field(rows, cols, parameters.clustering, generator);
+    auto weather_field =
+        smooth_random_field(rows, cols, parameters.clustering, generator);
+    double host_threshold = field_threshold(host_field, parameters.host_density);
+    // Infected fraction is relative to the host cells, so the threshold is
+    // computed from the infection field values in the host cells only.
+    pops::Raster<double> host_infection_field(rows, cols, -1);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            if (host_field(i, j) > host_threshold)
+                host_infection_field(i, j) = infection_field(i, j);
+    int num_host_cells = 0;
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            if (host_field(i, j) > host_threshold)
+                ++num_host_cells;
+    double infection_threshold = field_threshold(
+        host_infection_field,
+        parameters.infected_fraction * num_host_cells / (double(rows) * cols));
+
+    SyntheticLandscape landscape;
+    landscape.total_hosts = pops::Raster<int>(rows, cols, 0);
+    landscape.susceptible = pops::Raster<int>(rows, cols, 0);
+    landscape.infected = pops::Raster<int>(rows, cols, 0);
+    landscape.weather_coefficient = pops::Raster<double>(rows, cols, 0);
+    landscape.temperature = pops::Raster<double>(rows, cols, 0);
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            landscape.weather_coefficient(i, j) = weather_field(i, j);
+            // Temperatures between -20 and 10 degrees.
+            landscape.temperature(i, j) = -20 + 30 * weather_field(i, j);
+            if (host_field(i, j) <= host_threshold)
+                continue;
+            int hosts = hosts_distribution(generator);
+            int infected = 0;
+            if (host_infection_field(i, j) > infection_threshold)
+                infected = std::max(1, int(hosts * uniform(generator)));
+            landscape.total_hosts(i, j) = hosts;
+            landscape.infected(i, j) = infected;
+            landscape.susceptible(i, j) = hosts - infected;
+            landscape.suitable_cells.push_back({i, j});
+        }
+    }
+    return landscape;
+}
+
+/*! Sum of all values in a raster (for checksums)
+ */
+template<typename RasterType>
+double raster_sum(const RasterType& raster)
+{
+    double sum = 0;
+    for (int i = 0; i < raster.rows(); ++i)
+        for (int j = 0; j < raster.cols(); ++j)
+            sum += raster(i, j);
+    return sum;
+}
+
+/*! Benchmark parameters describing the landscape
+ */
+inline BenchmarkParameters benchmark_parameters(const LandscapeParameters& parameters)
+{
+    return {
+        {"rows", to_text(parameters.rows)},
+        {"cols", to_text(parameters.cols)},
+        {"host_density", to_text(parameters.host_density)},
+        {"infected_fraction", to_text(parameters.infected_fraction)},
+        {"clustering", to_text(parameters.clustering)}};
+}
+
+#endif  // POPS_BENCHMARK_LANDSCAPE_HPP
@@ -0,0 +1,221 @@
+/*
+ * PoPS model - Accuracy of simulated infection compared to observations
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_ACCURACY_HPP
+#define POPS_ACCURACY_HPP
+
+#include "distance_transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pops {
+
+/**
+ * Comparison of simulated and observed infection.
+ *
+ * Cells with value greater than zero are considered infected (present),
+ * other cells are considered not infected (absent). Simulated presence is
+ * the positive class, so e.g., false positive is a cell infected in the
+ * simulation, but not in the observation.
+ */
+struct AccuracyMetrics
+{
+    std::uint64_t true_positives{0};
+    std::uint64_t false_positives{0};
+    std::uint64_t false_negatives{0};
+    std::uint64_t true_negatives{0};
+    /** Sum of squared differences of simulated and observed counts */
+    double sum_of_squared_differences{0};
+
+    /** Number of compared cells */
+    std::uint64_t total() const
+    {
+        return true_positives + false_positives + false_negatives + true_negatives;
+    }
+
+    /**
+     * Quantity disagreement (Pontius and Millones 2011) as a proportion
+     * of compared cells, i.e., the difference in the number of infected cells
+     */
+    double quantity_disagreement() const
+    {
+        return std::abs(double(false_positives) - double(false_negatives)) / total();
+    }
+
+    /**
+     * Allocation disagreement (Pontius and Millones 2011) as a proportion
+     * of compared cells, i.e., the disagreement caused by a different location
+     * of infected cells
+     */
+    double allocation_disagreement() const
+    {
+        return 2. * std::min(false_positives, false_negatives) / total();
+    }
+
+    /**
+     * Total disagreement (sum of quantity and allocation disagreement)
+     */
+    double total_disagreement() const
+    {
+        return double(false_positives + false_negatives) / total();
+    }
+
+    /**
+     * Matthews correlation coefficient
+     *
+     * Returns zero if any of the sums in the denominator is zero,
+     * e.g., when there is no infection in the simulation.
+     */
+    double mcc() const
+    {
+        double tp = true_positives;
+        double fp = false_positives;
+        double fn = false_negatives;
+        double tn = true_negatives;
+        double denominator = (tp + fp) * (tp + fn) * (tn + fp) * (tn + fn);
+        if (denominator == 0)
+            return 0;
+        return (tp * tn - fp * fn) / std::sqrt(denominator);
+    }
+
+    /**
+     * Root mean square error of simulated counts
+     */
+    double rmse() const
+    {
+        return std::sqrt(sum_of_squared_differences / total());
+    }
+};
+
+/**
+ * Compares simulated and observed infection in suitable cells.
+ *
+ * All metrics are computed in one pass over the cells.
+ */
+template<typename SimulatedRaster, typename ObservedRaster>
+AccuracyMetrics accuracy_metrics(
+    const SimulatedRaster& simulated,
+    const ObservedRaster& observed,
+    const std::vector<std::vector<int>>& suitable_cells)
+{
+    AccuracyMetrics metrics;
+    std::uint64_t true_positives = 0;
+    std::uint64_t false_positives = 0;
+    std::uint64_t false_negatives = 0;
+    double squared_differences = 0;
+    for (const auto& indices : suitable_cells) {
+        int i = indices[0];
+        int j = indices[1];
+        bool simulated_present = simulated(i, j) > 0;
+        bool observed_present = observed(i, j) > 0;
+        true_positives += simulated_present && observed_present;
+        false_positives += simulated_present && !observed_present;
+        false_negatives += !simulated_present && observed_present;
+        double difference = double(simulated(i, j)) - double(observed(i, j));
+        squared_differences += difference * difference;
+    }
+    metrics.true_positives = true_positives;
+    metrics.false_positives = false_positives;
+    metrics.false_negatives = false_negatives;
+    metrics.true_negatives =
+        suitable_cells.size() - true_positives - false_positives - false_negatives;
+    metrics.sum_of_squared_differences = squared_differences;
+    return metrics;
+}
+
+/**
+ * Compares simulated and observed infection in all cells.
+ *
+ * The cells are accessed directly through Raster::data() in one branchless
+ * loop which the compiler can vectorize.
+ */
+template<typename SimulatedRaster, typename ObservedRaster>
+AccuracyMetrics
+accuracy_metrics(const SimulatedRaster& simulated, const ObservedRaster& observed)
+{
+    AccuracyMetrics metrics;
+    std::size_t size = std::size_t(simulated.rows()) * simulated.cols();
+    const auto* simulated_data = simulated.data();
+    const auto* observed_data = observed.data();
+    std::uint64_t true_positives = 0;
+    std::uint64_t false_positives = 0;
+    std::uint64_t false_negatives = 0;
+    double squared_differences = 0;
+    for (std::size_t index = 0; index < size; ++index) {
+        bool simulated_present = simulated_data[index] > 0;
+        bool observed_present = observed_data[index] > 0;
+        true_positives += simulated_present & observed_present;
+        false_positives += simulated_present & !observed_present;
+        false_negatives += !simulated_present & observed_present;
+        double difference =
+            double(simulated_data[index]) - double(observed_data[index]);
+        squared_differences += difference * difference;
+    }
+    metrics.true_positives = true_positives;
+    metrics.false_positives = false_positives;
+    metrics.false_negatives = false_negatives;
+    metrics.true_negatives = size - true_positives - false_positives - false_negatives;
+    metrics.sum_of_squared_differences = squared_differences;
+    return metrics;
+}
+
+/**
+ * Computes mean distance from infected cells in *from* to the nearest
+ * infected cell in *to* (in map units).
+ *
+ * Only infected cells of *from* which are in *suitable_cells* are used,
+ * but any cell of *to* can be the nearest one. Call with swapped rasters
+ * to get the distance in the other direction, e.g., how far the simulated
+ * infection is from the observed one and vice versa.
+ *
+ * Returns NaN if there is no infection in one of the rasters.
+ */
+template<typename FromRaster, typename ToRaster>
+double mean_distance_to_nearest_infection(
+    const FromRaster& from,
+    const ToRaster& to,
+    double ew_res,
+    double ns_res,
+    const std::vector<std::vector<int>>& suitable_cells)
+{
+    int rows = to.rows();
+    int cols = to.cols();
+    auto nearest = nearest_feature_cells(
+        rows, cols, ns_res, ew_res, [&to](int i, int j) { return to(i, j) > 0; });
+    double sum = 0;
+    std::uint64_t count = 0;
+    for (const auto& indices : suitable_cells) {
+        int i = indices[0];
+        int j = indices[1];
+        if (!(from(i, j) > 0))
+            continue;
+        int feature = nearest[i * cols + j];
+        if (feature < 0)
+            return std::nan("");
+        double dx = (feature % cols - j) * ew_res;
+        double dy = (feature / cols - i) * ns_res;
+        sum += std::sqrt(dx * dx + dy * dy);
+        ++count;
+    }
+    if (!count)
+        return std::nan("");
+    return sum / count;
+}
+
+}  // namespace pops
+
+#endif  // POPS_ACCURACY_HPP
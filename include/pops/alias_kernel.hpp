@@ -0,0 +1,485 @@
+/*
+ * PoPS model - discretized radial kernel sampled using alias tables
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_ALIAS_KERNEL_HPP
+#define POPS_ALIAS_KERNEL_HPP
+
+#include "kernel_types.hpp"
+#include "utils.hpp"
+#include "von_mises_distribution.hpp"
+#include "cauchy_kernel.hpp"
+#include "exponential_kernel.hpp"
+#include "hyperbolic_secant_kernel.hpp"
+#include "lognormal_kernel.hpp"
+#include "normal_kernel.hpp"
+#include "power_law_kernel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+namespace pops {
+
+/**
+ * Quantile function of the dispersal distance of RadialDispersalKernel.
+ *
+ * The radial kernel uses the absolute value of a random number from the
+ * distribution as the distance. For distributions symmetric around zero,
+ * the quantile of the distance is the quantile of the distribution
+ * at (1 + p) / 2.
+ *
+ * Gamma kernel is not supported because its quantile function does not
+ * use the same parameters as its random numbers.
+ */
+class RadialDistanceQuantile
+{
+public:
+    RadialDistanceQuantile(DispersalKernelType type, double scale, double shape)
+        : type_(type),
+          scale_(scale),
+          shape_(shape),
+          cauchy_(scale),
+          exponential_(scale),
+          normal_(scale),
+          log_normal_(scale),
+          power_law_(scale, shape),
+          hyperbolic_secant_(scale)
+    {
+        if (!supports_kernel(type))
+            throw std::invalid_argument(
+                "RadialDistanceQuantile: Unsupported dispersal kernel type");
+    }
+
+    /** Distance which is not exceeded with probability *p* (zero for p = 0) */
+    double operator()(double p)
+    {
+        if (p <= 0)
+            return 0;
+        switch (type_) {
+        case DispersalKernelType::Cauchy:
+            return cauchy_.icdf((1 + p) / 2);
+        case DispersalKernelType::Normal:
+            return normal_.icdf((1 + p) / 2);
+        case DispersalKernelType::HyperbolicSecant:
+            return hyperbolic_secant_.icdf((1 + p) / 2);
+        case DispersalKernelType::Exponential:
+            return exponential_.icdf(p);
+        case DispersalKernelType::Weibull:
+            // WeibullKernel::icdf() swaps scale and shape
+            return scale_ * std::pow(-std::log(1 - p), 1 / shape_);
+        case DispersalKernelType::LogNormal:
+            return log_normal_.icdf(p);
+        case DispersalKernelType::PowerLaw:
+            // icdf of the power law kernel decreases with p
+            return power_law_.icdf(1 - p);
+        default:
+            throw std::invalid_argument(
+                "RadialDistanceQuantile: Unsupported dispersal kernel type");
+        }
+    }
+
+    /** Returns true if the distance quantile is available for the kernel type */
+    static bool supports_kernel(DispersalKernelType type)
+    {
+        return type == DispersalKernelType::Cauchy
+               || type == DispersalKernelType::Normal
+               || type == DispersalKernelType::HyperbolicSecant
+               || type == DispersalKernelType::Exponential
+               || type == DispersalKernelType::Weibull
+               || type == DispersalKernelType::LogNormal
+               || type == DispersalKernelType::PowerLaw;
+    }
+
+private:
+    DispersalKernelType type_;
+    double scale_;
+    double shape_;
+    CauchyKernel cauchy_;
+    ExponentialKernel exponential_;
+    NormalKernel normal_;
+    LogNormalKernel log_normal_;
+    PowerLawKernel power_law_;
+    HyperbolicSecantKernel hyperbolic_secant_;
+};
+
+/**
+ * Probabilities of cell offsets of a discretized radial kernel
+ * in the form of an alias table (Walker's alias method, Vose's algorithm).
+ *
+ * The table covers dispersal up to the distance which includes
+ * *dispersal_percentage* of dispersers (window as in
+ * DeterministicDispersalKernel). The rest of the probability is
+ * the tail which is sampled separately (see AliasDispersalKernel).
+ */
+struct DispersalAliasTable
+{
+    /** Row and column offsets of cells with non-zero probability (most likely first) */
+    std::vector<std::tuple<int, int>> offsets;
+    /** Probability of each cell (tail not included) */
+    std::vector<double> probabilities;
+    /** Probability of keeping the item in the alias method (last item is tail) */
+    std::vector<double> keep;
+    /** Alternative item in the alias method */
+    std::vector<std::size_t> alias;
+    /** Probability of dispersal beyond the window */
+    double tail_probability{0};
+    /** Maximum dispersal distance covered by the window */
+    double max_distance{0};
+};
+
+/**
+ * Computes alias table for a radial kernel with given parameters.
+ *
+ * The parameters have the same meaning as for RadialDispersalKernel.
+ * Probability of each cell is the probability that RadialDispersalKernel
+ * moves a disperser by that cell offset (with the distance within
+ * the window) computed by numerical integration over the distance
+ * (using the quantile function) and the direction (using von Mises
+ * density).
+ *
+ * The table depends only on the parameters, so it can be shared by
+ * multiple kernels.
+ */
+inline std::shared_ptr<const DispersalAliasTable> dispersal_alias_table(
+    DispersalKernelType kernel_type,
+    double dispersal_percentage,
+    double ew_res,
+    double ns_res,
+    double distance_scale,
+    Direction dispersal_direction = Direction::None,
+    double dispersal_direction_kappa = 0,
+    double shape = 1)
+{
+    if (dispersal_percentage <= 0 || dispersal_percentage >= 1)
+        throw std::invalid_argument(
+            "dispersal_alias_table: Dispersal percentage must be between 0 and 1");
+    RadialDistanceQuantile quantile(kernel_type, distance_scale, shape);
+    std::shared_ptr<DispersalAliasTable> table(new DispersalAliasTable);
+    table->max_distance = quantile(dispersal_percentage);
+    table->tail_probability = 1 - dispersal_percentage;
+    // The limit avoids integer overflow and exhausting memory.
+    double max_cells = 1e8;
+    double window_rows = 2 * table->max_distance / ns_res + 3;
+    double window_cols = 2 * table->max_distance / ew_res + 3;
+    if (!std::isfinite(table->max_distance) || window_rows * window_cols > max_cells)
+        throw std::invalid_argument(
+            "dispersal_alias_table: Window is too large for the kernel parameters"
+            " (use lower dispersal percentage)");
+    int max_row = std::ceil(table->max_distance / ns_res);
+    int max_col = std::ceil(table->max_distance / ew_res);
+    int rows = 2 * max_row + 1;
+    int cols = 2 * max_col + 1;
+    std::vector<double> cells(std::size_t(rows) * cols, 0);
+
+    double mu = static_cast<int>(dispersal_direction) * PI / 180;
+    double kappa =
+        dispersal_direction == Direction::None ? 0 : dispersal_direction_kappa;
+    // Rings with equal probability, each split into rings and arcs of about
+    // a quarter of a cell. The number of arcs is a multiple of four,
+    // so that the arcs are symmetric like the cells.
+    double step = std::min(ew_res, ns_res) / 4;
+    const int num_rings = 1024;
+    double ring_probability = dispersal_percentage / num_rings;
+    double inner = 0;
+    std::vector<double> weights;
+    for (int ring = 0; ring < num_rings; ++ring) {
+        double outer = ring + 1 == num_rings
+                           ? table->max_distance
+                           : quantile(dispersal_percentage * (ring + 1) / num_rings);
+        int num_parts = std::max(1, int(std::ceil((outer - inner) / step)));
+        for (int part = 0; part < num_parts; ++part) {
+            double distance = inner + (outer - inner) * (part + 0.5) / num_parts;
+            int num_angles = 4 * std::max(16, int(std::ceil(PI * distance / step / 2)));
+            weights.resize(num_angles);
+            double sum = 0;
+            for (int k = 0; k < num_angles; ++k) {
+                double theta = 2 * PI * (k + 0.5) / num_angles;
+                weights[k] = std::exp(kappa * (std::cos(theta - mu) - 1));
+                sum += weights[k];
+            }
+            double probability = ring_probability / num_parts / sum;
+            for (int k = 0; k < num_angles; ++k) {
+                double theta = 2 * PI * (k + 0.5) / num_angles;
+                // same rounding as in RadialDispersalKernel
+                int row = -std::round(distance * std::cos(theta) / ns_res);
+                int col = std::round(distance * std::sin(theta) / ew_res);
+                cells[std::size_t(row + max_row) * cols + col + max_col] +=
+                    probability * weights[k];
+            }
+        }
+        inner = outer;
+    }
+
+    // Most probable cells first (shortens the sequential sampling of counts).
+    std::vector<std::tuple<double, int, int>> nonzero;
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            double probability = cells[std::size_t(i) * cols + j];
+            if (probability > 0)
+                nonzero.emplace_back(-probability, i - max_row, j - max_col);
+        }
+    }
+    std::sort(nonzero.begin(), nonzero.end());
+    for (const auto& cell : nonzero) {
+        table->offsets.emplace_back(std::get<1>(cell), std::get<2>(cell));
+        table->probabilities.push_back(-std::get<0>(cell));
+    }
+
+    // Vose's alias method with the tail as the last item.
+    std::size_t size = table->probabilities.size() + 1;
+    table->keep.resize(size);
+    table->alias.resize(size);
+    std::vector<double> scaled(size);
+    std::vector<std::size_t> small;
+    std::vector<std::size_t> large;
+    for (std::size_t i = 0; i < size; ++i) {
+        double probability = i + 1 < size ? table->probabilities[i]
+                                          : table->tail_probability;
+        scaled[i] = probability * size;
+        if (scaled[i] < 1)
+            small.push_back(i);
+        else
+            large.push_back(i);
+    }
+    while (!small.empty() && !large.empty()) {
+        std::size_t less = small.back();
+        small.pop_back();
+        std::size_t more = large.back();
+        table->keep[less] = scaled[less];
+        table->alias[less] = more;
+        scaled[more] = (scaled[more] + scaled[less]) - 1;
+        if (scaled[more] < 1) {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
+    // Remaining items have probability one (up to rounding errors).
+    for (auto i : large) {
+        table->keep[i] = 1;
+        table->alias[i] = i;
+    }
+    for (auto i : small) {
+        table->keep[i] = 1;
+        table->alias[i] = i;
+    }
+    return table;
+}
+
+/**
+ * Radial dispersal kernel sampled from precomputed cell probabilities.
+ *
+ * The kernel gives the same distribution of target cells as
+ * RadialDispersalKernel with the same parameters (up to the accuracy
+ * of the numerical integration), but each disperser needs only two random
+ * numbers and no trigonometric functions. Dispersers within the window
+ * (*dispersal_percentage* of them) are sampled from an alias table
+ * in constant time. Dispersers in the tail beyond the window are sampled
+ * using the quantile function of the distance (conditioned to be beyond
+ * the window) and von Mises distribution of the direction.
+ *
+ * Many dispersers from one cell can be dispersed at once using
+ * sample_counts() which Simulation uses instead of sample() when available.
+ *
+ * Supported kernel types are listed by supports_kernel().
+ */
+class AliasDispersalKernel
+{
+public:
+    AliasDispersalKernel(
+        double ew_res,
+        double ns_res,
+        DispersalKernelType dispersal_kernel,
+        double distance_scale,
+        double dispersal_percentage,
+        Direction dispersal_direction = Direction::None,
+        double dispersal_direction_kappa = 0,
+        double shape = 1)
+        : AliasDispersalKernel(
+            ew_res,
+            ns_res,
+            dispersal_kernel,
+            distance_scale,
+            dispersal_direction,
+            dispersal_direction_kappa,
+            shape,
+            dispersal_alias_table(
+                dispersal_kernel,
+                dispersal_percentage,
+                ew_res,
+                ns_res,
+                distance_scale,
+                dispersal_direction,
+                dispersal_direction_kappa,
+                shape))
+    {}
+
+    /**
+     * Creates the kernel with a table created by dispersal_alias_table()
+     * with the same parameters (possibly shared with other kernels).
+     */
+    AliasDispersalKernel(
+        double ew_res,
+        double ns_res,
+        DispersalKernelType dispersal_kernel,
+        double distance_scale,
+        Direction dispersal_direction,
+        double dispersal_direction_kappa,
+        double shape,
+        std::shared_ptr<const DispersalAliasTable> table)
+        : east_west_resolution_(ew_res),
+          north_south_resolution_(ns_res),
+          table_(table),
+          item_distribution_(0, table->keep.size() - 1),
+          tail_distribution_(1 - table->tail_probability, 1),
+          quantile_(dispersal_kernel, distance_scale, shape),
+          von_mises_(
+              static_cast<int>(dispersal_direction) * PI / 180,
+              dispersal_direction == Direction::None ? 0 : dispersal_direction_kappa)
+    {}
+
+    /*! \copybrief RadialDispersalKernel::operator()()
+     *
+     * The randomness is based on the *generator*. Parameters *row* and *col*
+     * are row and column position of the current disperser.
+     */
+    template<typename Generator>
+    std::tuple<int, int> operator()(Generator& generator, int row, int col)
+    {
+        std::size_t item = item_distribution_(generator);
+        if (uniform_(generator) >= table_->keep[item])
+            item = table_->alias[item];
+        if (item < table_->offsets.size()) {
+            return std::make_tuple(
+                row + std::get<0>(table_->offsets[item]),
+                col + std::get<1>(table_->offsets[item]));
+        }
+        return tail(generator, row, col);
+    }
+
+    /*! \copydoc RadialDispersalKernel::sample()
+     */
+    template<typename Generator>
+    void sample(
+        Generator& generator,
+        int row,
+        int col,
+        int count,
+        std::vector<std::tuple<int, int>>& targets)
+    {
+        targets.resize(count);
+        for (auto& target : targets)
+            target = (*this)(generator, row, col);
+    }
+
+    /**
+     * Generates new positions for *count* dispersers from one cell
+     * together with the number of dispersers going to each position.
+     *
+     * Each item of *targets* is row, column, and number of dispersers.
+     * When *count* is larger than the number of cells in the table,
+     * the numbers for all cells are drawn at once from the multinomial
+     * distribution (as a sequence of binomial draws) and only dispersers
+     * in the tail are sampled one by one, so the cost depends on the size of
+     * the table instead of on the number of dispersers. Otherwise, each
+     * disperser is sampled individually with count one.
+     *
+     * The distribution of targets is the same as with sample(), but the random
+     * numbers are used differently, so the results are not the same.
+     */
+    template<typename Generator>
+    void sample_counts(
+        Generator& generator,
+        int row,
+        int col,
+        int count,
+        std::vector<std::tuple<int, int, int>>& targets)
+    {
+        targets.clear();
+        if (std::size_t(count) <= table_->keep.size()) {
+            for (int i = 0; i < count; ++i) {
+                auto target = (*this)(generator, row, col);
+                targets.emplace_back(std::get<0>(target), std::get<1>(target), 1);
+            }
+            return;
+        }
+        std::binomial_distribution<int> tail_binomial(count, table_->tail_probability);
+        int num_tail = tail_binomial(generator);
+        int remaining = count - num_tail;
+        double remaining_probability = 1 - table_->tail_probability;
+        std::size_t size = table_->offsets.size();
+        for (std::size_t i = 0; i < size && remaining > 0; ++i) {
+            double probability = table_->probabilities[i];
+            int number = remaining;
+            if (i + 1 < size && probability < remaining_probability) {
+                std::binomial_distribution<int> binomial(
+                    remaining, probability / remaining_probability);
+                number = binomial(generator);
+            }
+            remaining_probability -= probability;
+            if (number) {
+                targets.emplace_back(
+                    row + std::get<0>(table_->offsets[i]),
+                    col + std::get<1>(table_->offsets[i]),
+                    number);
+                remaining -= number;
+            }
+        }
+        for (int i = 0; i < num_tail; ++i) {
+            auto target = tail(generator, row, col);
+            targets.emplace_back(std::get<0>(target), std::get<1>(target), 1);
+        }
+    }
+
+    /** Table with the cell probabilities */
+    const DispersalAliasTable& table() const
+    {
+        return *table_;
+    }
+
+    /*! \copydoc RadialDispersalKernel::supports_kernel()
+     */
+    static bool supports_kernel(const DispersalKernelType type)
+    {
+        return RadialDistanceQuantile::supports_kernel(type);
+    }
+
+private:
+    /** Samples position of a disperser going beyond the window */
+    template<typename Generator>
+    std::tuple<int, int> tail(Generator& generator, int row, int col)
+    {
+        double distance = quantile_(tail_distribution_(generator));
+        double theta = von_mises_(generator);
+        row -= std::round(distance * std::cos(theta) / north_south_resolution_);
+        col += std::round(distance * std::sin(theta) / east_west_resolution_);
+        return std::make_tuple(row, col);
+    }
+
+    double east_west_resolution_;
+    double north_south_resolution_;
+    std::shared_ptr<const DispersalAliasTable> table_;
+    std::uniform_int_distribution<std::size_t> item_distribution_;
+    std::uniform_real_distribution<double> uniform_{0, 1};
+    std::uniform_real_distribution<double> tail_distribution_;
+    RadialDistanceQuantile quantile_;
+    VonMisesDistribution von_mises_;
+};
+
+}  // namespace pops
+
+#endif  // POPS_ALIAS_KERNEL_HPP
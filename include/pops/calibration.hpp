@@ -0,0 +1,375 @@
+/*
+ * PoPS model - calibration using Approximate Bayesian Computation
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_CALIBRATION_HPP
+#define POPS_CALIBRATION_HPP
+
+#include "accuracy.hpp"
+#include "config.hpp"
+#include "deterministic_kernel.hpp"
+#include "lethal_temperature.hpp"
+#include "model.hpp"
+#include "movements.hpp"
+#include "outside_dispersers.hpp"
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace pops {
+
+/**
+ * Model parameters estimated by the calibration
+ */
+struct CalibrationParameters
+{
+    double reproductive_rate{0};
+    double natural_scale{0};
+    double percent_natural_dispersal{1};
+    double anthro_scale{0};
+    double natural_kappa{0};
+
+    CalibrationParameters() = default;
+
+    /** Takes the parameters from the configuration, e.g., as a base for a prior */
+    explicit CalibrationParameters(const Config& config)
+        : reproductive_rate(config.reproductive_rate),
+          natural_scale(config.natural_scale),
+          percent_natural_dispersal(config.percent_natural_dispersal),
+          anthro_scale(config.anthro_scale),
+          natural_kappa(config.natural_kappa)
+    {}
+
+    /** Sets the parameters in the configuration */
+    void apply(Config& config) const
+    {
+        config.reproductive_rate = reproductive_rate;
+        config.natural_scale = natural_scale;
+        config.percent_natural_dispersal = percent_natural_dispersal;
+        config.anthro_scale = anthro_scale;
+        config.natural_kappa = natural_kappa;
+    }
+};
+
+/**
+ * Outcome of a simulation with one set of candidate parameters
+ */
+struct CalibrationResult
+{
+    CalibrationParameters parameters;
+    /** True if the distance was within tolerance at all checkpoints */
+    bool accepted{false};
+    /** Largest distance from observations at the evaluated checkpoints */
+    double distance{0};
+    /** Number of evaluated checkpoints (less than all when rejected early) */
+    unsigned num_checkpoints{0};
+    /** Number of simulated steps */
+    unsigned num_steps{0};
+};
+
+/**
+ * Draws *count* candidate parameter sets from a uniform prior.
+ *
+ * Each parameter is drawn independently from the interval given by the
+ * corresponding values in *low* and *high*.
+ */
+inline std::vector<CalibrationParameters> sample_uniform_prior(
+    const CalibrationParameters& low,
+    const CalibrationParameters& high,
+    unsigned count,
+    unsigned seed)
+{
+    std::default_random_engine generator(seed);
+    auto draw = [&generator](double a, double b) {
+        if (a == b)
+            return a;
+        std::uniform_real_distribution<double> distribution(a, b);
+        return distribution(generator);
+    };
+    std::vector<CalibrationParameters> candidates(count);
+    for (auto& candidate : candidates) {
+        candidate.reproductive_rate =
+            draw(low.reproductive_rate, high.reproductive_rate);
+        candidate.natural_scale = draw(low.natural_scale, high.natural_scale);
+        candidate.percent_natural_dispersal =
+            draw(low.percent_natural_dispersal, high.percent_natural_dispersal);
+        candidate.anthro_scale = draw(low.anthro_scale, high.anthro_scale);
+        candidate.natural_kappa = draw(low.natural_kappa, high.natural_kappa);
+    }
+    return candidates;
+}
+
+/**
+ * Rejection sampling ABC (Approximate Bayesian Computation) calibration.
+ *
+ * Each candidate parameter set is used to run the Model from the initial
+ * state. After each step with an observation (a checkpoint), the simulated
+ * infected hosts are compared with the observed ones using the distance
+ * function. A candidate is accepted when the distance at all checkpoints is
+ * within the tolerance. Because of that, the simulation of a candidate is
+ * stopped at the first checkpoint which exceeds the tolerance and the steps
+ * after it are never computed.
+ *
+ * The default distance is the total disagreement (proportion of suitable
+ * cells which differ in presence of infection, see AccuracyMetrics).
+ *
+ * Candidates are evaluated in parallel. Each candidate is simulated with
+ * its own random seed derived from the seed in the configuration and the
+ * index of the candidate, so the results do not depend on the number of
+ * threads. Probability windows of deterministic kernels are shared between
+ * all candidates with the same kernel parameters.
+ *
+ * The configuration needs to have the schedules created. Treatments, spread
+ * rates, and quarantine escape are not used during the calibration.
+ * The referenced rasters must exist for the lifetime of the object.
+ */
+template<typename IntegerRaster, typename FloatRaster, typename RasterIndex>
+class AbcCalibration
+{
+public:
+    /**
+     * Distance of simulated infection from observed infection in suitable cells
+     */
+    typedef std::function<double(
+        const IntegerRaster& simulated,
+        const IntegerRaster& observed,
+        const std::vector<std::vector<int>>& suitable_cells)>
+        DistanceFunction;
+
+    /**
+     * @param config Base configuration with schedules created
+     * @param infected Initial infected hosts
+     * @param susceptible Initial susceptible hosts
+     * @param total_populations Initial total hosts
+     * @param weather_coefficients Weather coefficients for each step
+     *        (one raster is used for all steps, empty when weather is not used)
+     * @param temperatures Temperatures for lethal temperature
+     *        (cells with lethal temperature are found once for all candidates,
+     *        so the rasters don't need to be kept)
+     * @param suitable_cells Cells to simulate and evaluate
+     */
+    AbcCalibration(
+        const Config& config,
+        const IntegerRaster& infected,
+        const IntegerRaster& susceptible,
+        const IntegerRaster& total_populations,
+        const std::vector<FloatRaster>& weather_coefficients,
+        const std::vector<FloatRaster>& temperatures,
+        const std::vector<std::vector<int>>& suitable_cells)
+        : config_(config),
+          infected_(infected),
+          susceptible_(susceptible),
+          total_populations_(total_populations),
+          weather_coefficients_(weather_coefficients),
+          suitable_cells_(suitable_cells),
+          lethal_cells_(
+              config.use_lethal_temperature
+                  ? LethalTemperatureCells(
+                      temperatures, config.lethal_temperature, suitable_cells)
+                  : LethalTemperatureCells()),
+          no_weather_(infected.rows(), infected.cols()),
+          distance_(
+              [](const IntegerRaster& simulated,
+                 const IntegerRaster& observed,
+                 const std::vector<std::vector<int>>& cells) {
+                  return accuracy_metrics(simulated, observed, cells)
+                      .total_disagreement();
+              })
+    {
+        if (config_.weather && weather_coefficients_.empty())
+            throw std::invalid_argument(
+                "AbcCalibration: Weather coefficients are required with weather");
+        config_.use_treatments = false;
+        config_.use_spreadrates = false;
+        config_.use_quarantine = false;
+        config_.use_movements = false;
+        num_mortality_years_ = config_.num_mortality_years();
+    }
+
+    /**
+     * Adds observed infected hosts to compare with after the given step
+     */
+    void add_observation(unsigned step, const IntegerRaster& observed)
+    {
+        if (step >= config_.scheduler().get_num_steps())
+            throw std::invalid_argument(
+                "AbcCalibration: Observation step is after the last step");
+        observations_.erase(step);
+        observations_.emplace(step, observed);
+    }
+
+    /**
+     * Sets host movements (the configuration decides if they are batched)
+     */
+    void set_movements(const MovementTable<RasterIndex>& movements)
+    {
+        movements_ = movements;
+        config_.use_movements = true;
+    }
+
+    /** Replaces the default distance function */
+    void set_distance(DistanceFunction distance)
+    {
+        distance_ = distance;
+    }
+
+    /**
+     * Runs simulation with the candidate parameters and compares it with
+     * the observations.
+     *
+     * The *index* of the candidate determines its random seed.
+     * Simulation stops at the first checkpoint with distance over *tolerance*.
+     */
+    CalibrationResult evaluate(
+        const CalibrationParameters& parameters,
+        double tolerance,
+        std::size_t index,
+        unsigned num_threads = 1) const
+    {
+        if (observations_.empty())
+            throw std::logic_error("AbcCalibration: No observations to compare with");
+        Config config = config_;
+        parameters.apply(config);
+        config.random_seed = substream_seed(config_.random_seed, index);
+        config.num_threads = num_threads;
+        Model<IntegerRaster, FloatRaster, RasterIndex> model(config, window_cache_);
+
+        int rows = infected_.rows();
+        int cols = infected_.cols();
+        IntegerRaster infected = infected_;
+        IntegerRaster susceptible = susceptible_;
+        IntegerRaster total_populations = total_populations_;
+        IntegerRaster dispersers(rows, cols);
+        IntegerRaster zeros(rows, cols, 0);
+        IntegerRaster died(rows, cols, 0);
+        IntegerRaster resistant(rows, cols, 0);
+        std::vector<IntegerRaster> exposed;
+        if (model_type_from_string(config.model_type)
+            == ModelType::SusceptibleExposedInfected)
+            exposed.resize(config.latency_period_steps + 1, zeros);
+        std::vector<IntegerRaster> mortality_tracker(num_mortality_years_, zeros);
+        // Only the total number of outside dispersers is kept.
+        AggregatedOutsideDispersers outside_dispersers(rows, cols, 0);
+        Treatments<IntegerRaster, FloatRaster> treatments(config.scheduler());
+        SpreadRate<IntegerRaster> spread_rate(
+            infected, config.ew_res, config.ns_res, 0, suitable_cells_);
+        QuarantineEscape<IntegerRaster> quarantine(
+            zeros, config.ew_res, config.ns_res, 0, suitable_cells_);
+
+        CalibrationResult result;
+        result.parameters = parameters;
+        unsigned last_step = observations_.rbegin()->first;
+        auto observation = observations_.begin();
+        for (unsigned step = 0; step <= last_step; ++step) {
+            model.run_step(
+                step,
+                infected,
+                susceptible,
+                total_populations,
+                dispersers,
+                exposed,
+                mortality_tracker,
+                died,
+                lethal_cells_,
+                weather_coefficient(step),
+                treatments,
+                resistant,
+                outside_dispersers,
+                spread_rate,
+                quarantine,
+                zeros,
+                movements_,
+                suitable_cells_);
+            result.num_steps = step + 1;
+            if (observation->first != step)
+                continue;
+            double distance = distance_(infected, observation->second, suitable_cells_);
+            result.distance = std::max(result.distance, distance);
+            ++result.num_checkpoints;
+            if (distance > tolerance)
+                return result;
+            ++observation;
+        }
+        result.accepted = true;
+        return result;
+    }
+
+    /**
+     * Evaluates all candidates and returns results in the same order.
+     *
+     * Candidates are distributed dynamically between *num_threads* threads
+     * because early rejected candidates take less time than the others.
+     * Zero threads means the number of threads from the configuration.
+     */
+    std::vector<CalibrationResult> run(
+        const std::vector<CalibrationParameters>& candidates,
+        double tolerance,
+        unsigned num_threads = 0) const
+    {
+        if (!num_threads)
+            num_threads = std::max(config_.num_threads, 1u);
+        std::vector<CalibrationResult> results(candidates.size());
+        std::atomic<std::size_t> next(0);
+        // With parallel candidates, each model runs in one thread.
+        unsigned model_threads = num_threads > 1 ? 1 : config_.num_threads;
+        parallel_for_chunks(
+            num_threads, num_threads, [&](std::size_t, std::size_t) {
+                std::size_t index;
+                while ((index = next++) < candidates.size()) {
+                    results[index] =
+                        evaluate(candidates[index], tolerance, index, model_threads);
+                }
+            });
+        return results;
+    }
+
+    /** Cache of deterministic kernel windows shared by the candidates */
+    const DeterministicWindowCache& window_cache() const
+    {
+        return window_cache_;
+    }
+
+private:
+    const FloatRaster& weather_coefficient(unsigned step) const
+    {
+        if (!config_.weather)
+            return no_weather_;
+        if (weather_coefficients_.size() == 1)
+            return weather_coefficients_[0];
+        return weather_coefficients_.at(step);
+    }
+
+    Config config_;
+    const IntegerRaster& infected_;
+    const IntegerRaster& susceptible_;
+    const IntegerRaster& total_populations_;
+    const std::vector<FloatRaster>& weather_coefficients_;
+    const std::vector<std::vector<int>>& suitable_cells_;
+    LethalTemperatureCells lethal_cells_;
+    FloatRaster no_weather_;
+    unsigned num_mortality_years_{0};
+    std::map<unsigned, IntegerRaster> observations_;
+    MovementTable<RasterIndex> movements_;
+    DistanceFunction distance_;
+    mutable DeterministicWindowCache window_cache_;
+};
+
+}  // namespace pops
+
+#endif  // POPS_CALIBRATION_HPP
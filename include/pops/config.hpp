@@ -26,10 +26,131 @@
 
 #include "scheduling.hpp"
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
 #include <vector>
 
 namespace pops {
 
+/**
+ * Scheduler and action schedules created for a configuration.
+ *
+ * The object is immutable after creation, so it can be shared by all
+ * configurations with the same dates and frequencies.
+ */
+struct ConfigSchedules
+{
+    ConfigSchedules(const Scheduler& scheduler) : scheduler(scheduler) {}
+
+    Scheduler scheduler;
+    std::vector<bool> spread;
+    std::vector<bool> output;
+    std::vector<bool> mortality;
+    std::vector<bool> lethal;
+    std::vector<bool> spread_rate;
+    std::vector<bool> quarantine;
+    // Action step for each simulation step (see simulation_steps_to_action_steps())
+    std::vector<unsigned> mortality_action_steps;
+    std::vector<unsigned> lethal_action_steps;
+    std::vector<unsigned> spread_rate_action_steps;
+    std::vector<unsigned> quarantine_action_steps;
+};
+
+/**
+ * Cache of schedules shared between configurations.
+ *
+ * The schedules are identified by all the inputs used to create them
+ * (see Config::create_schedules()). The cache holds only weak references,
+ * so the schedules are released when no configuration uses them.
+ * The entries of released schedules are removed when new schedules
+ * are added.
+ * The cache can be used from multiple threads.
+ */
+class ScheduleCache
+{
+public:
+    typedef std::tuple<
+        int,  // start day number
+        int,  // end day number
+        int,  // step unit
+        unsigned,  // step number of units
+        int,  // season start month
+        int,  // season end month
+        std::string,  // output frequency
+        unsigned,
+        bool,  // lethal temperature
+        int,
+        bool,  // spread rates
+        std::string,
+        unsigned,
+        bool,  // quarantine
+        std::string,
+        unsigned>
+        Key;
+
+    /**
+     * Returns schedules for the key or creates them using *create*
+     * when they are not in the cache.
+     */
+    template<typename Create>
+    std::shared_ptr<const ConfigSchedules> get(const Key& key, Create create)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto search = schedules_.find(key);
+            if (search != schedules_.end()) {
+                auto schedules = search->second.lock();
+                if (schedules)
+                    return schedules;
+                schedules_.erase(search);
+            }
+        }
+        // The schedules are created outside of the lock, so another thread
+        // may create the same ones meanwhile. The first inserted ones are used.
+        std::shared_ptr<const ConfigSchedules> created = create();
+        std::lock_guard<std::mutex> lock(mutex_);
+        remove_released();
+        auto& stored = schedules_[key];
+        auto schedules = stored.lock();
+        if (schedules)
+            return schedules;
+        stored = created;
+        return created;
+    }
+
+    /** Number of cached schedules (including released ones not removed yet) */
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return schedules_.size();
+    }
+
+    /** Cache used by Config::create_schedules() */
+    static ScheduleCache& global()
+    {
+        static ScheduleCache cache;
+        return cache;
+    }
+
+private:
+    std::map<Key, std::weak_ptr<const ConfigSchedules>> schedules_;
+    mutable std::mutex mutex_;
+
+    /** Removes entries of released schedules (mutex needs to be locked) */
+    void remove_released()
+    {
+        for (auto it = schedules_.begin(); it != schedules_.end();) {
+            if (it->second.expired())
+                it = schedules_.erase(it);
+            else
+                ++it;
+        }
+    }
+};
+
 class Config
 {
 public:
@@ -46,6 +167,8 @@ public:
     bool movement_stochasticity{true};
     bool deterministic{false};
     double establishment_probability{0};
+    // Establishment after all dispersers are dispersed
+    bool two_phase_establishment{false};
     // Temperature
     bool use_lethal_temperature{false};
     double lethal_temperature{-273.15};  // 0 K
@@ -80,6 +203,7 @@ public:
     // Movements
     bool use_movements{false};
     std::vector<unsigned> movement_schedule;
+    bool use_batched_movements{false};
     double dispersal_percentage{0.99};
     std::string output_frequency;
     unsigned output_frequency_n;
@@ -89,49 +213,73 @@ public:
     bool use_overpopulation_movements{false};
     double overpopulation_percentage{0};
     double leaving_percentage{0};
-
+    // Parallelization
+    unsigned num_threads{1};
+
+    /**
+     * Creates the scheduler and action schedules.
+     *
+     * Configurations with the same dates, step, season, and frequencies
+     * share the same schedules (see ScheduleCache), so copies of
+     * a configuration which differ only in other parameters do not
+     * create or store the schedules again.
+     */
     void create_schedules()
     {
-        scheduler_ = Scheduler(date_start_, date_end_, step_unit_, step_num_units_);
-        spread_schedule_ =
-            scheduler_.schedule_spread(Season(season_start_month_, season_end_month_));
-        output_schedule_ =
-            schedule_from_string(scheduler_, output_frequency, output_frequency_n);
-        mortality_schedule_ = scheduler_.schedule_action_end_of_year();
-        if (use_lethal_temperature)
-            lethal_schedule_ =
-                scheduler_.schedule_action_yearly(lethal_temperature_month, 1);
-        if (use_spreadrates)
-            spread_rate_schedule_ = schedule_from_string(
-                scheduler_, spreadrate_frequency, spreadrate_frequency_n);
-        if (use_quarantine)
-            quarantine_schedule_ = schedule_from_string(
-                scheduler_, quarantine_frequency, quarantine_frequency_n);
-        schedules_created_ = true;
+        create_schedules(ScheduleCache::global());
+    }
+
+    /**
+     * Creates the schedules using a given cache.
+     */
+    void create_schedules(ScheduleCache& cache)
+    {
+        // Number of steps is used (and may be set) only for every_n_steps.
+        auto steps_n = [](const std::string& frequency, unsigned n) {
+            return frequency == "every_n_steps" ? n : 0;
+        };
+        ScheduleCache::Key key(
+            date_start_.day_number(),
+            date_end_.day_number(),
+            static_cast<int>(step_unit_),
+            step_num_units_,
+            season_start_month_,
+            season_end_month_,
+            output_frequency,
+            steps_n(output_frequency, output_frequency_n),
+            use_lethal_temperature,
+            use_lethal_temperature ? lethal_temperature_month : 0,
+            use_spreadrates,
+            use_spreadrates ? spreadrate_frequency : std::string(),
+            use_spreadrates ? steps_n(spreadrate_frequency, spreadrate_frequency_n) : 0,
+            use_quarantine,
+            use_quarantine ? quarantine_frequency : std::string(),
+            use_quarantine ? steps_n(quarantine_frequency, quarantine_frequency_n) : 0);
+        schedules_ = cache.get(key, [this]() { return compute_schedules(); });
     }
 
     const Scheduler& scheduler() const
     {
-        if (!schedules_created_)
+        if (!schedules_)
             throw std::logic_error(
                 "Schedules were not created before calling scheduler()");
-        return scheduler_;
+        return schedules_->scheduler;
     }
 
     const std::vector<bool>& spread_schedule() const
     {
-        if (!schedules_created_)
+        if (!schedules_)
             throw std::logic_error(
                 "Schedules were not created before calling spread_schedule()");
-        return spread_schedule_;
+        return schedules_->spread;
     }
 
     const std::vector<bool>& mortality_schedule() const
     {
-        if (!schedules_created_)
+        if (!schedules_)
             throw std::logic_error(
                 "Schedules were not created before calling mortality_schedule()");
-        return mortality_schedule_;
+        return schedules_->mortality;
     }
 
     const std::vector<bool>& lethal_schedule() const
@@ -139,10 +287,10 @@ public:
         if (!use_lethal_temperature)
             throw std::logic_error(
                 "lethal_schedule() not available when use_lethal_temperature is false");
-        if (!schedules_created_)
+        if (!schedules_)
             throw std::logic_error(
                 "Schedules were not created before calling lethal_schedule()");
-        return lethal_schedule_;
+        return schedules_->lethal;
     }
 
     const std::vector<bool>& spread_rate_schedule() const
@@ -150,10 +298,10 @@ public:
         if (!use_spreadrates)
             throw std::logic_error(
                 "spread_rate_schedule() not available when use_spreadrates is false");
-        if (!schedules_created_)
+        if (!schedules_)
             throw std::logic_error(
                 "Schedules were not created before calling spread_rate_schedule()");
-        return spread_rate_schedule_;
+        return schedules_->spread_rate;
     }
 
     const std::vector<bool>& quarantine_schedule() const
@@ -161,26 +309,78 @@ public:
         if (!use_quarantine)
             throw std::logic_error(
                 "quarantine_schedule() not available when use_quarantine is false");
-        if (!schedules_created_)
+        if (!schedules_)
             throw std::logic_error(
                 "Schedules were not created before calling quarantine_schedule()");
-        return quarantine_schedule_;
+        return schedules_->quarantine;
     }
 
     const std::vector<bool>& output_schedule() const
     {
-        if (!schedules_created_)
+        if (!schedules_)
             throw std::logic_error(
                 "Schedules were not created before calling output_schedule()");
-        return output_schedule_;
+        return schedules_->output;
+    }
+
+    /**
+     * Returns mortality step (year) of a simulation step.
+     *
+     * Same as simulation_step_to_action_step() with mortality_schedule(),
+     * but the steps are precomputed with the schedules.
+     */
+    unsigned mortality_action_step(unsigned step) const
+    {
+        if (!schedules_)
+            throw std::logic_error(
+                "Schedules were not created before calling mortality_action_step()");
+        return schedules_->mortality_action_steps.at(step);
+    }
+
+    /** Returns lethal temperature step of a simulation step */
+    unsigned lethal_action_step(unsigned step) const
+    {
+        if (!use_lethal_temperature)
+            throw std::logic_error(
+                "lethal_action_step() not available when use_lethal_temperature is "
+                "false");
+        if (!schedules_)
+            throw std::logic_error(
+                "Schedules were not created before calling lethal_action_step()");
+        return schedules_->lethal_action_steps.at(step);
+    }
+
+    /** Returns spread rate step of a simulation step */
+    unsigned spread_rate_action_step(unsigned step) const
+    {
+        if (!use_spreadrates)
+            throw std::logic_error(
+                "spread_rate_action_step() not available when use_spreadrates is "
+                "false");
+        if (!schedules_)
+            throw std::logic_error(
+                "Schedules were not created before calling spread_rate_action_step()");
+        return schedules_->spread_rate_action_steps.at(step);
+    }
+
+    /** Returns quarantine escape step of a simulation step */
+    unsigned quarantine_action_step(unsigned step) const
+    {
+        if (!use_quarantine)
+            throw std::logic_error(
+                "quarantine_action_step() not available when use_quarantine is false");
+        if (!schedules_)
+            throw std::logic_error(
+                "Schedules were not created before calling quarantine_action_step()");
+        return schedules_->quarantine_action_steps.at(step);
     }
 
     unsigned num_mortality_years()
     {
-        if (!schedules_created_)
+        if (!schedules_)
             throw std::logic_error(
                 "Schedules were not created before calling num_mortality_years()");
-        return get_number_of_scheduled_actions(mortality_schedule_);
+        return get_number_of_scheduled_actions(schedules_->mortality);
     }
 
     unsigned num_lethal()
@@ -188,10 +388,10 @@ public:
         if (!use_lethal_temperature)
             throw std::logic_error(
                 "num_lethal() not available when use_lethal_temperature is false");
-        if (!schedules_created_)
+        if (!schedules_)
             throw std::logic_error(
                 "Schedules were not created before calling num_lethal()");
-        return get_number_of_scheduled_actions(lethal_schedule_);
+        return get_number_of_scheduled_actions(schedules_->lethal);
     }
 
     unsigned rate_num_steps()
@@ -199,10 +399,10 @@ public:
         if (!use_spreadrates)
             throw std::logic_error(
                 "rate_num_steps() not available when use_spreadrates is false");
-        if (!schedules_created_)
+        if (!schedules_)
             throw std::logic_error(
                 "Schedules were not created before calling rate_num_steps()");
-        return get_number_of_scheduled_actions(spread_rate_schedule_);
+        return get_number_of_scheduled_actions(schedules_->spread_rate);
     }
 
     unsigned quarantine_num_steps()
@@ -210,10 +410,10 @@ public:
         if (!use_quarantine)
             throw std::logic_error(
                 "quarantine_num_steps() not available when use_quarantine is false");
-        if (!schedules_created_)
+        if (!schedules_)
             throw std::logic_error(
                 "Schedules were not created before calling quarantine_num_steps()");
-        return get_number_of_scheduled_actions(quarantine_schedule_);
+        return get_number_of_scheduled_actions(schedules_->quarantine);
     }
 
     const Date& date_start() const
@@ -286,15 +486,37 @@ private:
     StepUnit step_unit_{StepUnit::Day};
     unsigned step_num_units_{1};
 
-    Scheduler scheduler_{date_start_, date_end_, step_unit_, step_num_units_};
-    bool schedules_created_{false};
+    std::shared_ptr<const ConfigSchedules> schedules_;
 
-    std::vector<bool> spread_schedule_;
-    std::vector<bool> output_schedule_;
-    std::vector<bool> mortality_schedule_;
-    std::vector<bool> lethal_schedule_;
-    std::vector<bool> spread_rate_schedule_;
-    std::vector<bool> quarantine_schedule_;
+    std::shared_ptr<const ConfigSchedules> compute_schedules() const
+    {
+        auto schedules = std::make_shared<ConfigSchedules>(
+            Scheduler(date_start_, date_end_, step_unit_, step_num_units_));
+        const Scheduler& scheduler = schedules->scheduler;
+        schedules->spread =
+            scheduler.schedule_spread(Season(season_start_month_, season_end_month_));
+        schedules->output =
+            schedule_from_string(scheduler, output_frequency, output_frequency_n);
+        schedules->mortality = scheduler.schedule_action_end_of_year();
+        if (use_lethal_temperature)
+            schedules->lethal =
+                scheduler.schedule_action_yearly(lethal_temperature_month, 1);
+        if (use_spreadrates)
+            schedules->spread_rate = schedule_from_string(
+                scheduler, spreadrate_frequency, spreadrate_frequency_n);
+        if (use_quarantine)
+            schedules->quarantine = schedule_from_string(
+                scheduler, quarantine_frequency, quarantine_frequency_n);
+        schedules->mortality_action_steps =
+            simulation_steps_to_action_steps(schedules->mortality);
+        schedules->lethal_action_steps =
+            simulation_steps_to_action_steps(schedules->lethal);
+        schedules->spread_rate_action_steps =
+            simulation_steps_to_action_steps(schedules->spread_rate);
+        schedules->quarantine_action_steps =
+            simulation_steps_to_action_steps(schedules->quarantine);
+        return schedules;
+    }
 };
 
 }  // namespace pops
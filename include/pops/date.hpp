@@ -36,9 +36,14 @@ private:
     int year_;
     int month_;
     int day_;
-    int day_in_month[2][13] = {
-        {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31},
-        {0, 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31}};
+    /** Number of days in a month (1-12) in a non-leap or leap year */
+    static int day_in_month(bool leap_year, int month)
+    {
+        static const int days[2][13] = {
+            {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31},
+            {0, 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31}};
+        return days[leap_year][month];
+    }
 
 public:
     Date(const Date& d) : year_(d.year_), month_(d.month_), day_(d.day_) {}
@@ -52,6 +57,8 @@ public:
     inline void add_days(unsigned n);
     inline void subtract_day();
     inline void subtract_days(unsigned n);
+    inline int day_number() const;
+    static inline Date from_day_number(int day_number);
     inline Date get_year_end();
     inline Date get_next_year_end();
     inline Date get_last_day_of_week();
@@ -61,7 +68,7 @@ public:
     inline bool is_last_day_of_year();
     inline bool is_last_day_of_month();
     inline bool is_last_week_of_month();
-    inline bool is_leap_year();
+    inline bool is_leap_year() const;
     inline std::string to_string();
     int month() const
     {
@@ -102,7 +109,7 @@ Date::Date(std::string date)
     month_ = std::stoi(date.substr(0, pos));
     date.erase(0, pos + 1);
     day_ = std::stoi(date);
-    if (month_ <= 0 || month_ > 12 || day_ > day_in_month[1][month_])
+    if (month_ <= 0 || month_ > 12 || day_ > day_in_month(1, month_))
         throw std::invalid_argument("Invalid date specified");
 }
 
@@ -112,6 +119,49 @@ std::ostream& operator<<(std::ostream& os, const Date& d)
     return os;
 }
 
+/*!
+ * \brief Get the date as a serial day number
+ *
+ * The day number is the number of days since 1970-01-01 (negative
+ * for earlier dates) in the proleptic Gregorian calendar, so the number
+ * of days between two dates is a difference of their day numbers.
+ *
+ * The conversion is constant time (algorithm by Howard Hinnant).
+ */
+int Date::day_number() const
+{
+    int year = month_ <= 2 ? year_ - 1 : year_;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int year_of_era = year - era * 400;
+    // day of year counted from March 1 so that leap day is the last one
+    int day_of_year = (153 * (month_ > 2 ? month_ - 3 : month_ + 9) + 2) / 5 + day_ - 1;
+    int day_of_era =
+        year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+/*!
+ * \brief Create date from a serial day number
+ *
+ * This is the inverse of day_number().
+ */
+Date Date::from_day_number(int day_number)
+{
+    int days = day_number + 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int day_of_era = days - era * 146097;
+    int year_of_era =
+        (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096)
+        / 365;
+    int day_of_year =
+        day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    int month_from_march = (5 * day_of_year + 2) / 153;
+    int day = day_of_year - (153 * month_from_march + 2) / 5 + 1;
+    int month = month_from_march < 10 ? month_from_march + 3 : month_from_march - 9;
+    int year = year_of_era + era * 400 + (month <= 2 ? 1 : 0);
+    return Date(year, month, day);
+}
+
 Date Date::get_year_end()
 {
     return Date(year_, 12, 31);
@@ -133,7 +183,7 @@ Date Date::get_last_day_of_week()
             d.year_--;
             d.month_ = 12;
         }
-        d.day_ = day_in_month[is_leap_year()][d.month_];
+        d.day_ = day_in_month(is_leap_year(), d.month_);
     }
     return d;
 }
@@ -144,8 +194,8 @@ Date Date::get_last_day_of_week()
 Date Date::get_last_day_of_month()
 {
     if (this->is_leap_year())
-        return Date(year_, month_, day_in_month[1][month_]);
-    return Date(year_, month_, day_in_month[0][month_]);
+        return Date(year_, month_, day_in_month(1, month_));
+    return Date(year_, month_, day_in_month(0, month_));
 }
 
 bool Date::is_last_week_of_year()
@@ -172,12 +222,12 @@ bool Date::is_last_day_of_year()
 bool Date::is_last_week_of_month()
 {
     if (this->is_leap_year()) {
-        if ((day_ + 7) >= day_in_month[1][month_])
+        if ((day_ + 7) >= day_in_month(1, month_))
             return true;
         return false;
     }
     else {
-        if ((day_ + 7) >= day_in_month[0][month_])
+        if ((day_ + 7) >= day_in_month(0, month_))
             return true;
         return false;
     }
@@ -186,12 +236,12 @@ bool Date::is_last_week_of_month()
 bool Date::is_last_day_of_month()
 {
     if (this->is_leap_year()) {
-        if (day_ == day_in_month[1][month_])
+        if (day_ == day_in_month(1, month_))
             return true;
         return false;
     }
     else {
-        if (day_ == day_in_month[0][month_])
+        if (day_ == day_in_month(0, month_))
             return true;
         return false;
     }
@@ -205,7 +255,7 @@ Date Date::get_next_year_end()
         return Date(year_ + 1, 12, 31);
 }
 
-bool Date::is_leap_year()
+bool Date::is_leap_year() const
 {
     if (year_ % 4 == 0 && (year_ % 100 != 0 || year_ % 400 == 0))
         return true;
@@ -293,8 +343,8 @@ void Date::increased_by_days(int num_days)
             month_ = 1;
             day_ = 1;
         }
-        if (day_ > day_in_month[1][month_]) {
-            day_ = day_ - day_in_month[1][month_];
+        if (day_ > day_in_month(1, month_)) {
+            day_ = day_ - day_in_month(1, month_);
             month_++;
             if (month_ > 12) {
                 year_++;
@@ -308,8 +358,8 @@ void Date::increased_by_days(int num_days)
             month_ = 1;
             day_ = 1;
         }
-        if (day_ > day_in_month[0][month_]) {
-            day_ = day_ - day_in_month[0][month_];
+        if (day_ > day_in_month(0, month_)) {
+            day_ = day_ - day_in_month(0, month_);
             month_++;
             if (month_ > 12) {
                 year_++;
@@ -333,8 +383,8 @@ void Date::increased_by_week()
             month_ = 1;
             day_ = 1;
         }
-        if (day_ > day_in_month[1][month_]) {
-            day_ = day_ - day_in_month[1][month_];
+        if (day_ > day_in_month(1, month_)) {
+            day_ = day_ - day_in_month(1, month_);
             month_++;
             if (month_ > 12) {
                 year_++;
@@ -348,8 +398,8 @@ void Date::increased_by_week()
             month_ = 1;
             day_ = 1;
         }
-        if (day_ > day_in_month[0][month_]) {
-            day_ = day_ - day_in_month[0][month_];
+        if (day_ > day_in_month(0, month_)) {
+            day_ = day_ - day_in_month(0, month_);
             month_++;
             if (month_ > 12) {
                 year_++;
@@ -367,13 +417,13 @@ void Date::increased_by_month()
         month_ = 1;
     }
     if (this->is_leap_year()) {
-        if (day_ > day_in_month[1][month_]) {
-            day_ = day_in_month[1][month_];
+        if (day_ > day_in_month(1, month_)) {
+            day_ = day_in_month(1, month_);
         }
     }
     else {
-        if (day_ > day_in_month[0][month_]) {
-            day_ = day_in_month[0][month_];
+        if (day_ > day_in_month(0, month_)) {
+            day_ = day_in_month(0, month_);
         }
     }
 }
@@ -383,7 +433,7 @@ void Date::increased_by_month()
 void Date::add_day()
 {
     day_++;
-    if (day_ > day_in_month[is_leap_year()][month_]) {
+    if (day_ > day_in_month(is_leap_year(), month_)) {
         day_ = 1;
         month_++;
         if (month_ > 12) {
@@ -404,7 +454,7 @@ void Date::subtract_day()
             year_--;
             month_ = 12;
         }
-        day_ = day_in_month[is_leap_year()][month_];
+        day_ = day_in_month(is_leap_year(), month_);
     }
 }
 /*!
@@ -412,8 +462,7 @@ void Date::subtract_day()
  */
 void Date::add_days(unsigned n)
 {
-    for (unsigned i = 0; i < n; i++)
-        this->add_day();
+    *this = from_day_number(day_number() + int(n));
 }
 
 /*!
@@ -421,8 +470,7 @@ void Date::add_days(unsigned n)
  */
 void Date::subtract_days(unsigned n)
 {
-    for (unsigned i = 0; i < n; i++)
-        this->subtract_day();
+    *this = from_day_number(day_number() - int(n));
 }
 
 /*!
@@ -437,6 +485,14 @@ int Date::weeks_from_date(Date start)
 {
     int week = 0;
     while (start <= *this) {
+        // A year starting 1/1 has 52 weeks (the last one is longer),
+        // so whole years are skipped at once.
+        if (start.month_ == 1 && start.day_ == 1
+            && Date(start.year_ + 1, 1, 1) <= *this) {
+            week += 52;
+            start.year_++;
+            continue;
+        }
         week++;
         start.increased_by_week();
     }
@@ -16,6 +16,11 @@
 #ifndef POPS_DETERMINISTIC_KERNEL_HPP
 #define POPS_DETERMINISTIC_KERNEL_HPP
 
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 #include <tuple>
 
@@ -43,6 +48,181 @@ using std::ceil;
 using std::abs;
 using std::sqrt;
 
+/**
+ * Computes the probability window of DeterministicDispersalKernel
+ * for the given kernel parameters.
+ *
+ * The window depends only on the parameters, so it can be computed once
+ * and shared by multiple kernels (e.g., in all steps of a simulation).
+ *
+ * Returns null for unsupported kernel types. We allow a kernel object
+ * to be incomplete when it won't be further used. The invalid state
+ * is checked later, in this case using the kernel type.
+ */
+inline std::shared_ptr<const Raster<double>> deterministic_probability_window(
+    DispersalKernelType kernel_type,
+    double dispersal_percentage,
+    double ew_res,
+    double ns_res,
+    double distance_scale,
+    double shape = 1.0)
+{
+    CauchyKernel cauchy(distance_scale);
+    ExponentialKernel exponential(distance_scale);
+    WeibullKernel weibull(distance_scale, shape);
+    LogNormalKernel log_normal(distance_scale);
+    NormalKernel normal(distance_scale);
+    HyperbolicSecantKernel hyperbolic_secant(distance_scale);
+    PowerLawKernel power_law(distance_scale, shape);
+    LogisticKernel logistic(distance_scale);
+    GammaKernel gamma(distance_scale, shape);
+    ExponentialPowerKernel exponential_power(distance_scale, shape);
+    // maximum distance from center cell to outer cells
+    double max_distance{0};
+    if (kernel_type == DispersalKernelType::Cauchy) {
+        max_distance = cauchy.icdf(dispersal_percentage);
+    }
+    else if (kernel_type == DispersalKernelType::Exponential) {
+        max_distance = exponential.icdf(dispersal_percentage);
+    }
+    else if (kernel_type == DispersalKernelType::Weibull) {
+        max_distance = weibull.icdf(dispersal_percentage);
+    }
+    else if (kernel_type == DispersalKernelType::Normal) {
+        max_distance = normal.icdf(dispersal_percentage);
+    }
+    else if (kernel_type == DispersalKernelType::LogNormal) {
+        max_distance = log_normal.icdf(dispersal_percentage);
+    }
+    else if (kernel_type == DispersalKernelType::HyperbolicSecant) {
+        max_distance = hyperbolic_secant.icdf(dispersal_percentage);
+    }
+    else if (kernel_type == DispersalKernelType::PowerLaw) {
+        max_distance = power_law.icdf(dispersal_percentage);
+    }
+    else if (kernel_type == DispersalKernelType::Logistic) {
+        max_distance = logistic.icdf(dispersal_percentage);
+    }
+    else if (kernel_type == DispersalKernelType::Gamma) {
+        max_distance = gamma.icdf(dispersal_percentage);
+    }
+    else if (kernel_type == DispersalKernelType::ExponentialPower) {
+        max_distance = exponential_power.icdf(dispersal_percentage);
+    }
+    else {
+        return nullptr;
+    }
+    int number_of_columns = ceil(max_distance / ew_res) * 2 + 1;
+    int number_of_rows = ceil(max_distance / ns_res) * 2 + 1;
+    std::shared_ptr<Raster<double>> probability(
+        new Raster<double>(number_of_rows, number_of_columns, 0));
+    int mid_row = number_of_rows / 2;
+    int mid_col = number_of_columns / 2;
+    double sum = 0.0;
+    for (int i = 0; i < number_of_rows; i++) {
+        for (int j = 0; j < number_of_columns; j++) {
+            double distance_to_center = std::sqrt(
+                pow((abs(mid_row - i) * ew_res), 2)
+                + pow((abs(mid_col - j) * ns_res), 2));
+            double& value = (*probability)(i, j);
+            // determine probability based on distance
+            if (kernel_type == DispersalKernelType::Cauchy) {
+                value = abs(cauchy.pdf(distance_to_center));
+            }
+            else if (kernel_type == DispersalKernelType::Exponential) {
+                value = abs(exponential.pdf(distance_to_center));
+            }
+            else if (kernel_type == DispersalKernelType::Weibull) {
+                value = abs(weibull.pdf(distance_to_center));
+            }
+            else if (kernel_type == DispersalKernelType::Normal) {
+                value = abs(normal.pdf(distance_to_center));
+            }
+            else if (kernel_type == DispersalKernelType::LogNormal) {
+                value = abs(log_normal.pdf(distance_to_center));
+            }
+            else if (kernel_type == DispersalKernelType::PowerLaw) {
+                value = abs(power_law.pdf(distance_to_center));
+            }
+            else if (kernel_type == DispersalKernelType::HyperbolicSecant) {
+                value = abs(hyperbolic_secant.pdf(distance_to_center));
+            }
+            else if (kernel_type == DispersalKernelType::Logistic) {
+                value = abs(logistic.pdf(distance_to_center));
+            }
+            else if (kernel_type == DispersalKernelType::Gamma) {
+                value = abs(gamma.pdf(distance_to_center));
+            }
+            else if (kernel_type == DispersalKernelType::ExponentialPower) {
+                value = abs(exponential_power.pdf(distance_to_center));
+            }
+            sum += value;
+        }
+    }
+    // normalize based on the sum of all probabilities in the raster
+    *probability /= sum;
+    return probability;
+}
+
+/**
+ * Cache of probability windows of DeterministicDispersalKernel.
+ *
+ * Windows are keyed by all the parameters they depend on, so simulations
+ * with the same kernel parameters (e.g., candidates in calibration) share
+ * one immutable window. The cache can be used from multiple threads.
+ */
+class DeterministicWindowCache
+{
+public:
+    /**
+     * Returns the window for the parameters, computes it if needed.
+     *
+     * See deterministic_probability_window() for details.
+     */
+    std::shared_ptr<const Raster<double>> get(
+        DispersalKernelType kernel_type,
+        double dispersal_percentage,
+        double ew_res,
+        double ns_res,
+        double distance_scale,
+        double shape = 1.0)
+    {
+        Key key(
+            static_cast<int>(kernel_type),
+            dispersal_percentage,
+            ew_res,
+            ns_res,
+            distance_scale,
+            shape);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto search = windows_.find(key);
+            if (search != windows_.end())
+                return search->second;
+        }
+        // Computed without the lock, so other windows can be computed meanwhile.
+        auto window = deterministic_probability_window(
+            kernel_type, dispersal_percentage, ew_res, ns_res, distance_scale, shape);
+        std::lock_guard<std::mutex> lock(mutex_);
+        // If another thread was faster, its window is used.
+        return windows_.insert(std::make_pair(key, window)).first->second;
+    }
+
+    /**
+     * Returns number of windows in the cache.
+     */
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return windows_.size();
+    }
+
+private:
+    typedef std::tuple<int, double, double, double, double, double> Key;
+    std::map<Key, std::shared_ptr<const Raster<double>>> windows_;
+    mutable std::mutex mutex_;
+};
+
 /*!
  * Dispersal kernel for deterministic spread to cell with highest probability of
  * spread
@@ -69,27 +249,12 @@ protected:
     // number of rows/cols in the probability window
     int number_of_rows = 0;
     int number_of_columns = 0;
-    // maximum distance from center cell to outer cells
-    double max_distance{0};
-    Raster<double> probability;
+    // probability window (immutable, can be shared between kernels)
+    std::shared_ptr<const Raster<double>> probability;
     Raster<double> probability_copy;
-    CauchyKernel cauchy;
-    ExponentialKernel exponential;
-    WeibullKernel weibull;
-    LogNormalKernel log_normal;
-    NormalKernel normal;
-    HyperbolicSecantKernel hyperbolic_secant;
-    PowerLawKernel power_law;
-    LogisticKernel logistic;
-    GammaKernel gamma;
-    ExponentialPowerKernel exponential_power;
 
     DispersalKernelType kernel_type_;
-    double proportion_of_dispersers;
-    // the west-east resolution of the pixel
-    double east_west_resolution;
-    // the north-south resolution of the pixel
-    double north_south_resolution;
+    double proportion_of_dispersers{0};
 
 public:
     DeterministicDispersalKernel(
@@ -100,108 +265,38 @@ public:
         double ns_res,
         double distance_scale,
         double shape = 1.0)
+        : DeterministicDispersalKernel(
+            dispersal_kernel,
+            dispersers,
+            deterministic_probability_window(
+                dispersal_kernel,
+                dispersal_percentage,
+                ew_res,
+                ns_res,
+                distance_scale,
+                shape))
+    {}
+
+    /**
+     * Creates the kernel with a probability window created by
+     * deterministic_probability_window() (possibly shared with other kernels).
+     *
+     * The window can be null if the kernel won't be used.
+     */
+    DeterministicDispersalKernel(
+        DispersalKernelType dispersal_kernel,
+        const IntegerRaster& dispersers,
+        std::shared_ptr<const Raster<double>> probability_window)
         : dispersers_(dispersers),
-          cauchy(distance_scale),
-          exponential(distance_scale),
-          weibull(distance_scale, shape),
-          log_normal(distance_scale),
-          normal(distance_scale),
-          hyperbolic_secant(distance_scale),
-          power_law(distance_scale, shape),
-          logistic(distance_scale),
-          gamma(distance_scale, shape),
-          exponential_power(distance_scale, shape),
-          kernel_type_(dispersal_kernel),
-          east_west_resolution(ew_res),
-          north_south_resolution(ns_res)
+          probability(probability_window),
+          kernel_type_(dispersal_kernel)
     {
-        // We initialize max distance only for the supported kernels.
-        // For the others, we report the error only when really called
-        // to allow use of this class in initialization phase.
-        if (kernel_type_ == DispersalKernelType::Cauchy) {
-            max_distance = cauchy.icdf(dispersal_percentage);
-        }
-        else if (kernel_type_ == DispersalKernelType::Exponential) {
-            max_distance = exponential.icdf(dispersal_percentage);
-        }
-        else if (kernel_type_ == DispersalKernelType::Weibull) {
-            max_distance = weibull.icdf(dispersal_percentage);
-        }
-        else if (kernel_type_ == DispersalKernelType::Normal) {
-            max_distance = normal.icdf(dispersal_percentage);
-        }
-        else if (kernel_type_ == DispersalKernelType::LogNormal) {
-            max_distance = log_normal.icdf(dispersal_percentage);
-        }
-        else if (kernel_type_ == DispersalKernelType::HyperbolicSecant) {
-            max_distance = hyperbolic_secant.icdf(dispersal_percentage);
-        }
-        else if (kernel_type_ == DispersalKernelType::PowerLaw) {
-            max_distance = power_law.icdf(dispersal_percentage);
-        }
-        else if (kernel_type_ == DispersalKernelType::Logistic) {
-            max_distance = logistic.icdf(dispersal_percentage);
-        }
-        else if (kernel_type_ == DispersalKernelType::Gamma) {
-            max_distance = gamma.icdf(dispersal_percentage);
-        }
-        else if (kernel_type_ == DispersalKernelType::ExponentialPower) {
-            max_distance = exponential_power.icdf(dispersal_percentage);
-        }
-        else {
-            // We allow a kernel object to be incomplete when it won't be further used.
-            // The invalid state is checked later, in this case using the kernel type.
+        if (!probability)
             return;
-        }
-        number_of_columns = ceil(max_distance / east_west_resolution) * 2 + 1;
-        number_of_rows = ceil(max_distance / north_south_resolution) * 2 + 1;
-        Raster<double> prob_size(number_of_rows, number_of_columns, 0);
-        probability = prob_size;
-        probability_copy = prob_size;
+        number_of_rows = probability->rows();
+        number_of_columns = probability->cols();
         mid_row = number_of_rows / 2;
         mid_col = number_of_columns / 2;
-        double sum = 0.0;
-        for (int i = 0; i < number_of_rows; i++) {
-            for (int j = 0; j < number_of_columns; j++) {
-                double distance_to_center = std::sqrt(
-                    pow((abs(mid_row - i) * east_west_resolution), 2)
-                    + pow((abs(mid_col - j) * north_south_resolution), 2));
-                // determine probability based on distance
-                if (kernel_type_ == DispersalKernelType::Cauchy) {
-                    probability(i, j) = abs(cauchy.pdf(distance_to_center));
-                }
-                else if (kernel_type_ == DispersalKernelType::Exponential) {
-                    probability(i, j) = abs(exponential.pdf(distance_to_center));
-                }
-                else if (kernel_type_ == DispersalKernelType::Weibull) {
-                    probability(i, j) = abs(weibull.pdf(distance_to_center));
-                }
-                else if (kernel_type_ == DispersalKernelType::Normal) {
-                    probability(i, j) = abs(normal.pdf(distance_to_center));
-                }
-                else if (kernel_type_ == DispersalKernelType::LogNormal) {
-                    probability(i, j) = abs(log_normal.pdf(distance_to_center));
-                }
-                else if (kernel_type_ == DispersalKernelType::PowerLaw) {
-                    probability(i, j) = abs(power_law.pdf(distance_to_center));
-                }
-                else if (kernel_type_ == DispersalKernelType::HyperbolicSecant) {
-                    probability(i, j) = abs(hyperbolic_secant.pdf(distance_to_center));
-                }
-                else if (kernel_type_ == DispersalKernelType::Logistic) {
-                    probability(i, j) = abs(logistic.pdf(distance_to_center));
-                }
-                else if (kernel_type_ == DispersalKernelType::Gamma) {
-                    probability(i, j) = abs(gamma.pdf(distance_to_center));
-                }
-                else if (kernel_type_ == DispersalKernelType::ExponentialPower) {
-                    probability(i, j) = abs(exponential_power.pdf(distance_to_center));
-                }
-                sum += probability(i, j);
-            }
-        }
-        // normalize based on the sum of all probabilities in the raster
-        probability /= sum;
     }
 
     /*! Generates a new position for the spread.
@@ -231,10 +326,13 @@ public:
             throw std::invalid_argument(
                 "DeterministicDispersalKernel: Unsupported dispersal kernel type");
         }
+        if (!probability)
+            throw std::logic_error(
+                "DeterministicDispersalKernel: Probability window is missing");
         // reset the window if considering a new cell
         if (row != prev_row || col != prev_col) {
             proportion_of_dispersers = 1.0 / (double)dispersers_(row, col);
-            probability_copy = probability;
+            probability_copy = *probability;
         }
 
         int row_movement = 0;
@@ -268,6 +366,21 @@ public:
         return std::make_tuple(row + row_movement, col + col_movement);
     }
 
+    /*! \copydoc RadialDispersalKernel::sample()
+     */
+    template<class Generator>
+    void sample(
+        Generator& generator,
+        int row,
+        int col,
+        int count,
+        std::vector<std::tuple<int, int>>& targets)
+    {
+        targets.resize(count);
+        for (auto& target : targets)
+            target = (*this)(generator, row, col);
+    }
+
     /*! Returns true if the kernel class support a given kernel type
      *
      * \warning This function is experimental and may be removed or
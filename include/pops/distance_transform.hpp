@@ -0,0 +1,108 @@
+/*
+ * PoPS model - Euclidean distance transform
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_DISTANCE_TRANSFORM_HPP
+#define POPS_DISTANCE_TRANSFORM_HPP
+
+#include <limits>
+#include <vector>
+
+namespace pops {
+
+/**
+ * Finds the nearest feature cell for each cell of a grid.
+ *
+ * Uses the exact Euclidean distance transform by Felzenszwalb and
+ * Huttenlocher which is separable, i.e., it is computed first along
+ * columns and then along rows, so it is linear in the number of cells.
+ * Distances are between cell centers and the spacing of rows and columns
+ * can differ (e.g., north-south and west-east resolution).
+ *
+ * The *is_feature* function is called as `is_feature(row, col)` for each
+ * cell of the grid and returns true for feature cells.
+ *
+ * Returns a vector with the index (`row * cols + col`) of the nearest feature
+ * for each cell in row-major order or -1 if there are no features.
+ * Ties are resolved consistently, but not in any particular direction.
+ */
+template<typename IsFeature>
+std::vector<int> nearest_feature_cells(
+    int rows, int cols, double row_spacing, double col_spacing, IsFeature is_feature)
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+    std::vector<int> nearest(rows * cols, -1);
+    // nearest feature row in the same column for each cell
+    std::vector<int> nearest_rows(rows * cols, -1);
+    for (int c = 0; c < cols; ++c) {
+        int last = -1;
+        for (int r = 0; r < rows; ++r) {
+            if (is_feature(r, c))
+                last = r;
+            nearest_rows[r * cols + c] = last;
+        }
+        last = -1;
+        for (int r = rows - 1; r >= 0; --r) {
+            // The downward pass found a feature in this row only if it is one.
+            if (nearest_rows[r * cols + c] == r)
+                last = r;
+            int& row = nearest_rows[r * cols + c];
+            if (last >= 0 && (row < 0 || last - r < r - row))
+                row = last;
+        }
+    }
+    // lower envelope of parabolas along each row
+    std::vector<double> heights(cols);
+    std::vector<int> vertices(cols);
+    std::vector<double> bounds(cols + 1);
+    for (int r = 0; r < rows; ++r) {
+        int num_vertices = 0;
+        for (int c = 0; c < cols; ++c) {
+            int row = nearest_rows[r * cols + c];
+            if (row < 0)
+                continue;
+            double dy = (row - r) * row_spacing;
+            heights[c] = dy * dy;
+            double x = c * col_spacing;
+            double start = -infinity;
+            while (num_vertices > 0) {
+                int v = vertices[num_vertices - 1];
+                double xv = v * col_spacing;
+                start =
+                    ((heights[c] + x * x) - (heights[v] + xv * xv)) / (2 * (x - xv));
+                if (start > bounds[num_vertices - 1])
+                    break;
+                --num_vertices;
+                start = -infinity;
+            }
+            vertices[num_vertices] = c;
+            bounds[num_vertices] = start;
+            bounds[num_vertices + 1] = infinity;
+            ++num_vertices;
+        }
+        if (!num_vertices)
+            continue;
+        int k = 0;
+        for (int c = 0; c < cols; ++c) {
+            double x = c * col_spacing;
+            while (bounds[k + 1] < x)
+                ++k;
+            int v = vertices[k];
+            nearest[r * cols + c] = nearest_rows[r * cols + v] * cols + v;
+        }
+    }
+    return nearest;
+}
+
+}  // namespace pops
+
+#endif  // POPS_DISTANCE_TRANSFORM_HPP
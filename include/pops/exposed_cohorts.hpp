@@ -0,0 +1,167 @@
+/*
+ * PoPS model - sparse storage of exposed hosts
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_EXPOSED_COHORTS_HPP
+#define POPS_EXPOSED_COHORTS_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace pops {
+
+/**
+ * Exposed hosts stored as lists of cells, one list for each step
+ * of the latency period.
+ *
+ * This is an alternative to the vector of exposed rasters used with
+ * Simulation::disperse_and_infect(), Simulation::infect_exposed(),
+ * and Treatments::manage() in the SEI model. A vector of rasters needs
+ * the latency period plus one full rasters and each step goes through
+ * a whole raster. Here, each cohort (hosts exposed in one step) is
+ * a list of cells with non-zero number of exposed hosts, so the memory
+ * and work are proportional to the number of cells with newly exposed
+ * hosts rather than to the latency period times the size of the rasters.
+ *
+ * Hosts exposed in the current step (the youngest cohort) are counted
+ * in one dense array which is accessed by row and column like a raster,
+ * so the object can be passed to Simulation::disperse() as
+ * *exposed_or_infected*. The cells of the array which were used are
+ * tracked, so storing the youngest cohort as a list of cells visits only
+ * these cells.
+ *
+ * The cohorts form a ring of latency period plus one items.
+ * The oldest cohort is the one which becomes infected next.
+ */
+class ExposedCohorts
+{
+public:
+    /** Number of exposed hosts in one cell */
+    struct Cell
+    {
+        int row;
+        int col;
+        int count;
+    };
+
+    /** Creates empty cohorts for a latency period given in steps */
+    ExposedCohorts(int rows, int cols, unsigned latency_period)
+        : rows_(rows), cols_(cols), cohorts_(latency_period + 1), oldest_(0)
+    {
+        if (rows < 0 || cols < 0)
+            throw std::invalid_argument("ExposedCohorts: Size cannot be negative");
+        youngest_counts_.assign(std::size_t(rows) * cols, 0);
+    }
+
+    int rows() const
+    {
+        return rows_;
+    }
+
+    int cols() const
+    {
+        return cols_;
+    }
+
+    unsigned latency_period() const
+    {
+        return cohorts_.size() - 1;
+    }
+
+    /** Number of hosts in the cell exposed in the current step */
+    int operator()(int row, int col) const
+    {
+        return youngest_counts_[std::size_t(row) * cols_ + col];
+    }
+
+    /** Number of hosts in the cell exposed in the current step (modifiable) */
+    int& operator()(int row, int col)
+    {
+        std::size_t index = std::size_t(row) * cols_ + col;
+        // Repeated access to a cell which stays zero adds it again,
+        // but store_youngest() takes only non-zero cells.
+        if (!youngest_counts_[index])
+            youngest_cells_.push_back(index);
+        return youngest_counts_[index];
+    }
+
+    /**
+     * Moves hosts exposed in the current step to the list of cells
+     * of the youngest cohort.
+     */
+    void store_youngest()
+    {
+        auto& youngest = cohorts_[(oldest_ + latency_period()) % cohorts_.size()];
+        for (auto index : youngest_cells_) {
+            int count = youngest_counts_[index];
+            if (!count)
+                continue;
+            youngest_counts_[index] = 0;
+            youngest.push_back({int(index / cols_), int(index % cols_), count});
+        }
+        youngest_cells_.clear();
+    }
+
+    /** Cells of the oldest cohort (hosts which finished the latency period) */
+    std::vector<Cell>& oldest()
+    {
+        return cohorts_[oldest_];
+    }
+
+    /**
+     * Ages all cohorts by one step.
+     *
+     * The oldest cohort becomes the youngest one, so it needs to be empty.
+     * Call store_youngest() before to keep the hosts exposed in the current
+     * step.
+     */
+    void rotate()
+    {
+        if (!cohorts_[oldest_].empty())
+            throw std::logic_error(
+                "ExposedCohorts::rotate: The oldest cohort is not empty");
+        oldest_ = (oldest_ + 1) % cohorts_.size();
+    }
+
+    /**
+     * Calls *function* with row, column, and modifiable count of hosts
+     * for each stored cell of each cohort including the current step.
+     *
+     * The hosts exposed in the current step are stored first
+     * (see store_youngest()), so one cell is visited at least once for each
+     * cohort which has hosts in it.
+     */
+    template<typename CellFunction>
+    void for_each(CellFunction function)
+    {
+        store_youngest();
+        for (auto& cohort : cohorts_)
+            for (auto& cell : cohort)
+                function(cell.row, cell.col, cell.count);
+    }
+
+private:
+    int rows_;
+    int cols_;
+    // ring of cohorts, oldest at oldest_, youngest just before it
+    std::vector<std::vector<Cell>> cohorts_;
+    std::size_t oldest_;
+    // hosts exposed in the current step
+    std::vector<int> youngest_counts_;
+    // cells used in the current step in the order of the first use
+    std::vector<std::size_t> youngest_cells_;
+};
+
+}  // namespace pops
+
+#endif  // POPS_EXPOSED_COHORTS_HPP
@@ -33,9 +33,30 @@
  *
  * ```
  * template<typename Generator>
- * std::tuple<int, int> operator() (Generator& generator)
+ * std::tuple<int, int> operator() (Generator& generator, int row, int col)
  * ```
  *
+ * Simulation samples all dispersers from one cell at once, so the class
+ * also needs to provide a function which fills a vector with *count*
+ * positions (see RadialDispersalKernel::sample()):
+ *
+ * ```
+ * template<typename Generator>
+ * void sample(
+ *     Generator& generator,
+ *     int row,
+ *     int col,
+ *     int count,
+ *     std::vector<std::tuple<int, int>>& targets)
+ * ```
+ *
+ * Optionally, a kernel which can cheaply draw the number of dispersers
+ * going to each cell can provide a `sample_counts()` function with
+ * the same parameters, but with targets of type
+ * `std::vector<std::tuple<int, int, int>>` (row, column, and number
+ * of dispersers). Simulation then uses it instead of sample()
+ * (see AliasDispersalKernel::sample_counts()).
+ *
  * Besides implementation in a class, enum for the different types
  * of kernels needs to be extented as well as function which transforms
  * strings into enum values, i.e., you need to add to the
@@ -0,0 +1,105 @@
+/*
+ * PoPS model - cells with lethal temperature
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_LETHAL_TEMPERATURE_HPP
+#define POPS_LETHAL_TEMPERATURE_HPP
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace pops {
+
+/**
+ * Cells with lethal temperature for each lethal temperature step.
+ *
+ * Simulation::remove() with a temperature raster compares the temperature
+ * with the lethal temperature in every suitable cell. Here, the comparison
+ * is done once for all the temperature rasters and only the suitable cells
+ * with temperature under the lethal temperature are kept. The removal then
+ * visits only these cells and the temperature rasters don't need to be kept.
+ *
+ * The object is not modified by the simulation, so one object can be used
+ * by multiple simulations (e.g., replicates or scenarios) with the same
+ * temperatures, lethal temperature, and suitable cells.
+ *
+ * It can be passed to Model::run_step() instead of the temperature rasters.
+ */
+class LethalTemperatureCells
+{
+public:
+    /** Cell with lethal temperature */
+    struct Cell
+    {
+        int row;
+        int col;
+    };
+
+    /** Creates object with no lethal temperature steps */
+    LethalTemperatureCells()
+        : lethal_temperature_(std::numeric_limits<double>::quiet_NaN())
+    {}
+
+    /**
+     * Finds cells with temperature under *lethal_temperature*
+     * in each of the *temperatures* (one raster for each lethal step).
+     *
+     * Only *suitable_cells* are considered and their order is kept.
+     */
+    template<typename FloatRaster>
+    LethalTemperatureCells(
+        const std::vector<FloatRaster>& temperatures,
+        double lethal_temperature,
+        const std::vector<std::vector<int>>& suitable_cells)
+        : lethal_temperature_(lethal_temperature)
+    {
+        steps_.reserve(temperatures.size());
+        for (const auto& temperature : temperatures) {
+            steps_.emplace_back();
+            auto& cells = steps_.back();
+            for (const auto& indices : suitable_cells) {
+                int i = indices[0];
+                int j = indices[1];
+                if (temperature(i, j) < lethal_temperature)
+                    cells.push_back({i, j});
+            }
+            cells.shrink_to_fit();
+        }
+    }
+
+    /** Lethal temperature used to find the cells */
+    double lethal_temperature() const
+    {
+        return lethal_temperature_;
+    }
+
+    /** Number of lethal temperature steps */
+    std::size_t size() const
+    {
+        return steps_.size();
+    }
+
+    /** Cells with lethal temperature in the given lethal temperature step */
+    const std::vector<Cell>& operator[](std::size_t lethal_step) const
+    {
+        return steps_[lethal_step];
+    }
+
+private:
+    double lethal_temperature_;
+    std::vector<std::vector<Cell>> steps_;
+};
+
+}  // namespace pops
+
+#endif  // POPS_LETHAL_TEMPERATURE_HPP
@@ -29,9 +29,13 @@
 #include "spread_rate.hpp"
 #include "simulation.hpp"
 #include "kernel.hpp"
+#include "movements.hpp"
 #include "scheduling.hpp"
 #include "quarantine.hpp"
 
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 
 namespace pops {
@@ -47,10 +51,44 @@ private:
     DeterministicNeighborDispersalKernel natural_neighbor_kernel;
     DeterministicNeighborDispersalKernel anthro_neighbor_kernel;
     Simulation<IntegerRaster, FloatRaster, RasterIndex> simulation_;
-    unsigned last_index{0};
+    // Probability windows of deterministic kernels (null when not deterministic)
+    std::shared_ptr<const Raster<double>> natural_window_;
+    std::shared_ptr<const Raster<double>> anthro_window_;
+    // Created from the movements passed to run_step() when they change.
+    MovementTable<RasterIndex> movement_table_;
+    // Copy of the movements the table was created from
+    std::vector<std::vector<int>> movements_;
+    bool movement_table_created_{false};
+    // Extent of infection updated during the steps (if set)
+    InfectionExtent* infection_extent_{nullptr};
 
-public:
-    Model(const Config& config)
+    /**
+     * Creates probability window of a deterministic kernel, uses the cache
+     * if provided.
+     */
+    std::shared_ptr<const Raster<double>> deterministic_window(
+        DispersalKernelType kernel_type,
+        double scale,
+        DeterministicWindowCache* window_cache)
+    {
+        if (window_cache)
+            return window_cache->get(
+                kernel_type,
+                config_.dispersal_percentage,
+                config_.ew_res,
+                config_.ns_res,
+                scale,
+                config_.shape);
+        return deterministic_probability_window(
+            kernel_type,
+            config_.dispersal_percentage,
+            config_.ew_res,
+            config_.ns_res,
+            scale,
+            config_.shape);
+    }
+
+    Model(const Config& config, DeterministicWindowCache* window_cache)
         : config_(config),
           natural_kernel(kernel_type_from_string(config.natural_kernel_type)),
           anthro_kernel(kernel_type_from_string(config.anthro_kernel_type)),
@@ -65,9 +103,78 @@ public:
               config.latency_period_steps,
               config.generate_stochasticity,
               config.establishment_stochasticity,
-              config.movement_stochasticity)
+              config.movement_stochasticity,
+              config.two_phase_establishment)
+    {
+        // The windows don't change during the simulation, so they are created
+        // only once.
+        if (config_.deterministic) {
+            natural_window_ = deterministic_window(
+                natural_kernel, config_.natural_scale, window_cache);
+            anthro_window_ = deterministic_window(
+                anthro_kernel, config_.anthro_scale, window_cache);
+        }
+    }
+
+    /** Removes infected hosts using temperature rasters (one per lethal step) */
+    void remove_lethal(
+        IntegerRaster& infected,
+        IntegerRaster& susceptible,
+        const std::vector<FloatRaster>& temperatures,
+        int lethal_step,
+        const std::vector<std::vector<int>>& suitable_cells)
+    {
+        simulation_.remove(
+            infected,
+            susceptible,
+            temperatures[lethal_step],
+            config_.lethal_temperature,
+            suitable_cells);
+    }
+
+    /** Removes infected hosts in precomputed cells with lethal temperature */
+    void remove_lethal(
+        IntegerRaster& infected,
+        IntegerRaster& susceptible,
+        const LethalTemperatureCells& temperatures,
+        int lethal_step,
+        const std::vector<std::vector<int>>& suitable_cells)
+    {
+        UNUSED(suitable_cells);  // Cells were selected when created.
+        if (!(temperatures.lethal_temperature() == config_.lethal_temperature))
+            throw std::invalid_argument(
+                "Model: Lethal temperature cells were created with a different"
+                " lethal temperature");
+        simulation_.remove(infected, susceptible, temperatures[lethal_step]);
+    }
+
+public:
+    Model(const Config& config) : Model(config, nullptr) {}
+
+    /**
+     * Creates the model with probability windows of deterministic kernels
+     * taken from a cache, so that they can be shared with other models
+     * using the same kernel parameters.
+     */
+    Model(const Config& config, DeterministicWindowCache& window_cache)
+        : Model(config, &window_cache)
     {}
 
+    /**
+     * Sets extent of infection to update whenever infected hosts change
+     * in run_step().
+     *
+     * The extent needs to be created from the infected hosts later passed
+     * to run_step() (see Simulation::set_infection_extent()). The spread rate
+     * is then computed from the extent instead of scanning the infected hosts.
+     * The extent is not owned by the model. Null stops the updates.
+     */
+    void set_infection_extent(InfectionExtent* extent)
+    {
+        infection_extent_ = extent;
+        simulation_.set_infection_extent(extent);
+    }
+
     /**
      * @brief Run one step of the simulation.
      *
@@ -91,46 +198,48 @@ public:
      * @param[in,out] susceptible Susceptible hosts
      * @param[in,out] total_populations All host and non-host individuals in the area
      * @param[out] dispersers Dispersing individuals (used internally)
-     * @param exposed[in,out] Exposed hosts (if SEI model is active)
+     * @param exposed[in,out] Exposed hosts (if SEI model is active), a vector
+     * of rasters (one for each cohort) or ExposedCohorts
      * @param mortality_tracker[in,out] Mortality tracker used to generate *died*
      * @param died[out] Infected hosts which died this step based on the mortality
      * schedule
      * @param temperatures[in] Vector of temperatures used to evaluate lethal
-     * temperature
+     * temperature or LethalTemperatureCells created from them
      * @param weather_coefficient[in] Weather coefficient (for the current step)
      * @param treatments[in,out] Treatments to be applied (also tracks use of
      * treatments)
      * @param resistant[in,out] Resistant hosts (host temporarily removed from
      * susceptible hosts)
      * @param outside_dispersers[in,out] Dispersers escaping the rasters (adds to the
-     * vector)
+     * vector with one item per disperser or to AggregatedOutsideDispersers)
      * @param spread_rate[in,out] Spread rate tracker
      * @param quarantine[in,out] Quarantine escape tracker
      * @param quarantine_areas[in] Quarantine areas
-     * @param movements[in] Table of host movements
+     * @param movements[in] Table of host movements (see MovementTable)
      *
      * @note The parameters roughly correspond to Simulation::disperse()
      * and Simulation::disperse_and_infect() functions, so these can be used
      * for further reference.
      */
+    template<typename OutsideDispersers, typename Exposed, typename Temperatures>
     void run_step(
         int step,
         IntegerRaster& infected,
         IntegerRaster& susceptible,
         IntegerRaster& total_populations,
         IntegerRaster& dispersers,
-        std::vector<IntegerRaster>& exposed,
+        Exposed& exposed,
         std::vector<IntegerRaster>& mortality_tracker,
         IntegerRaster& died,
-        const std::vector<FloatRaster>& temperatures,
+        const Temperatures& temperatures,
         const FloatRaster& weather_coefficient,
         Treatments<IntegerRaster, FloatRaster>& treatments,
         IntegerRaster& resistant,
-        std::vector<std::tuple<int, int>>& outside_dispersers,  // out
+        OutsideDispersers& outside_dispersers,  // out
         SpreadRate<IntegerRaster>& spread_rate,  // out
         QuarantineEscape<IntegerRaster>& quarantine,  // out
         const IntegerRaster& quarantine_areas,
-        const std::vector<std::vector<int>> movements,
+        const MovementTable<RasterIndex>& movements,
         const std::vector<std::vector<int>>& suitable_cells)
     {
         RadialDispersalKernel<IntegerRaster> natural_radial_kernel(
@@ -150,21 +259,9 @@ public:
             config_.anthro_kappa,
             config_.shape);
         DeterministicDispersalKernel<IntegerRaster> natural_deterministic_kernel(
-            natural_kernel,
-            dispersers,
-            config_.dispersal_percentage,
-            config_.ew_res,
-            config_.ns_res,
-            config_.natural_scale,
-            config_.shape);
+            natural_kernel, dispersers, natural_window_);
         DeterministicDispersalKernel<IntegerRaster> anthro_deterministic_kernel(
-            anthro_kernel,
-            dispersers,
-            config_.dispersal_percentage,
-            config_.ew_res,
-            config_.ns_res,
-            config_.anthro_scale,
-            config_.shape);
+            anthro_kernel, dispersers, anthro_window_);
         SwitchDispersalKernel<IntegerRaster> natural_selectable_kernel(
             natural_kernel,
             natural_radial_kernel,
@@ -184,18 +281,12 @@ public:
             anthro_selectable_kernel,
             config_.use_anthropogenic_kernel,
             config_.percent_natural_dispersal);
-        int mortality_simulation_year =
-            simulation_step_to_action_step(config_.mortality_schedule(), step);
+        int mortality_simulation_year = config_.mortality_action_step(step);
         // removal of dispersers due to lethal temperatures
         if (config_.use_lethal_temperature && config_.lethal_schedule()[step]) {
-            int lethal_step =
-                simulation_step_to_action_step(config_.lethal_schedule(), step);
-            simulation_.remove(
-                infected,
-                susceptible,
-                temperatures[lethal_step],
-                config_.lethal_temperature,
-                suitable_cells);
+            int lethal_step = config_.lethal_action_step(step);
+            remove_lethal(
+                infected, susceptible, temperatures, lethal_step, suitable_cells);
         }
         // actual spread
         if (config_.spread_schedule()[step]) {
@@ -232,22 +323,36 @@ public:
                     config_.overpopulation_percentage,
                     config_.leaving_percentage);
             }
-            if (config_.use_movements) {
-                last_index = simulation_.movement(
+            if (config_.use_movements && config_.use_batched_movements) {
+                simulation_.batched_movement(
                     infected,
                     susceptible,
                     mortality_tracker[mortality_simulation_year],
                     total_populations,
                     step,
-                    last_index,
                     movements,
-                    config_.movement_schedule);
+                    config_.num_threads);
+            }
+            else if (config_.use_movements) {
+                simulation_.movement(
+                    infected,
+                    susceptible,
+                    mortality_tracker[mortality_simulation_year],
+                    total_populations,
+                    step,
+                    movements);
             }
         }
         // treatments
         if (config_.use_treatments) {
             bool managed = treatments.manage(
-                step, infected, exposed, susceptible, resistant, suitable_cells);
+                step,
+                infected,
+                exposed,
+                susceptible,
+                resistant,
+                suitable_cells,
+                infection_extent_);
             if (managed && config_.use_mortality) {
                 // same conditions as the mortality code below
                 // TODO: make the mortality timing available as a separate function in
@@ -286,18 +391,82 @@ public:
         }
         // compute spread rate
         if (config_.use_spreadrates && config_.spread_rate_schedule()[step]) {
-            unsigned rates_step =
-                simulation_step_to_action_step(config_.spread_rate_schedule(), step);
-            spread_rate.compute_step_spread_rate(infected, rates_step, suitable_cells);
+            unsigned rates_step = config_.spread_rate_action_step(step);
+            if (infection_extent_)
+                spread_rate.compute_step_spread_rate(*infection_extent_, rates_step);
+            else
+                spread_rate.compute_step_spread_rate(
+                    infected, rates_step, suitable_cells);
         }
         // compute quarantine escape
         if (config_.use_quarantine && config_.quarantine_schedule()[step]) {
-            unsigned action_step =
-                simulation_step_to_action_step(config_.quarantine_schedule(), step);
+            unsigned action_step = config_.quarantine_action_step(step);
             quarantine.infection_escape_quarantine(
                 infected, quarantine_areas, action_step, suitable_cells);
         }
     }
+
+    /**
+     * @brief Run one step of the simulation with movements as nested vectors.
+     *
+     * The *movements* are combined with the movement schedule from the
+     * configuration into a MovementTable. The table is created again only
+     * when the content of *movements* differs from the one used for the last
+     * table, so passing the same movements for all steps avoids creating
+     * the table in each step (comparing the content is still linear in the
+     * number of movements, pass a MovementTable to the other overload
+     * to avoid that).
+     *
+     * See the other overload for the description of the parameters.
+     */
+    template<typename OutsideDispersers, typename Exposed, typename Temperatures>
+    void run_step(
+        int step,
+        IntegerRaster& infected,
+        IntegerRaster& susceptible,
+        IntegerRaster& total_populations,
+        IntegerRaster& dispersers,
+        Exposed& exposed,
+        std::vector<IntegerRaster>& mortality_tracker,
+        IntegerRaster& died,
+        const Temperatures& temperatures,
+        const FloatRaster& weather_coefficient,
+        Treatments<IntegerRaster, FloatRaster>& treatments,
+        IntegerRaster& resistant,
+        OutsideDispersers& outside_dispersers,  // out
+        SpreadRate<IntegerRaster>& spread_rate,  // out
+        QuarantineEscape<IntegerRaster>& quarantine,  // out
+        const IntegerRaster& quarantine_areas,
+        const std::vector<std::vector<int>>& movements,
+        const std::vector<std::vector<int>>& suitable_cells)
+    {
+        if (config_.use_movements
+            && (!movement_table_created_ || movements_ != movements)) {
+            movement_table_ =
+                MovementTable<RasterIndex>(movements, config_.movement_schedule);
+            movements_ = movements;
+            movement_table_created_ = true;
+        }
+        run_step(
+            step,
+            infected,
+            susceptible,
+            total_populations,
+            dispersers,
+            exposed,
+            mortality_tracker,
+            died,
+            temperatures,
+            weather_coefficient,
+            treatments,
+            resistant,
+            outside_dispersers,
+            spread_rate,
+            quarantine,
+            quarantine_areas,
+            movement_table_,
+            suitable_cells);
+    }
 };
 
 }  // namespace pops
@@ -0,0 +1,280 @@
+/*
+ * PoPS model - table of host movements
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_MOVEMENTS_HPP
+#define POPS_MOVEMENTS_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pops {
+
+/**
+ * Table of host movements (shipments) indexed by simulation step.
+ *
+ * Each movement (record) consists of the source row and column,
+ * the destination row and column, number of hosts moved, and the
+ * simulation step in which the movement happens.
+ *
+ * The records are stored as a structure of arrays (one vector per
+ * column of the table) sorted by step. The records which belong to one
+ * step are accessible by an index range which is obtained in constant
+ * time using step_range(). Records of the same step keep their original
+ * (insertion) order.
+ *
+ * The table is first filled using add() and then finalize() must be
+ * called. Alternatively, the table can be created from the nested
+ * vectors used by Simulation::movement() in which case it is
+ * finalized by the constructor.
+ *
+ * Template parameter RasterIndex is the type used for row and column
+ * indices.
+ */
+template<typename RasterIndex = int>
+class MovementTable
+{
+public:
+    typedef std::size_t SizeType;
+
+    /**
+     * Creates an empty table to be filled using add().
+     */
+    MovementTable() {}
+
+    /**
+     * Creates the table from a list of movements and their schedule.
+     *
+     * @param movements a vector of ints with row_from, col_from, row_to, col_to, and
+     * num_hosts
+     * @param movement_schedule a vector matching movements with the step at which the
+     * movement from movements are applied
+     *
+     * Throws an std::invalid_argument exception if the sizes of the two vectors
+     * differ or if a movement does not have five items.
+     */
+    MovementTable(
+        const std::vector<std::vector<int>>& movements,
+        const std::vector<unsigned>& movement_schedule)
+    {
+        if (movements.size() != movement_schedule.size())
+            throw std::invalid_argument(
+                "MovementTable: Number of movements (" + std::to_string(movements.size())
+                + ") differs from size of the movement schedule ("
+                + std::to_string(movement_schedule.size()) + ")");
+        reserve(movements.size());
+        for (SizeType i = 0; i < movements.size(); ++i) {
+            const auto& movement = movements[i];
+            if (movement.size() != 5)
+                throw std::invalid_argument(
+                    "MovementTable: Movement " + std::to_string(i)
+                    + " does not have five items");
+            add(movement_schedule[i],
+                movement[0],
+                movement[1],
+                movement[2],
+                movement[3],
+                movement[4]);
+        }
+        finalize();
+    }
+
+    /**
+     * Reserves memory for the given number of movements.
+     */
+    void reserve(SizeType size)
+    {
+        steps_.reserve(size);
+        rows_from_.reserve(size);
+        cols_from_.reserve(size);
+        rows_to_.reserve(size);
+        cols_to_.reserve(size);
+        num_hosts_.reserve(size);
+    }
+
+    /**
+     * Adds one movement to the table.
+     *
+     * The movements don't need to be added in order by step.
+     * Throws an std::logic_error exception when called after finalize().
+     */
+    void add(
+        unsigned step,
+        RasterIndex row_from,
+        RasterIndex col_from,
+        RasterIndex row_to,
+        RasterIndex col_to,
+        int num_hosts)
+    {
+        if (finalized_)
+            throw std::logic_error("MovementTable: add() called after finalize()");
+        steps_.push_back(step);
+        rows_from_.push_back(row_from);
+        cols_from_.push_back(col_from);
+        rows_to_.push_back(row_to);
+        cols_to_.push_back(col_to);
+        num_hosts_.push_back(num_hosts);
+    }
+
+    /**
+     * Sorts the records by step and creates the step index.
+     *
+     * The sort is a stable counting sort, so it is linear in the number of
+     * records and number of steps. Calling it more than once has no effect.
+     */
+    void finalize()
+    {
+        if (finalized_)
+            return;
+        unsigned num_steps = 0;
+        for (auto step : steps_)
+            if (step + 1 > num_steps)
+                num_steps = step + 1;
+        step_offsets_.assign(num_steps + 1, 0);
+        for (auto step : steps_)
+            ++step_offsets_[step + 1];
+        for (unsigned step = 0; step < num_steps; ++step)
+            step_offsets_[step + 1] += step_offsets_[step];
+        // Skip the permutation if the records are already in order.
+        bool sorted = true;
+        for (SizeType i = 1; i < steps_.size(); ++i) {
+            if (steps_[i] < steps_[i - 1]) {
+                sorted = false;
+                break;
+            }
+        }
+        if (!sorted) {
+            std::vector<SizeType> positions(
+                step_offsets_.begin(), step_offsets_.end() - 1);
+            std::vector<SizeType> order(steps_.size());
+            for (SizeType i = 0; i < steps_.size(); ++i)
+                order[positions[steps_[i]]++] = i;
+            permute(rows_from_, order);
+            permute(cols_from_, order);
+            permute(rows_to_, order);
+            permute(cols_to_, order);
+            permute(num_hosts_, order);
+        }
+        // The step of each record is now given by the index.
+        std::vector<unsigned>().swap(steps_);
+        finalized_ = true;
+    }
+
+    /**
+     * Returns true if finalize() was called.
+     */
+    bool finalized() const
+    {
+        return finalized_;
+    }
+
+    /**
+     * Returns number of movements in the table.
+     */
+    SizeType size() const
+    {
+        return num_hosts_.size();
+    }
+
+    /**
+     * Returns true if there are no movements in the table.
+     */
+    bool empty() const
+    {
+        return num_hosts_.empty();
+    }
+
+    /**
+     * Returns number of steps covered by the table, i.e., the last step
+     * with a movement plus one.
+     */
+    unsigned num_steps() const
+    {
+        check_finalized();
+        return step_offsets_.empty() ? 0 : step_offsets_.size() - 1;
+    }
+
+    /**
+     * Returns the range of indices of movements in a given step.
+     *
+     * The first item is the index of the first movement, the second item
+     * is one past the index of the last movement, so the range is empty
+     * when both are equal (e.g., for steps beyond num_steps()).
+     */
+    std::pair<SizeType, SizeType> step_range(unsigned step) const
+    {
+        check_finalized();
+        if (step >= num_steps())
+            return std::make_pair(size(), size());
+        return std::make_pair(step_offsets_[step], step_offsets_[step + 1]);
+    }
+
+    RasterIndex row_from(SizeType index) const
+    {
+        return rows_from_[index];
+    }
+
+    RasterIndex col_from(SizeType index) const
+    {
+        return cols_from_[index];
+    }
+
+    RasterIndex row_to(SizeType index) const
+    {
+        return rows_to_[index];
+    }
+
+    RasterIndex col_to(SizeType index) const
+    {
+        return cols_to_[index];
+    }
+
+    int num_hosts(SizeType index) const
+    {
+        return num_hosts_[index];
+    }
+
+private:
+    std::vector<unsigned> steps_;
+    std::vector<RasterIndex> rows_from_;
+    std::vector<RasterIndex> cols_from_;
+    std::vector<RasterIndex> rows_to_;
+    std::vector<RasterIndex> cols_to_;
+    std::vector<int> num_hosts_;
+    // Index of the first record for each step with one extra item at the end.
+    std::vector<SizeType> step_offsets_;
+    bool finalized_{false};
+
+    void check_finalized() const
+    {
+        if (!finalized_)
+            throw std::logic_error(
+                "MovementTable: finalize() needs to be called before using the table");
+    }
+
+    template<typename T>
+    static void permute(std::vector<T>& values, const std::vector<SizeType>& order)
+    {
+        std::vector<T> result;
+        result.reserve(values.size());
+        for (auto index : order)
+            result.push_back(values[index]);
+        values.swap(result);
+    }
+};
+
+}  // namespace pops
+
+#endif  // POPS_MOVEMENTS_HPP
@@ -21,6 +21,7 @@
 #include <tuple>
 #include <random>
 #include <type_traits>
+#include <vector>
 
 namespace pops {
 
@@ -37,7 +38,8 @@ namespace pops {
  *
  * Bernoulli distribution is used to decide between the natural and
  * anthropogenic distance kernel. The anthropogenic distance dispersal can be also
- * competely disabled.
+ * competely disabled. When sampling all dispersers from one cell,
+ * binomial distribution is used to split them between the two kernels.
  */
 template<typename NaturalKernelType, typename AnthropogenicKernelType>
 class NaturalAnthropogenicDispersalKernel
@@ -47,6 +49,9 @@ protected:
     NaturalKernelType natural_kernel_;
     AnthropogenicKernelType anthropogenic_kernel_;
     std::bernoulli_distribution bernoulli_distribution;
+    std::binomial_distribution<int> binomial_distribution;
+    // targets of the anthropogenic kernel before they are added to all targets
+    std::vector<std::tuple<int, int>> anthropogenic_targets_;
 
 public:
     NaturalAnthropogenicDispersalKernel(
@@ -60,7 +65,8 @@ public:
           natural_kernel_(natural_kernel),
           anthropogenic_kernel_(anthropogenic_kernel),
           // use bernoulli distribution to act as the sampling with prob(gamma,1-gamma)
-          bernoulli_distribution(percent_natural_dispersal)
+          bernoulli_distribution(percent_natural_dispersal),
+          binomial_distribution(0, percent_natural_dispersal)
     {}
 
     /*! \copydoc RadialDispersalKernel::operator()()
@@ -77,6 +83,42 @@ public:
         }
     }
 
+    /*! \copydoc RadialDispersalKernel::sample()
+     *
+     * Without the anthropogenic kernel, all dispersers are sampled by
+     * the natural kernel at once. Otherwise, the number of dispersers using
+     * the natural kernel is drawn from binomial distribution and each
+     * kernel samples its dispersers at once. Targets of the natural kernel
+     * are first, followed by targets of the anthropogenic kernel.
+     *
+     * The distribution of targets is the same as with the function call
+     * operator, but the random numbers are used differently, so the results
+     * are not the same as with repeated calls of the operator.
+     */
+    template<typename Generator>
+    void sample(
+        Generator& generator,
+        int row,
+        int col,
+        int count,
+        std::vector<std::tuple<int, int>>& targets)
+    {
+        if (!use_anthropogenic_kernel_) {
+            natural_kernel_.sample(generator, row, col, count, targets);
+            return;
+        }
+        typedef std::binomial_distribution<int>::param_type Parameters;
+        int natural_count = binomial_distribution(
+            generator, Parameters(count, bernoulli_distribution.p()));
+        natural_kernel_.sample(generator, row, col, natural_count, targets);
+        anthropogenic_kernel_.sample(
+            generator, row, col, count - natural_count, anthropogenic_targets_);
+        targets.insert(
+            targets.end(),
+            anthropogenic_targets_.begin(),
+            anthropogenic_targets_.end());
+    }
+
     /*! \copydoc RadialDispersalKernel::supports_kernel()
      *
      * Returns true if at least one of the kernels (natural or anthropogenic)
@@ -98,6 +98,21 @@ public:
         return std::make_tuple(row, col);
     }
 
+    /*! \copydoc RadialDispersalKernel::sample()
+     *
+     * All dispersers go to the same cell.
+     */
+    template<typename Generator>
+    void sample(
+        Generator& generator,
+        int row,
+        int col,
+        int count,
+        std::vector<std::tuple<int, int>>& targets)
+    {
+        targets.assign(count, (*this)(generator, row, col));
+    }
+
     /*! \copybrief RadialDispersalKernel::supports_kernel()
      */
     static bool supports_kernel(const DispersalKernelType type)
@@ -0,0 +1,458 @@
+/*
+ * PoPS model - asynchronous output of rasters
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_OUTPUT_HPP
+#define POPS_OUTPUT_HPP
+
+#include "config.hpp"
+#include "exposed_cohorts.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace pops {
+
+/**
+ * Returns ENVI data type code for a type of raster values.
+ *
+ * Throws std::invalid_argument for types which ENVI does not support.
+ */
+template<typename Value>
+int envi_data_type()
+{
+    bool is_float = std::is_floating_point<Value>::value;
+    bool is_signed = std::is_signed<Value>::value;
+    switch (sizeof(Value)) {
+    case 1:
+        if (!is_signed)
+            return 1;
+        break;
+    case 2:
+        if (!is_float)
+            return is_signed ? 2 : 12;
+        break;
+    case 4:
+        if (is_float)
+            return 4;
+        return is_signed ? 3 : 13;
+    case 8:
+        if (is_float)
+            return 5;
+        return is_signed ? 14 : 15;
+    }
+    throw std::invalid_argument("envi_data_type: Unsupported type of raster values");
+}
+
+/**
+ * Writes rasters to files in a background thread.
+ *
+ * Rasters are copied (snapshotted) into a frame when write() is called and
+ * the frame is written to disk by a writer thread while the simulation
+ * continues. Frames are reused after they are written, so no memory is
+ * allocated after the first few outputs when the raster size does not change.
+ *
+ * The memory is bounded by *max_frames*. When all frames are waiting to be
+ * written, write() waits for the writer thread to finish one of them.
+ * With enough frames for the output frequency (e.g., two), the simulation
+ * does not wait for the disk.
+ *
+ * Each frame is stored as raw binary file with the rasters as consecutive
+ * bands (band sequential, native byte order) and a sidecar header in ENVI
+ * format which can be read, e.g., by GDAL. The files are named
+ * `<prefix><step>.bin` and `<prefix><step>.hdr`.
+ *
+ * If writing fails, the exception is rethrown by the next call of write()
+ * or by finish().
+ */
+template<typename IntegerRaster>
+class AsyncOutputWriter
+{
+public:
+    typedef typename IntegerRaster::NumberType Value;
+
+    /**
+     * @param prefix Path and beginning of file names (directory must exist)
+     * @param max_frames Maximum number of frames held in memory
+     */
+    AsyncOutputWriter(const std::string& prefix, unsigned max_frames = 2)
+        : prefix_(prefix), max_frames_(max_frames)
+    {
+        if (!max_frames)
+            throw std::invalid_argument(
+                "AsyncOutputWriter: Maximum number of frames must be at least one");
+        thread_ = std::thread(&AsyncOutputWriter::run, this);
+    }
+
+    AsyncOutputWriter(const AsyncOutputWriter&) = delete;
+    AsyncOutputWriter& operator=(const AsyncOutputWriter&) = delete;
+
+    /** Waits for all frames to be written (errors are ignored) */
+    ~AsyncOutputWriter()
+    {
+        try {
+            finish();
+        }
+        catch (...) {
+        }
+    }
+
+    /**
+     * Snapshots rasters and schedules them for writing.
+     *
+     * @param step Simulation step used in the file name
+     * @param date Date stored in the header (e.g., end of the step)
+     * @param names Names of the rasters (band names in the header)
+     * @param rasters Rasters of the same size
+     */
+    void write(
+        unsigned step,
+        const std::string& date,
+        const std::vector<std::string>& names,
+        const std::vector<const IntegerRaster*>& rasters)
+    {
+        if (names.size() != rasters.size() || rasters.empty())
+            throw std::invalid_argument(
+                "AsyncOutputWriter: Names and rasters must match and not be empty");
+        auto frame = acquire_frame();
+        frame->step = step;
+        frame->date = date;
+        frame->rows = rasters[0]->rows();
+        frame->cols = rasters[0]->cols();
+        frame->names = names;
+        frame->bands.resize(rasters.size());
+        std::size_t size = std::size_t(frame->rows) * frame->cols;
+        for (std::size_t i = 0; i < rasters.size(); ++i) {
+            const Value* data = rasters[i]->data();
+            frame->bands[i].assign(data, data + size);
+        }
+        submit(std::move(frame));
+    }
+
+    /**
+     * Snapshots the host state: infected, susceptible, exposed (sum over
+     * all cohorts, only if *exposed* is not empty), died, and resistant.
+     */
+    void write_state(
+        unsigned step,
+        const std::string& date,
+        const IntegerRaster& infected,
+        const IntegerRaster& susceptible,
+        const std::vector<IntegerRaster>& exposed,
+        const IntegerRaster& died,
+        const IntegerRaster& resistant)
+    {
+        write_host_state(
+            step,
+            date,
+            infected,
+            susceptible,
+            !exposed.empty(),
+            [&exposed](std::vector<Value>& sum, int) {
+                for (const auto& cohort : exposed) {
+                    const Value* data = cohort.data();
+                    for (std::size_t i = 0; i < sum.size(); ++i)
+                        sum[i] += data[i];
+                }
+            },
+            died,
+            resistant);
+    }
+
+    /**
+     * Snapshots the host state with exposed hosts stored as ExposedCohorts.
+     *
+     * The exposed band is always written. The cohorts are visited with
+     * ExposedCohorts::for_each(), so the hosts exposed in the current step
+     * are stored in the youngest cohort.
+     */
+    void write_state(
+        unsigned step,
+        const std::string& date,
+        const IntegerRaster& infected,
+        const IntegerRaster& susceptible,
+        ExposedCohorts& exposed,
+        const IntegerRaster& died,
+        const IntegerRaster& resistant)
+    {
+        write_host_state(
+            step,
+            date,
+            infected,
+            susceptible,
+            true,
+            [&exposed](std::vector<Value>& sum, int cols) {
+                exposed.for_each([&sum, cols](int row, int col, int& count) {
+                    sum[std::size_t(row) * cols + col] += count;
+                });
+            },
+            died,
+            resistant);
+    }
+
+    /**
+     * Snapshots the host state if output is scheduled for the step.
+     *
+     * The date is the end date of the step.
+     *
+     * @returns true if the output was scheduled
+     */
+    bool write_scheduled(
+        const Config& config,
+        unsigned step,
+        const IntegerRaster& infected,
+        const IntegerRaster& susceptible,
+        const std::vector<IntegerRaster>& exposed,
+        const IntegerRaster& died,
+        const IntegerRaster& resistant)
+    {
+        if (!config.output_schedule()[step])
+            return false;
+        write_state(
+            step,
+            config.scheduler().get_step(step).end_date().to_string(),
+            infected,
+            susceptible,
+            exposed,
+            died,
+            resistant);
+        return true;
+    }
+
+    /**
+     * Snapshots the host state with exposed hosts stored as ExposedCohorts
+     * if output is scheduled for the step.
+     *
+     * @returns true if the output was scheduled
+     */
+    bool write_scheduled(
+        const Config& config,
+        unsigned step,
+        const IntegerRaster& infected,
+        const IntegerRaster& susceptible,
+        ExposedCohorts& exposed,
+        const IntegerRaster& died,
+        const IntegerRaster& resistant)
+    {
+        if (!config.output_schedule()[step])
+            return false;
+        write_state(
+            step,
+            config.scheduler().get_step(step).end_date().to_string(),
+            infected,
+            susceptible,
+            exposed,
+            died,
+            resistant);
+        return true;
+    }
+
+    /**
+     * Waits until all frames are written and stops the writer thread.
+     *
+     * Rethrows an exception from the writer thread if writing failed.
+     * No frames can be written after this call.
+     */
+    void finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        frame_queued_.notify_one();
+        if (thread_.joinable())
+            thread_.join();
+        rethrow_error();
+    }
+
+    /** Number of frames written so far */
+    unsigned num_written() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return num_written_;
+    }
+
+private:
+    struct Frame
+    {
+        unsigned step{0};
+        std::string date;
+        int rows{0};
+        int cols{0};
+        std::vector<std::string> names;
+        std::vector<std::vector<Value>> bands;
+    };
+
+    std::string prefix_;
+    unsigned max_frames_;
+    unsigned num_frames_{0};
+    unsigned num_written_{0};
+    bool stop_{false};
+    std::vector<std::unique_ptr<Frame>> free_frames_;
+    std::deque<std::unique_ptr<Frame>> queue_;
+    std::exception_ptr error_;
+    mutable std::mutex mutex_;
+    std::condition_variable frame_queued_;
+    std::condition_variable frame_freed_;
+    std::thread thread_;
+
+    void rethrow_error()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (error_) {
+            auto error = error_;
+            error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * Snapshots the host state, *sum_exposed* is called with a zeroed
+     * exposed band and number of columns when *with_exposed* is true.
+     */
+    template<typename ExposedSum>
+    void write_host_state(
+        unsigned step,
+        const std::string& date,
+        const IntegerRaster& infected,
+        const IntegerRaster& susceptible,
+        bool with_exposed,
+        ExposedSum sum_exposed,
+        const IntegerRaster& died,
+        const IntegerRaster& resistant)
+    {
+        auto frame = acquire_frame();
+        frame->step = step;
+        frame->date = date;
+        frame->rows = infected.rows();
+        frame->cols = infected.cols();
+        frame->names.clear();
+        frame->bands.resize(with_exposed ? 5 : 4);
+        std::size_t size = std::size_t(frame->rows) * frame->cols;
+        std::size_t band = 0;
+        auto copy = [&](const std::string& name, const IntegerRaster& raster) {
+            frame->names.push_back(name);
+            frame->bands[band++].assign(raster.data(), raster.data() + size);
+        };
+        copy("infected", infected);
+        copy("susceptible", susceptible);
+        if (with_exposed) {
+            frame->names.push_back("exposed");
+            auto& sum = frame->bands[band++];
+            sum.assign(size, 0);
+            sum_exposed(sum, frame->cols);
+        }
+        copy("died", died);
+        copy("resistant", resistant);
+        submit(std::move(frame));
+    }
+
+    /** Takes a free frame, allocates a new one, or waits for one */
+    std::unique_ptr<Frame> acquire_frame()
+    {
+        rethrow_error();
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stop_)
+            throw std::logic_error("AsyncOutputWriter: Writer was already finished");
+        if (free_frames_.empty() && num_frames_ < max_frames_) {
+            ++num_frames_;
+            return std::unique_ptr<Frame>(new Frame);
+        }
+        frame_freed_.wait(lock, [this] { return !free_frames_.empty(); });
+        auto frame = std::move(free_frames_.back());
+        free_frames_.pop_back();
+        return frame;
+    }
+
+    void submit(std::unique_ptr<Frame> frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(frame));
+        }
+        frame_queued_.notify_one();
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            frame_queued_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty())
+                return;
+            auto frame = std::move(queue_.front());
+            queue_.pop_front();
+            lock.unlock();
+            try {
+                write_frame(*frame);
+                lock.lock();
+                ++num_written_;
+            }
+            catch (...) {
+                lock.lock();
+                if (!error_)
+                    error_ = std::current_exception();
+            }
+            free_frames_.push_back(std::move(frame));
+            frame_freed_.notify_one();
+        }
+    }
+
+    void write_frame(const Frame& frame) const
+    {
+        std::string name = prefix_ + std::to_string(frame.step);
+        std::ofstream data(name + ".bin", std::ios::binary);
+        for (const auto& band : frame.bands)
+            data.write(
+                reinterpret_cast<const char*>(band.data()),
+                band.size() * sizeof(Value));
+        if (!data)
+            throw std::runtime_error(
+                "AsyncOutputWriter: Cannot write to " + name + ".bin");
+        std::uint16_t byte_order_test = 1;
+        bool big_endian = !*reinterpret_cast<unsigned char*>(&byte_order_test);
+        std::ofstream header(name + ".hdr");
+        header << "ENVI\n"
+               << "description = {PoPS step " << frame.step << " " << frame.date
+               << "}\n"
+               << "samples = " << frame.cols << "\n"
+               << "lines = " << frame.rows << "\n"
+               << "bands = " << frame.bands.size() << "\n"
+               << "header offset = 0\n"
+               << "file type = ENVI Standard\n"
+               << "data type = " << envi_data_type<Value>() << "\n"
+               << "interleave = bsq\n"
+               << "byte order = " << (big_endian ? 1 : 0) << "\n"
+               << "band names = {";
+        for (std::size_t i = 0; i < frame.names.size(); ++i)
+            header << (i ? ", " : "") << frame.names[i];
+        header << "}\n";
+        if (!header)
+            throw std::runtime_error(
+                "AsyncOutputWriter: Cannot write to " + name + ".hdr");
+    }
+};
+
+}  // namespace pops
+
+#endif  // POPS_OUTPUT_HPP
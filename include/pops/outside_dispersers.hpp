@@ -0,0 +1,238 @@
+/*
+ * PoPS model - dispersers leaving the simulated area
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_OUTSIDE_DISPERSERS_HPP
+#define POPS_OUTSIDE_DISPERSERS_HPP
+
+#include "utils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace pops {
+
+/**
+ * Counts of dispersers which left the simulated area.
+ *
+ * Instead of one record per disperser, dispersers are counted for each
+ * target cell (row and column outside of the raster), for the direction
+ * in which they left the raster, and for binned distance from the raster.
+ *
+ * The number of target cells with individual counts is limited by
+ * *max_cells*. Dispersers going to other cells after the limit is reached
+ * are included in the total, direction, and distance counts, and they are
+ * reported by uncounted(). Use zero to keep only the summary counts.
+ */
+class AggregatedOutsideDispersers
+{
+public:
+    /** Number of dispersers going to one cell outside of the raster */
+    struct Cell
+    {
+        int row;
+        int col;
+        std::uint64_t count;
+    };
+
+    /**
+     * @param rows Number of rows of the simulated raster
+     * @param cols Number of columns of the simulated raster
+     * @param max_cells Maximum number of individually counted target cells
+     */
+    AggregatedOutsideDispersers(int rows, int cols, std::size_t max_cells = 1 << 20)
+        : rows_(rows), cols_(cols), max_cells_(max_cells)
+    {
+        direction_counts_.fill(0);
+    }
+
+    /**
+     * Adds *count* dispersers going to cell at *row* and *col*.
+     *
+     * The cell must be outside of the raster. Zero *count* is ignored,
+     * so it does not take one of the individually counted cells.
+     */
+    void add(int row, int col, std::uint64_t count = 1)
+    {
+        int row_distance = row < 0 ? -row : (row >= rows_ ? row - rows_ + 1 : 0);
+        int col_distance = col < 0 ? -col : (col >= cols_ ? col - cols_ + 1 : 0);
+        int distance = std::max(row_distance, col_distance);
+        if (!distance)
+            throw std::invalid_argument(
+                "AggregatedOutsideDispersers: Cell is inside of the raster");
+        if (!count)
+            return;
+        total_ += count;
+        direction_counts_[direction_index(row, col)] += count;
+        unsigned bin = 0;
+        while (distance >>= 1)
+            ++bin;
+        if (bin >= distance_counts_.size())
+            distance_counts_.resize(bin + 1, 0);
+        distance_counts_[bin] += count;
+        std::uint64_t key = cell_key(row, col);
+        auto search = cells_.find(key);
+        if (search != cells_.end())
+            search->second += count;
+        else if (cells_.size() < max_cells_)
+            cells_.emplace(key, count);
+        else
+            uncounted_ += count;
+    }
+
+    /** Total number of dispersers */
+    std::uint64_t total() const
+    {
+        return total_;
+    }
+
+    /**
+     * Number of dispersers going to a given cell
+     *
+     * Zero is returned also for cells which were not counted because of the limit.
+     */
+    std::uint64_t count(int row, int col) const
+    {
+        auto search = cells_.find(cell_key(row, col));
+        if (search == cells_.end())
+            return 0;
+        return search->second;
+    }
+
+    /** Number of dispersers not counted per cell because of the cell limit */
+    std::uint64_t uncounted() const
+    {
+        return uncounted_;
+    }
+
+    /** Number of individually counted cells */
+    std::size_t num_cells() const
+    {
+        return cells_.size();
+    }
+
+    /** Counts for individual cells ordered by row and column */
+    std::vector<Cell> cells() const
+    {
+        std::vector<Cell> result;
+        result.reserve(cells_.size());
+        for (const auto& item : cells_) {
+            result.push_back(
+                {int(std::uint32_t(item.first >> 32)),
+                 int(std::uint32_t(item.first)),
+                 item.second});
+        }
+        std::sort(result.begin(), result.end(), [](const Cell& a, const Cell& b) {
+            return std::tie(a.row, a.col) < std::tie(b.row, b.col);
+        });
+        return result;
+    }
+
+    /**
+     * Number of dispersers which left the raster in a given direction
+     *
+     * Dispersers going over a corner of the raster are counted for
+     * the diagonal directions, e.g., NE for row < 0 and col >= cols.
+     */
+    std::uint64_t direction_count(Direction direction) const
+    {
+        if (direction == Direction::None)
+            return 0;
+        return direction_counts_[static_cast<int>(direction) / 45];
+    }
+
+    /**
+     * Number of dispersers by distance from the raster.
+     *
+     * The distance is the number of cells from the raster edge measured
+     * along rows or columns, whichever is larger (one for cells next to
+     * the raster). Item *k* is the number of dispersers with distance
+     * from 2^k to 2^(k+1) - 1.
+     */
+    const std::vector<std::uint64_t>& distance_counts() const
+    {
+        return distance_counts_;
+    }
+
+    /** Removes all counts */
+    void clear()
+    {
+        total_ = 0;
+        uncounted_ = 0;
+        direction_counts_.fill(0);
+        distance_counts_.clear();
+        cells_.clear();
+    }
+
+private:
+    int rows_;
+    int cols_;
+    std::size_t max_cells_;
+    std::uint64_t total_{0};
+    std::uint64_t uncounted_{0};
+    // indexed by the Direction value divided by 45
+    std::array<std::uint64_t, 8> direction_counts_;
+    std::vector<std::uint64_t> distance_counts_;
+    std::unordered_map<std::uint64_t, std::uint64_t> cells_;
+
+    static std::uint64_t cell_key(int row, int col)
+    {
+        return (std::uint64_t(std::uint32_t(row)) << 32) | std::uint32_t(col);
+    }
+
+    int direction_index(int row, int col) const
+    {
+        Direction direction;
+        bool north = row < 0;
+        bool south = row >= rows_;
+        if (col < 0)
+            direction = north ? Direction::NW : (south ? Direction::SW : Direction::W);
+        else if (col >= cols_)
+            direction = north ? Direction::NE : (south ? Direction::SE : Direction::E);
+        else
+            direction = north ? Direction::N : Direction::S;
+        return static_cast<int>(direction) / 45;
+    }
+};
+
+/**
+ * Records *count* dispersers going to *row* and *col* outside of the raster
+ * as individual items of a vector.
+ */
+inline void add_outside_dispersers(
+    std::vector<std::tuple<int, int>>& outside_dispersers, int row, int col, int count)
+{
+    if (count <= 0)
+        return;
+    // Inserting all at once keeps the geometric growth of the vector.
+    outside_dispersers.insert(
+        outside_dispersers.end(), count, std::make_tuple(row, col));
+}
+
+/**
+ * Counts *count* dispersers going to *row* and *col* outside of the raster.
+ */
+inline void add_outside_dispersers(
+    AggregatedOutsideDispersers& outside_dispersers, int row, int col, int count)
+{
+    outside_dispersers.add(row, col, count);
+}
+
+}  // namespace pops
+
+#endif  // POPS_OUTSIDE_DISPERSERS_HPP
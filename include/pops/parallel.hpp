@@ -0,0 +1,94 @@
+/*
+ * PoPS model - helpers for parallel computations
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_PARALLEL_HPP
+#define POPS_PARALLEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace pops {
+
+/**
+ * Calls *function* for consecutive chunks of the range from 0 to *size*.
+ *
+ * The *function* is called as `function(begin, end)` where *begin* and *end*
+ * define a chunk of the range (*end* is one past the last index). The range is
+ * split into at most *num_threads* chunks of similar size which are
+ * processed in separate threads. With one thread (or a range of size one),
+ * the function is called directly in the current thread.
+ *
+ * The function must not modify data used by other chunks.
+ * If the function throws an exception in any of the threads, the exception
+ * is rethrown after all threads finished.
+ */
+template<typename Function>
+void parallel_for_chunks(std::size_t size, unsigned num_threads, Function function)
+{
+    if (size == 0)
+        return;
+    if (num_threads > size)
+        num_threads = size;
+    if (num_threads <= 1) {
+        function(std::size_t(0), size);
+        return;
+    }
+    std::vector<std::thread> threads;
+    std::vector<std::exception_ptr> exceptions(num_threads);
+    threads.reserve(num_threads);
+    std::size_t chunk = size / num_threads;
+    std::size_t remainder = size % num_threads;
+    std::size_t begin = 0;
+    for (unsigned i = 0; i < num_threads; ++i) {
+        std::size_t end = begin + chunk + (i < remainder ? 1 : 0);
+        threads.emplace_back([&function, &exceptions, i, begin, end]() {
+            try {
+                function(begin, end);
+            }
+            catch (...) {
+                exceptions[i] = std::current_exception();
+            }
+        });
+        begin = end;
+    }
+    for (auto& thread : threads)
+        thread.join();
+    for (const auto& exception : exceptions)
+        if (exception)
+            std::rethrow_exception(exception);
+}
+
+/**
+ * Creates a seed for an independent random number stream.
+ *
+ * The seed is derived from a base *seed* (e.g., drawn once from the main
+ * generator) and an *index* of the stream (e.g., index of an item which is
+ * processed). The same inputs always give the same seed regardless of the
+ * order of evaluation, so results do not depend on the number of threads.
+ * The values are mixed using the SplitMix64 finalizer.
+ */
+inline std::uint_fast32_t substream_seed(std::uint64_t seed, std::uint64_t index)
+{
+    std::uint64_t value = seed + 0x9E3779B97F4A7C15ULL * (index + 1);
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    value = value ^ (value >> 31);
+    return static_cast<std::uint_fast32_t>(value >> 32);
+}
+
+}  // namespace pops
+
+#endif  // POPS_PARALLEL_HPP
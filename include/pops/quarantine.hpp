@@ -17,13 +17,20 @@
 #define POPS_QUARANTINE_HPP
 
 #include <tuple>
-#include <map>
+#include <unordered_map>
 #include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <limits>
+#include <memory>
+#include <stdexcept>
 #include <type_traits>
+#include <utility>
 #include <sstream>
 #include <iomanip>
 
+#include "distance_transform.hpp"
 #include "utils.hpp"
 
 namespace pops {
@@ -39,10 +46,85 @@ typedef std::tuple<bool, DistDir> EscapeDistDir;
 typedef std::vector<EscapeDistDir> EscapeDistDirs;
 
 /**
- * Class storing and computing quarantine escap metrics for one simulation.
+ * How the distance to the quarantine boundary is measured
+ */
+enum class QuarantineDistance
+{
+    BoundingBox,  //!< Distance to bbox of the area along rows or columns
+    Boundary  //!< Euclidean distance to the nearest boundary cell of the area
+};
+
+/**
+ * Mapping from quarantine area ids to consecutive indices.
+ *
+ * Small non-negative ids (the usual case) are stored in a flat table
+ * indexed by the id, larger or negative ids fall back to a hash map.
+ */
+class QuarantineAreaIndex
+{
+public:
+    /** Ids from 0 up to this value are stored in the flat table */
+    static const int max_dense_id = 1 << 16;
+
+    /**
+     * Returns index of the area or -1 if the id was not added.
+     */
+    int find(int id) const
+    {
+        if (id >= 0 && id <= max_dense_id) {
+            if (static_cast<std::size_t>(id) < dense_.size())
+                return dense_[id];
+            return -1;
+        }
+        auto search = sparse_.find(id);
+        if (search == sparse_.end())
+            return -1;
+        return search->second;
+    }
+
+    /**
+     * Returns index of the area, adds the id with the next index if needed.
+     */
+    int insert(int id)
+    {
+        int index = find(id);
+        if (index >= 0)
+            return index;
+        index = size_++;
+        if (id >= 0 && id <= max_dense_id) {
+            if (static_cast<std::size_t>(id) >= dense_.size())
+                dense_.resize(id + 1, -1);
+            dense_[id] = index;
+        }
+        else {
+            sparse_.insert(std::make_pair(id, index));
+        }
+        return index;
+    }
+
+    /**
+     * Returns number of areas.
+     */
+    int size() const
+    {
+        return size_;
+    }
+
+private:
+    std::vector<int> dense_;
+    std::unordered_map<int, int> sparse_;
+    int size_{0};
+};
+
+/**
+ * Distance and direction to the quarantine boundary for each cell.
+ *
+ * The table depends only on the quarantine areas, resolution, and suitable
+ * cells, not on the infection, so it can be computed once and shared
+ * by the QuarantineEscape objects of all runs (replicates).
  */
 template<typename IntegerRaster, typename RasterIndex = int>
-class QuarantineEscape
+class QuarantineDistances
 {
 private:
     RasterIndex width_;
@@ -51,11 +133,12 @@ private:
     double west_east_resolution_;
     // the north-south resolution of the pixel
     double north_south_resolution_;
-    unsigned num_steps;
     std::vector<BBoxInt> boundaries;
     // mapping between quarantine areas is from map and index
-    std::map<int, int> boundary_id_idx_map;
-    std::vector<EscapeDistDir> escape_dist_dirs;
+    QuarantineAreaIndex boundary_id_idx_map;
+    // distance and direction to the boundary for each cell (row-major)
+    std::vector<double> cell_distances_;
+    std::vector<Direction> cell_directions_;
 
     /**
      * Computes bbox of each quarantine area.
@@ -67,23 +150,15 @@ private:
         const std::vector<std::vector<int>>& suitable_cells)
     {
         int n, s, e, w;
-        int idx = 0;
-        for (auto indices : suitable_cells) {
+        for (const auto& indices : suitable_cells) {
             int i = indices[0];
             int j = indices[1];
             auto value = quarantine_areas(i, j);
             if (value > 0) {
-                auto search = boundary_id_idx_map.find(value);
-                int bidx;
-                if (search == boundary_id_idx_map.end()) {
-                    boundary_id_idx_map.insert(std::make_pair(value, idx));
+                int bidx = boundary_id_idx_map.insert(value);
+                if (bidx == static_cast<int>(boundaries.size()))
                     boundaries.push_back(
                         std::make_tuple(height_ - 1, 0, 0, width_ - 1));
-                    bidx = idx;
-                    ++idx;
-                }
-                else
-                    bidx = search->second;
                 std::tie(n, s, e, w) = boundaries.at(bidx);
                 if (i < n)
                     n = i;
@@ -131,33 +206,248 @@ private:
         return closest;
     }
 
+    /**
+     * Precomputes distance and direction to bbox of the quarantine area
+     * for each suitable cell in a quarantine area.
+     *
+     * Only positive ids have a bbox (see quarantine_boundary()).
+     */
+    void bbox_distances(
+        const IntegerRaster& quarantine_areas,
+        const std::vector<std::vector<int>>& suitable_cells)
+    {
+        for (const auto& indices : suitable_cells) {
+            int i = indices[0];
+            int j = indices[1];
+            int area = quarantine_areas(i, j);
+            if (area <= 0)
+                continue;
+            const auto& boundary = boundaries.at(boundary_id_idx_map.find(area));
+            std::size_t index = i * width_ + j;
+            std::tie(cell_distances_[index], cell_directions_[index]) =
+                closest_direction(i, j, boundary);
+        }
+    }
+
+    /**
+     * Returns true if cell is a boundary cell of its quarantine area, i.e.,
+     * if it is at the edge of the raster or if its neighbor is not in the area.
+     * The *direction* is set to the direction of the first such neighbor
+     * (in the order N, S, E, W).
+     */
+    bool is_boundary_cell(
+        const IntegerRaster& quarantine_areas,
+        RasterIndex i,
+        RasterIndex j,
+        Direction& direction) const
+    {
+        int area = quarantine_areas(i, j);
+        if (i == 0 || quarantine_areas(i - 1, j) != area)
+            direction = Direction::N;
+        else if (i == height_ - 1 || quarantine_areas(i + 1, j) != area)
+            direction = Direction::S;
+        else if (j == width_ - 1 || quarantine_areas(i, j + 1) != area)
+            direction = Direction::E;
+        else if (j == 0 || quarantine_areas(i, j - 1) != area)
+            direction = Direction::W;
+        else
+            return false;
+        return true;
+    }
+
+    /**
+     * Precomputes Euclidean distance and direction to the nearest boundary
+     * cell of the quarantine area for each cell in a quarantine area.
+     *
+     * Uses the exact distance transform (nearest_feature_cells()) computed
+     * separately for each area within its bbox. Distance is between cell centers,
+     * so boundary cells have zero distance. The direction is the one of the
+     * larger component of the vector to the nearest boundary cell
+     * (N or S for ties).
+     */
+    void boundary_distances(const IntegerRaster& quarantine_areas)
+    {
+        // bbox of each area over all cells (not only suitable ones)
+        QuarantineAreaIndex area_index;
+        std::vector<int> area_ids;
+        std::vector<BBoxInt> area_bboxes;
+        for (RasterIndex i = 0; i < height_; ++i) {
+            for (RasterIndex j = 0; j < width_; ++j) {
+                int area = quarantine_areas(i, j);
+                if (area == 0)
+                    continue;
+                int index = area_index.insert(area);
+                if (index == static_cast<int>(area_ids.size())) {
+                    area_ids.push_back(area);
+                    area_bboxes.push_back(std::make_tuple(i, i, j, j));
+                }
+                auto& bbox = area_bboxes[index];
+                std::get<0>(bbox) = std::min<int>(std::get<0>(bbox), i);
+                std::get<1>(bbox) = std::max<int>(std::get<1>(bbox), i);
+                std::get<2>(bbox) = std::max<int>(std::get<2>(bbox), j);
+                std::get<3>(bbox) = std::min<int>(std::get<3>(bbox), j);
+            }
+        }
+        for (std::size_t a = 0; a < area_ids.size(); ++a) {
+            int area = area_ids[a];
+            int n, s, e, w;
+            std::tie(n, s, e, w) = area_bboxes[a];
+            int rows = s - n + 1;
+            int cols = e - w + 1;
+            std::vector<Direction> boundary_directions(rows * cols, Direction::None);
+            for (int r = 0; r < rows; ++r) {
+                for (int c = 0; c < cols; ++c) {
+                    RasterIndex i = n + r;
+                    RasterIndex j = w + c;
+                    Direction direction;
+                    if (quarantine_areas(i, j) == area
+                        && is_boundary_cell(quarantine_areas, i, j, direction))
+                        boundary_directions[r * cols + c] = direction;
+                }
+            }
+            auto nearest = nearest_feature_cells(
+                rows,
+                cols,
+                north_south_resolution_,
+                west_east_resolution_,
+                [&boundary_directions, cols](int r, int c) {
+                    return boundary_directions[r * cols + c] != Direction::None;
+                });
+            for (int r = 0; r < rows; ++r) {
+                for (int c = 0; c < cols; ++c) {
+                    RasterIndex i = n + r;
+                    RasterIndex j = w + c;
+                    if (quarantine_areas(i, j) != area)
+                        continue;
+                    // Each area has at least one boundary cell.
+                    int feature = nearest[r * cols + c];
+                    double dx = (feature % cols - c) * west_east_resolution_;
+                    double dy = (feature / cols - r) * north_south_resolution_;
+                    Direction direction;
+                    if (dx == 0 && dy == 0)
+                        direction = boundary_directions[r * cols + c];
+                    else if (std::abs(dy) >= std::abs(dx))
+                        direction = dy < 0 ? Direction::N : Direction::S;
+                    else
+                        direction = dx > 0 ? Direction::E : Direction::W;
+                    cell_distances_[i * width_ + j] = std::sqrt(dx * dx + dy * dy);
+                    cell_directions_[i * width_ + j] = direction;
+                }
+            }
+        }
+    }
+
 public:
-    QuarantineEscape(
+    /**
+     * Precomputes distance and direction to quarantine boundary
+     * for each cell.
+     *
+     * By default, distance is measured to bbox of each quarantine area.
+     * With QuarantineDistance::Boundary, Euclidean distance to the nearest
+     * boundary cell of the area is used which is more accurate for areas
+     * which are not rectangular (and the same for rectangular areas).
+     */
+    QuarantineDistances(
         const IntegerRaster& quarantine_areas,
         double ew_res,
         double ns_res,
-        unsigned num_steps,
-        const std::vector<std::vector<int>>& suitable_cells)
+        const std::vector<std::vector<int>>& suitable_cells,
+        QuarantineDistance distance_type = QuarantineDistance::BoundingBox)
         : width_(quarantine_areas.cols()),
           height_(quarantine_areas.rows()),
           west_east_resolution_(ew_res),
           north_south_resolution_(ns_res),
-          num_steps(num_steps),
+          cell_distances_(width_ * height_, std::numeric_limits<double>::quiet_NaN()),
+          cell_directions_(width_ * height_, Direction::None)
+    {
+        quarantine_boundary(quarantine_areas, suitable_cells);
+        if (distance_type == QuarantineDistance::Boundary)
+            boundary_distances(quarantine_areas);
+        else
+            bbox_distances(quarantine_areas, suitable_cells);
+    }
+
+    /**
+     * Returns distance to the boundary of the quarantine area of the cell,
+     * NaN for cells outside of quarantine areas.
+     */
+    double distance(RasterIndex i, RasterIndex j) const
+    {
+        return cell_distances_[i * width_ + j];
+    }
+
+    /**
+     * Returns direction of the distance to the boundary of the quarantine area
+     * of the cell, None for cells outside of quarantine areas.
+     */
+    Direction direction(RasterIndex i, RasterIndex j) const
+    {
+        return cell_directions_[i * width_ + j];
+    }
+};
+
+/**
+ * Class storing and computing quarantine escap metrics for one simulation.
+ */
+template<typename IntegerRaster, typename RasterIndex = int>
+class QuarantineEscape
+{
+public:
+    typedef QuarantineDistances<IntegerRaster, RasterIndex> Distances;
+
+    /**
+     * Creates the escape tracker and precomputes distance and direction
+     * to quarantine boundary for each cell.
+     *
+     * See QuarantineDistances for the *distance_type*. When there are multiple
+     * runs, create the distances once and use the other constructor
+     * (copies of the object share the distances too).
+     */
+    QuarantineEscape(
+        const IntegerRaster& quarantine_areas,
+        double ew_res,
+        double ns_res,
+        unsigned num_steps,
+        const std::vector<std::vector<int>>& suitable_cells,
+        QuarantineDistance distance_type = QuarantineDistance::BoundingBox)
+        : QuarantineEscape(
+            std::make_shared<const Distances>(
+                quarantine_areas, ew_res, ns_res, suitable_cells, distance_type),
+            num_steps)
+    {}
+
+    /**
+     * Creates the escape tracker with distances shared with other trackers.
+     */
+    QuarantineEscape(std::shared_ptr<const Distances> distances, unsigned num_steps)
+        : num_steps(num_steps),
           escape_dist_dirs(
               num_steps,
               std::make_tuple(
                   false,
-                  std::make_tuple(std::numeric_limits<double>::max(), Direction::None)))
+                  std::make_tuple(
+                      std::numeric_limits<double>::max(), Direction::None))),
+          distances_(std::move(distances))
     {
-        quarantine_boundary(quarantine_areas, suitable_cells);
+        if (!distances_)
+            throw std::invalid_argument(
+                "QuarantineEscape: Distances to quarantine boundary are required");
     }
 
     QuarantineEscape() = delete;
 
+    /** Distances to quarantine boundary used by this object */
+    const std::shared_ptr<const Distances>& distances() const
+    {
+        return distances_;
+    }
+
     /**
      * Computes whether infection in certain step escaped from quarantine areas
      * and if not, computes and saves minimum distance and direction to quarantine areas
      * for the specified step. Aggregates over all quarantine areas.
+     *
+     * The quarantine areas must be the same as the ones used in the constructor.
      */
     void infection_escape_quarantine(
         const IntegerRaster& infected,
@@ -166,27 +456,27 @@ public:
         const std::vector<std::vector<int>>& suitable_cells)
     {
 
-        DistDir min_dist_dir =
-            std::make_tuple(std::numeric_limits<double>::max(), Direction::None);
-        for (auto indices : suitable_cells) {
+        // Distances were precomputed, so this is only a min-reduction
+        // over infected cells.
+        double min_distance = std::numeric_limits<double>::max();
+        Direction min_direction = Direction::None;
+        for (const auto& indices : suitable_cells) {
             int i = indices[0];
             int j = indices[1];
             if (!infected(i, j))
                 continue;
-            int area = quarantine_areas(i, j);
-            if (area == 0) {
+            if (quarantine_areas(i, j) == 0) {
                 escape_dist_dirs.at(step) = std::make_tuple(
                     true, std::make_tuple(std::nan(""), Direction::None));
                 return;
             }
-            double dist;
-            Direction dir;
-            int bindex = boundary_id_idx_map[area];
-            std::tie(dist, dir) = closest_direction(i, j, boundaries.at(bindex));
-            if (dist < std::get<0>(min_dist_dir)) {
-                min_dist_dir = std::make_tuple(dist, dir);
+            double distance = distances_->distance(i, j);
+            if (distance < min_distance) {
+                min_distance = distance;
+                min_direction = distances_->direction(i, j);
             }
         }
+        DistDir min_dist_dir = std::make_tuple(min_distance, min_direction);
         escape_dist_dirs.at(step) = std::make_tuple(false, min_dist_dir);
     }
     /**
@@ -226,6 +516,11 @@ public:
         auto dist_dir = std::get<1>(escape_dist_dirs.at(step));
         return std::get<1>(dist_dir);
     }
+
+private:
+    unsigned num_steps;
+    std::vector<EscapeDistDir> escape_dist_dirs;
+    std::shared_ptr<const Distances> distances_;
 };
 
 /**
@@ -234,7 +529,7 @@ public:
  */
 template<typename IntegerRaster>
 double quarantine_escape_probability(
-    const std::vector<QuarantineEscape<IntegerRaster>> escape_infos, unsigned step)
+    const std::vector<QuarantineEscape<IntegerRaster>>& escape_infos, unsigned step)
 {
     bool escape;
     DistDir distdir;
@@ -254,7 +549,7 @@ double quarantine_escape_probability(
  */
 template<typename IntegerRaster>
 std::vector<DistDir> distance_direction_to_quarantine(
-    const std::vector<QuarantineEscape<IntegerRaster>> escape_infos, unsigned step)
+    const std::vector<QuarantineEscape<IntegerRaster>>& escape_infos, unsigned step)
 {
     bool escape;
     DistDir distdir;
@@ -276,7 +571,8 @@ std::vector<DistDir> distance_direction_to_quarantine(
  */
 template<typename IntegerRaster>
 std::string write_quarantine_escape(
-    const std::vector<QuarantineEscape<IntegerRaster>> escape_infos, unsigned num_steps)
+    const std::vector<QuarantineEscape<IntegerRaster>>& escape_infos,
+    unsigned num_steps)
 {
     std::stringstream ss;
     ss << std::setprecision(1) << std::fixed;
@@ -40,6 +40,7 @@
 #include <random>
 #include <algorithm>
 #include <stdexcept>
+#include <vector>
 
 namespace pops {
 
@@ -206,6 +207,47 @@ public:
         return std::make_tuple(row, col);
     }
 
+    /*! Generates new positions for *count* dispersers from one cell.
+     *
+     * The *targets* are resized to *count* and filled with the same
+     * positions as *count* calls of the function call operator would
+     * return (the same random numbers are used in the same order).
+     * The kernel type is resolved only once for all the dispersers.
+     */
+    template<typename Generator>
+    void sample(
+        Generator& generator,
+        int row,
+        int col,
+        int count,
+        std::vector<std::tuple<int, int>>& targets)
+    {
+        // same mapping of kernel types to distributions as in operator()
+        if (dispersal_kernel_type_ == DispersalKernelType::Cauchy)
+            sample_from(cauchy_distribution, generator, row, col, count, targets);
+        else if (dispersal_kernel_type_ == DispersalKernelType::Exponential)
+            sample_from(exponential_distribution, generator, row, col, count, targets);
+        else if (dispersal_kernel_type_ == DispersalKernelType::Weibull)
+            sample_from(weibull_distribution, generator, row, col, count, targets);
+        else if (dispersal_kernel_type_ == DispersalKernelType::Normal)
+            sample_from(normal_distribution, generator, row, col, count, targets);
+        else if (dispersal_kernel_type_ == DispersalKernelType::LogNormal)
+            sample_from(lognormal_distribution, generator, row, col, count, targets);
+        else if (dispersal_kernel_type_ == DispersalKernelType::PowerLaw)
+            sample_from(power_law_distribution, generator, row, col, count, targets);
+        else if (dispersal_kernel_type_ == DispersalKernelType::HyperbolicSecant)
+            sample_from(
+                hyperbolic_secant_distribution, generator, row, col, count, targets);
+        else if (dispersal_kernel_type_ == DispersalKernelType::Gamma)
+            sample_from(gamma_distribution, generator, row, col, count, targets);
+        else if (dispersal_kernel_type_ == DispersalKernelType::Logistic)
+            sample_from(
+                exponential_power_distribution, generator, row, col, count, targets);
+        else
+            throw std::invalid_argument(
+                "RadialDispersalKernel: Unsupported dispersal kernel type");
+    }
+
     /*! Returns true if the kernel class support a given kernel type
      *
      * \warning This function is experimental and may be removed or
@@ -227,6 +269,26 @@ public:
         auto it = std::find(supports.cbegin(), supports.cend(), type);
         return it != supports.cend();
     }
+
+protected:
+    template<typename Distribution, typename Generator>
+    void sample_from(
+        Distribution& distribution,
+        Generator& generator,
+        int row,
+        int col,
+        int count,
+        std::vector<std::tuple<int, int>>& targets)
+    {
+        targets.resize(count);
+        for (auto& target : targets) {
+            double distance = std::abs(distribution.random(generator));
+            double theta = von_mises(generator);
+            target = std::make_tuple(
+                int(row - round(distance * cos(theta) / north_south_resolution)),
+                int(col + round(distance * sin(theta) / east_west_resolution)));
+        }
+    }
 };
 
 }  // namespace pops
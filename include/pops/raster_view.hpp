@@ -0,0 +1,335 @@
+/*
+ * PoPS model - strided views of raster data
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_RASTER_VIEW_HPP
+#define POPS_RASTER_VIEW_HPP
+
+#include "raster.hpp"
+
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace pops {
+
+/**
+ * Non-owning view of raster values stored with arbitrary strides.
+ *
+ * The value at *row* and *col* is at
+ *
+ * ```
+ * data[row * row_stride + col * col_stride]
+ * ```
+ *
+ * which covers dense row-major storage (row stride is the number of
+ * columns, column stride is one), column-major storage used by R
+ * (row stride is one, column stride is the number of rows), and
+ * rectangular sub-windows of both (see window()).
+ *
+ * The view can be used as the raster type of Simulation, Treatments,
+ * SpreadRate, and QuarantineEscape, so the simulation can work directly
+ * with memory owned by the caller without copying or transposing.
+ *
+ * Copying a view creates another view of the same values, i.e., it does
+ * not copy the values. Use assign() to copy values between rasters.
+ * The caller is responsible for keeping the memory alive while the view
+ * is used.
+ *
+ * Code which accesses a whole raster through data() (e.g., output writers
+ * and accuracy_metrics() for all cells) needs a Raster.
+ *
+ * A view of const values (e.g., `RasterView<const double>`) can be used
+ * for read-only inputs.
+ */
+template<typename Number, typename Index = int>
+class RasterView
+{
+private:
+    // Return types of in-place operations with scalars and other rasters
+    template<typename OtherNumber>
+    using ScalarOperationResult = typename std::
+        enable_if<std::is_arithmetic<OtherNumber>::value, const RasterView&>::type;
+    template<typename OtherRaster>
+    using RasterOperationResult = typename std::
+        enable_if<!std::is_arithmetic<OtherRaster>::value, const RasterView&>::type;
+
+public:
+    typedef Number NumberType;
+    typedef Index IndexType;
+
+    RasterView() : data_(nullptr), rows_(0), cols_(0), row_stride_(0), col_stride_(0)
+    {}
+
+    /**
+     * Creates a view of *data* with the given size and strides
+     * (in number of values, not bytes).
+     */
+    RasterView(
+        Number* data, Index rows, Index cols, Index row_stride, Index col_stride = 1)
+        : data_(data),
+          rows_(rows),
+          cols_(cols),
+          row_stride_(row_stride),
+          col_stride_(col_stride)
+    {}
+
+    /** Creates a view of the whole raster */
+    template<typename RasterNumber>
+    RasterView(Raster<RasterNumber, Index>& raster)
+        : RasterView(raster.data(), raster.rows(), raster.cols(), raster.cols(), 1)
+    {}
+
+    /** Creates a view of the whole raster */
+    template<typename RasterNumber>
+    RasterView(const Raster<RasterNumber, Index>& raster)
+        : RasterView(raster.data(), raster.rows(), raster.cols(), raster.cols(), 1)
+    {}
+
+    /** Creates a read-only view from a view of modifiable values */
+    template<typename OtherNumber>
+    RasterView(
+        const RasterView<OtherNumber, Index>& other,
+        typename std::enable_if<
+            std::is_convertible<OtherNumber*, Number*>::value>::type* = nullptr)
+        : RasterView(
+            other.origin(),
+            other.rows(),
+            other.cols(),
+            other.row_stride(),
+            other.col_stride())
+    {}
+
+    /** Creates a view of values stored in row-major order */
+    static RasterView row_major(Number* data, Index rows, Index cols)
+    {
+        return RasterView(data, rows, cols, cols, 1);
+    }
+
+    /** Creates a view of values stored in column-major order (e.g., R matrix) */
+    static RasterView column_major(Number* data, Index rows, Index cols)
+    {
+        return RasterView(data, rows, cols, 1, rows);
+    }
+
+    /**
+     * Returns a view of a rectangular part of this view.
+     *
+     * The window starts at *row* and *col* and has the given size.
+     * Row 0 and column 0 of the window are the given row and column
+     * of this view.
+     */
+    RasterView window(Index row, Index col, Index rows, Index cols) const
+    {
+        if (row < 0 || col < 0 || rows < 0 || cols < 0 || row + rows > rows_
+            || col + cols > cols_)
+            throw std::invalid_argument("RasterView: Window is outside of the view");
+        return RasterView(
+            data_ + offset(row, col),
+            rows,
+            cols,
+            row_stride_,
+            col_stride_);
+    }
+
+    Index rows() const
+    {
+        return rows_;
+    }
+
+    Index cols() const
+    {
+        return cols_;
+    }
+
+    Index row_stride() const
+    {
+        return row_stride_;
+    }
+
+    Index col_stride() const
+    {
+        return col_stride_;
+    }
+
+    /**
+     * Pointer to the value of the first cell (row 0 and column 0)
+     *
+     * Unlike Raster::data(), the values are not necessarily contiguous
+     * and in row-major order (see is_contiguous()), so there is no data()
+     * and code which uses data() as a row-major array does not compile
+     * with a view.
+     */
+    Number* origin() const noexcept
+    {
+        return data_;
+    }
+
+    /** True if the values are stored in row-major order without gaps */
+    bool is_contiguous() const
+    {
+        return col_stride_ == 1 && (row_stride_ == cols_ || rows_ <= 1);
+    }
+
+    Number& operator()(Index row, Index col) const
+    {
+        return data_[offset(row, col)];
+    }
+
+    /** Applies *op* to each value, row by row */
+    template<class UnaryOperation>
+    void for_each(UnaryOperation op) const
+    {
+        for (Index i = 0; i < rows_; ++i) {
+            for (Index j = 0; j < cols_; ++j)
+                op(data_[offset(i, j)]);
+        }
+    }
+
+    void fill(Number value) const
+    {
+        for_each([value](Number& a) { a = value; });
+    }
+
+    void zero() const
+    {
+        fill(0);
+    }
+
+    /**
+     * Copies values from another raster or view of the same size.
+     *
+     * The other raster needs to provide rows(), cols(), and operator().
+     */
+    template<typename OtherRaster>
+    void assign(const OtherRaster& other) const
+    {
+        apply(other, [](Number& a, const Number& b) { a = b; });
+    }
+
+    template<typename OtherNumber>
+    ScalarOperationResult<OtherNumber> operator+=(OtherNumber value) const
+    {
+        for_each([value](Number& a) { a += value; });
+        return *this;
+    }
+
+    template<typename OtherNumber>
+    ScalarOperationResult<OtherNumber> operator-=(OtherNumber value) const
+    {
+        for_each([value](Number& a) { a -= value; });
+        return *this;
+    }
+
+    template<typename OtherNumber>
+    ScalarOperationResult<OtherNumber> operator*=(OtherNumber value) const
+    {
+        for_each([value](Number& a) { a *= value; });
+        return *this;
+    }
+
+    template<typename OtherNumber>
+    ScalarOperationResult<OtherNumber> operator/=(OtherNumber value) const
+    {
+        for_each([value](Number& a) { a /= value; });
+        return *this;
+    }
+
+    template<typename OtherRaster>
+    RasterOperationResult<OtherRaster> operator+=(const OtherRaster& other) const
+    {
+        apply(other, [](Number& a, const Number& b) { a += b; });
+        return *this;
+    }
+
+    template<typename OtherRaster>
+    RasterOperationResult<OtherRaster> operator-=(const OtherRaster& other) const
+    {
+        apply(other, [](Number& a, const Number& b) { a -= b; });
+        return *this;
+    }
+
+    template<typename OtherRaster>
+    RasterOperationResult<OtherRaster> operator*=(const OtherRaster& other) const
+    {
+        apply(other, [](Number& a, const Number& b) { a *= b; });
+        return *this;
+    }
+
+    template<typename OtherRaster>
+    RasterOperationResult<OtherRaster> operator/=(const OtherRaster& other) const
+    {
+        apply(other, [](Number& a, const Number& b) { a /= b; });
+        return *this;
+    }
+
+    /** Compares values (not the memory layout) */
+    template<typename OtherRaster>
+    bool equals(const OtherRaster& other) const
+    {
+        if (rows_ != other.rows() || cols_ != other.cols())
+            return false;
+        for (Index i = 0; i < rows_; ++i)
+            for (Index j = 0; j < cols_; ++j)
+                if ((*this)(i, j) != other(i, j))
+                    return false;
+        return true;
+    }
+
+    friend inline std::ostream&
+    operator<<(std::ostream& stream, const RasterView& view)
+    {
+        stream << "[[";
+        for (Index i = 0; i < view.rows_; i++) {
+            if (i != 0)
+                stream << "],\n [";
+            for (Index j = 0; j < view.cols_; j++) {
+                if (j != 0)
+                    stream << ", ";
+                stream << view(i, j);
+            }
+        }
+        stream << "]]\n";
+        return stream;
+    }
+
+private:
+    Number* data_;
+    Index rows_;
+    Index cols_;
+    Index row_stride_;
+    Index col_stride_;
+
+    std::ptrdiff_t offset(Index row, Index col) const
+    {
+        return std::ptrdiff_t(row) * row_stride_ + std::ptrdiff_t(col) * col_stride_;
+    }
+
+    template<typename OtherRaster, typename BinaryOperation>
+    void apply(const OtherRaster& other, BinaryOperation op) const
+    {
+        if (rows_ != other.rows() || cols_ != other.cols())
+            throw std::invalid_argument(
+                "RasterView: Raster sizes do not match (" + std::to_string(rows_) + "x"
+                + std::to_string(cols_) + " and " + std::to_string(other.rows()) + "x"
+                + std::to_string(other.cols()) + ")");
+        for (Index i = 0; i < rows_; ++i)
+            for (Index j = 0; j < cols_; ++j)
+                op((*this)(i, j), other(i, j));
+    }
+};
+
+}  // namespace pops
+
+#endif  // POPS_RASTER_VIEW_HPP
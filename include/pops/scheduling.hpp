@@ -23,6 +23,7 @@
 #include <tuple>
 #include <string>
 #include <algorithm>
+#include <stdexcept>
 
 #include "date.hpp"
 
@@ -134,16 +135,12 @@ public:
                 "month");
 
         Date date(start_);
-        unsigned step = 0;
         while (date <= end_) {
-            Date start(date);
+            step_starts_.push_back(date.day_number());
             increase_date(date);
-            Date end(date);
-            end.subtract_day();
-            steps.push_back(Step(start, end));
-            step++;
+            step_ends_.push_back(date.day_number() - 1);
         }
-        num_steps = step;
+        num_steps = step_starts_.size();
     }
 
     /**
@@ -159,7 +156,9 @@ public:
      */
     Step get_step(unsigned index) const
     {
-        return steps.at(index);
+        return Step(
+            Date::from_day_number(step_starts_.at(index)),
+            Date::from_day_number(step_ends_.at(index)));
     }
 
     /**
@@ -177,14 +176,12 @@ public:
      */
     std::vector<bool> schedule_spread(const Season& season) const
     {
-        std::vector<bool> schedule;
-        schedule.reserve(num_steps);
-        for (Step step : steps) {
-            if (season.month_in_season(step.start_date().month())
-                || season.month_in_season(step.end_date().month()))
-                schedule.push_back(true);
-            else
-                schedule.push_back(false);
+        std::vector<bool> schedule(num_steps, false);
+        for (unsigned i = 0; i < num_steps; i++) {
+            int start_month = Date::from_day_number(step_starts_[i]).month();
+            int end_month = Date::from_day_number(step_ends_[i]).month();
+            schedule[i] = season.month_in_season(start_month)
+                          || season.month_in_season(end_month);
         }
         return schedule;
     }
@@ -202,16 +199,15 @@ public:
      */
     std::vector<bool> schedule_action_yearly(int month, int day) const
     {
-        std::vector<bool> schedule;
-        schedule.reserve(num_steps);
-        for (Step step : steps) {
-            Date st = step.start_date();
-            Date end = step.end_date();
-            Date test(st.year(), month, day);
-            if ((test >= st && test <= end))
-                schedule.push_back(true);
-            else
-                schedule.push_back(false);
+        std::vector<bool> schedule(num_steps, false);
+        for (unsigned i = 0; i < num_steps; i++) {
+            int year = Date::from_day_number(step_starts_[i]).year();
+            int last_day = Date(year, month, 1).get_last_day_of_month().day();
+            int test = Date(year, month, std::min(day, last_day)).day_number();
+            // A non-existent day (February 29 in a non-leap year) falls between
+            // the last day of the month and the next day.
+            int test_end = day > last_day ? test + 1 : test;
+            schedule[i] = test >= step_starts_[i] && test_end <= step_ends_[i];
         }
         return schedule;
     }
@@ -223,14 +219,9 @@ public:
      */
     std::vector<bool> schedule_action_end_of_year() const
     {
-        std::vector<bool> schedule;
-        schedule.reserve(num_steps);
-        for (Step step : steps) {
-            if (step.end_date().is_last_day_of_year())
-                schedule.push_back(true);
-            else
-                schedule.push_back(false);
-        }
+        std::vector<bool> schedule(num_steps, false);
+        for (unsigned i = 0; i < num_steps; i++)
+            schedule[i] = Date::from_day_number(step_ends_[i]).is_last_day_of_year();
         return schedule;
     }
 
@@ -257,14 +248,9 @@ public:
      */
     std::vector<bool> schedule_action_nsteps(unsigned n_steps) const
     {
-        std::vector<bool> schedule;
-        schedule.reserve(num_steps);
-        for (unsigned i = 0; i < num_steps; i++) {
-            if ((i + 1) % n_steps == 0)
-                schedule.push_back(true);
-            else
-                schedule.push_back(false);
-        }
+        std::vector<bool> schedule(num_steps, false);
+        for (unsigned i = n_steps - 1; i < num_steps; i += n_steps)
+            schedule[i] = true;
         return schedule;
     }
 
@@ -277,15 +263,13 @@ public:
      */
     std::vector<bool> schedule_action_monthly() const
     {
-        std::vector<bool> schedule;
-        schedule.reserve(num_steps);
-        for (Step step : steps) {
-            Date st = step.start_date();
-            Date end = step.end_date();
-            if (st.month() != end.month() || end.is_last_day_of_month())
-                schedule.push_back(true);
-            else
-                schedule.push_back(false);
+        std::vector<bool> schedule(num_steps, false);
+        for (unsigned i = 0; i < num_steps; i++) {
+            // The step contains the end of a month if the next day starts a month
+            // or if the step itself crosses a month boundary.
+            Date start = Date::from_day_number(step_starts_[i]);
+            Date after_end = Date::from_day_number(step_ends_[i] + 1);
+            schedule[i] = after_end.day() == 1 || start.month() != after_end.month();
         }
         return schedule;
     }
@@ -294,14 +278,19 @@ public:
      * @brief Schedule action at a specific date (not repeated action).
      *
      * Should be used within Treatments class.
+     * The step is found using binary search over the step start dates.
      *
      * @param date date to schedule action
      * @return index of step
      */
     unsigned schedule_action_date(const Date& date) const
     {
-        for (unsigned i = 0; i < num_steps; i++) {
-            if (date >= steps[i].start_date() && date <= steps[i].end_date())
+        int day = date.day_number();
+        // first step which starts after the date
+        auto next = std::upper_bound(step_starts_.begin(), step_starts_.end(), day);
+        if (next != step_starts_.begin()) {
+            unsigned i = next - step_starts_.begin() - 1;
+            if (day <= step_ends_[i])
                 return i;
         }
         throw std::invalid_argument("Date is outside of schedule");
@@ -313,18 +302,19 @@ public:
     void debug_schedule(std::vector<bool>& schedule) const
     {
         for (unsigned i = 0; i < num_steps; i++)
-            std::cout << steps[i] << ": " << (schedule.at(i) ? "true" : "false")
+            std::cout << get_step(i) << ": " << (schedule.at(i) ? "true" : "false")
                       << std::endl;
     }
     void debug_schedule(unsigned n) const
     {
         for (unsigned i = 0; i < num_steps; i++)
-            std::cout << steps[i] << ": " << (n == i ? "true" : "false") << std::endl;
+            std::cout << get_step(i) << ": " << (n == i ? "true" : "false")
+                      << std::endl;
     }
     void debug_schedule() const
     {
         for (unsigned i = 0; i < num_steps; i++)
-            std::cout << steps[i] << std::endl;
+            std::cout << get_step(i) << std::endl;
     }
 
 private:
@@ -332,7 +322,9 @@ private:
     Date end_;
     StepUnit simulation_unit_;
     unsigned simulation_num_units_;
-    std::vector<Step> steps;
+    // first and last day of each step as day numbers (see Date::day_number())
+    std::vector<int> step_starts_;
+    std::vector<int> step_ends_;
     unsigned num_steps;
 
     /**
@@ -372,14 +364,31 @@ private:
 unsigned
 simulation_step_to_action_step(const std::vector<bool>& action_schedule, unsigned step)
 {
-    std::vector<unsigned> indices(action_schedule.size());
-    unsigned idx = 0;
-    for (unsigned i = 0; i < action_schedule.size(); i++) {
-        indices[i] = idx;
-        if (action_schedule[i])
-            ++idx;
+    if (step >= action_schedule.size())
+        throw std::out_of_range("simulation_step_to_action_step: Step out of range");
+    return std::count(action_schedule.begin(), action_schedule.begin() + step, true);
+}
+
+/**
+ * Converts all simulation steps to steps of actions at once.
+ *
+ * Item at index *step* is the same as the result of
+ * simulation_step_to_action_step() for that step, so converting a step
+ * is only a lookup when this is computed once for a schedule.
+ *
+ * schedule: [F, T, F, F, F, T, F] -> [0, 0, 1, 1, 1, 1, 2]
+ */
+inline std::vector<unsigned>
+simulation_steps_to_action_steps(const std::vector<bool>& action_schedule)
+{
+    std::vector<unsigned> action_steps;
+    action_steps.reserve(action_schedule.size());
+    unsigned count = 0;
+    for (bool action : action_schedule) {
+        action_steps.push_back(count);
+        count += action;
     }
-    return indices.at(step);
+    return action_steps;
 }
 
 /**
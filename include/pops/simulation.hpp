@@ -19,13 +19,21 @@
 #ifndef POPS_SIMULATION_HPP
 #define POPS_SIMULATION_HPP
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <tuple>
 #include <vector>
 #include <random>
 #include <string>
 #include <stdexcept>
 
+#include "exposed_cohorts.hpp"
+#include "lethal_temperature.hpp"
+#include "movements.hpp"
+#include "outside_dispersers.hpp"
+#include "parallel.hpp"
+#include "spread_rate.hpp"
 #include "utils.hpp"
 
 namespace pops {
@@ -101,7 +109,9 @@ inline ModelType model_type_from_string(const char* text)
  * ```
  *
  * The PoPS library offers a Raster template class to fill this role,
- * but other classes can be used as well.
+ * but other classes can be used as well. RasterView can be used to
+ * simulate directly on memory owned by the caller, e.g., column-major
+ * matrices or a sub-window of a larger raster.
  *
  * Template parameter RasterIndex is type used for maximum indices of
  * the used rasters and should be the same as what the actual raster
@@ -120,7 +130,22 @@ private:
     bool movement_stochasticity_;
     ModelType model_type_;
     unsigned latency_period_;
+    bool two_phase_establishment_;
     std::default_random_engine generator_;
+    // dispersers arriving to each cell (two-phase establishment)
+    std::vector<int> arrivals_;
+    // cells with non-zero arrivals in the order of the first arrival
+    std::vector<std::size_t> arrival_cells_;
+    // updated when infected hosts change (if set)
+    InfectionExtent* infection_extent_{nullptr};
+
+    /** Reports new number of infected hosts in a cell to the infection extent */
+    template<typename Value>
+    void update_extent(int row, int col, Value infected)
+    {
+        if (infection_extent_)
+            infection_extent_->update(row, col, infected);
+    }
 
 public:
     /** Creates simulation object and seeds the internal random number generator.
@@ -140,6 +165,8 @@ public:
      * @param dispersers_stochasticity Enable stochasticity in generating of dispersers
      * @param establishment_stochasticity Enable stochasticity in establishment step
      * @param movement_stochasticity Enable stochasticity in movement of hosts
+     * @param two_phase_establishment Establish dispersers only after all
+     *        are dispersed (see disperse())
      */
     Simulation(
         unsigned random_seed,
@@ -149,20 +176,37 @@ public:
         unsigned latency_period = 0,
         bool dispersers_stochasticity = true,
         bool establishment_stochasticity = true,
-        bool movement_stochasticity = true)
+        bool movement_stochasticity = true,
+        bool two_phase_establishment = false)
         : rows_(rows),
           cols_(cols),
           dispersers_stochasticity_(dispersers_stochasticity),
           establishment_stochasticity_(establishment_stochasticity),
           movement_stochasticity_(movement_stochasticity),
           model_type_(model_type),
-          latency_period_(latency_period)
+          latency_period_(latency_period),
+          two_phase_establishment_(two_phase_establishment)
     {
         generator_.seed(random_seed);
     }
 
     Simulation() = delete;
 
+    /**
+     * Sets extent of infection to update whenever infected hosts change.
+     *
+     * The extent needs to be created from the infected hosts later passed
+     * to the functions of this object, so it stays the same as the extent
+     * of the infected hosts (as long as they are changed only by this object).
+     * disperse() updates the extent only in the SI model where the dispersers
+     * infect the hosts directly.
+     * The extent is not owned by the object. Null stops the updates.
+     */
+    void set_infection_extent(InfectionExtent* extent)
+    {
+        infection_extent_ = extent;
+    }
+
     /** removes infected based on min or max temperature tolerance
      *
      * @param infected Currently infected hosts
@@ -178,7 +222,7 @@ public:
         double lethal_temperature,
         const std::vector<std::vector<int>>& suitable_cells)
     {
-        for (auto indices : suitable_cells) {
+        for (const auto& indices : suitable_cells) {
             int i = indices[0];
             int j = indices[1];
             if (temperature(i, j) < lethal_temperature) {
@@ -186,6 +230,34 @@ public:
                 susceptible(i, j) += infected(i, j);
                 // remove all infestation/infection in the infected class
                 infected(i, j) = 0;
+                update_extent(i, j, 0);
+            }
+        }
+    }
+
+    /** Removes infected in cells with lethal temperature
+     *
+     * This is the same as the other overload, but the cells with
+     * temperature under the lethal temperature were already found
+     * (see LethalTemperatureCells), so only these cells are visited
+     * and only the ones with infected hosts are modified.
+     *
+     * @param infected Currently infected hosts
+     * @param susceptible Currently susceptible hosts
+     * @param lethal_cells Cells with lethal temperature in the current step
+     */
+    void remove(
+        IntegerRaster& infected,
+        IntegerRaster& susceptible,
+        const std::vector<LethalTemperatureCells::Cell>& lethal_cells)
+    {
+        for (const auto& cell : lethal_cells) {
+            int i = cell.row;
+            int j = cell.col;
+            if (infected(i, j) > 0) {
+                susceptible(i, j) += infected(i, j);
+                infected(i, j) = 0;
+                update_extent(i, j, 0);
             }
         }
     }
@@ -217,6 +289,7 @@ public:
                         mortality_current_year += mortality_in_year_index;
                         if (infected(i, j) > 0) {
                             infected(i, j) -= mortality_in_year_index;
+                            update_extent(i, j, infected(i, j));
                         }
                     }
                 }
@@ -235,12 +308,187 @@ public:
      * @param mortality_tracker Hosts that are infected at a specific time step
      * @param total_hosts Total number of hosts
      * @param step the current step of the simulation
+     * @param movements table of movements (only movements for *step* are applied)
+     *
+     * @note Mortality and non-host individuals are not supported in movements.
+     */
+    void movement(
+        IntegerRaster& infected,
+        IntegerRaster& susceptible,
+        IntegerRaster& mortality_tracker,
+        IntegerRaster& total_hosts,
+        unsigned step,
+        const MovementTable<RasterIndex>& movements)
+    {
+        UNUSED(mortality_tracker);  // Mortality is not supported by movements.
+        auto range = movements.step_range(step);
+        for (auto i = range.first; i < range.second; i++) {
+            move_hosts(
+                infected,
+                susceptible,
+                total_hosts,
+                movements.row_from(i),
+                movements.col_from(i),
+                movements.row_to(i),
+                movements.col_to(i),
+                movements.num_hosts(i),
+                generator_);
+        }
+    }
+
+    /** Moves hosts from one location to another processing shipments in batches
+     *
+     * This is an alternative to movement() for large numbers of shipments.
+     * The shipments of the current step are grouped by their source cell and
+     * the groups are processed in parallel using *num_threads* threads.
+     *
+     * The result is defined by the following sequential procedure: The
+     * shipments are applied one by one in the order given by the table
+     * (as in movement()), but the stochastic number of infected hosts in
+     * shipment *k* of the step is drawn from a separate random number stream
+     * which is seeded using *k* and one value drawn from the simulation's
+     * random number generator per step. Consequently, the result does not
+     * depend on the number of threads.
+     *
+     * A source cell which is not a destination of any shipment in the step
+     * changes only by its own shipments, so these source cells are processed
+     * in parallel. A source cell which is also a destination (a conflict)
+     * depends on the order of arrivals and departures, so its shipments are
+     * processed afterwards, one by one in the order of the table, together
+     * with adding the hosts to the destination cells.
+     *
+     * @param infected Currently infected hosts
+     * @param susceptible Currently susceptible hosts
+     * @param mortality_tracker Hosts that are infected at a specific time step
+     * @param total_hosts Total number of hosts
+     * @param step the current step of the simulation
+     * @param movements table of movements (only movements for *step* are applied)
+     * @param num_threads maximum number of threads to use
+     *
+     * @note Mortality and non-host individuals are not supported in movements.
+     */
+    void batched_movement(
+        IntegerRaster& infected,
+        IntegerRaster& susceptible,
+        IntegerRaster& mortality_tracker,
+        IntegerRaster& total_hosts,
+        unsigned step,
+        const MovementTable<RasterIndex>& movements,
+        unsigned num_threads = 1)
+    {
+        UNUSED(mortality_tracker);  // Mortality is not supported by movements.
+        typedef typename MovementTable<RasterIndex>::SizeType SizeType;
+        auto range = movements.step_range(step);
+        SizeType first = range.first;
+        SizeType num_shipments = range.second - range.first;
+        if (!num_shipments)
+            return;
+        std::uint64_t step_seed = generator_();
+        auto source_cell = [this, &movements, first](SizeType shipment) {
+            SizeType index = first + shipment;
+            return static_cast<long long>(movements.row_from(index)) * cols_
+                   + movements.col_from(index);
+        };
+        // Group shipments by source, order of shipments in a group is preserved.
+        std::vector<SizeType> order(num_shipments);
+        for (SizeType i = 0; i < num_shipments; ++i)
+            order[i] = i;
+        std::stable_sort(
+            order.begin(), order.end(), [&source_cell](SizeType a, SizeType b) {
+                return source_cell(a) < source_cell(b);
+            });
+        std::vector<SizeType> group_starts;
+        std::vector<SizeType> shipment_groups(num_shipments);
+        std::vector<long long> sources;
+        for (SizeType i = 0; i < num_shipments; ++i) {
+            long long source = source_cell(order[i]);
+            if (sources.empty() || sources.back() != source) {
+                group_starts.push_back(i);
+                sources.push_back(source);
+            }
+            shipment_groups[order[i]] = sources.size() - 1;
+        }
+        group_starts.push_back(num_shipments);
+        // Sources which are also destinations
+        std::vector<bool> conflicts(sources.size(), false);
+        for (SizeType i = 0; i < num_shipments; ++i) {
+            long long destination =
+                static_cast<long long>(movements.row_to(first + i)) * cols_
+                + movements.col_to(first + i);
+            auto found = std::lower_bound(sources.begin(), sources.end(), destination);
+            if (found != sources.end() && *found == destination)
+                conflicts[found - sources.begin()] = true;
+        }
+        std::vector<MovedHosts> moved(num_shipments);
+        parallel_for_chunks(
+            sources.size(), num_threads, [&](SizeType begin, SizeType end) {
+                for (SizeType group = begin; group < end; ++group) {
+                    if (conflicts[group])
+                        continue;
+                    SizeType group_end = group_starts[group + 1];
+                    for (SizeType j = group_starts[group]; j < group_end; ++j) {
+                        SizeType i = order[j];
+                        std::default_random_engine generator(
+                            substream_seed(step_seed, i));
+                        moved[i] = remove_moving_hosts(
+                            infected,
+                            susceptible,
+                            total_hosts,
+                            movements.row_from(first + i),
+                            movements.col_from(first + i),
+                            movements.num_hosts(first + i),
+                            generator);
+                    }
+                }
+            });
+        for (SizeType i = 0; i < num_shipments; ++i) {
+            RasterIndex row_from = movements.row_from(first + i);
+            RasterIndex col_from = movements.col_from(first + i);
+            if (conflicts[shipment_groups[i]]) {
+                std::default_random_engine generator(substream_seed(step_seed, i));
+                moved[i] = remove_moving_hosts(
+                    infected,
+                    susceptible,
+                    total_hosts,
+                    row_from,
+                    col_from,
+                    movements.num_hosts(first + i),
+                    generator);
+            }
+            // Sources removed in parallel are updated here.
+            update_extent(row_from, col_from, infected(row_from, col_from));
+            add_moved_hosts(
+                infected,
+                susceptible,
+                total_hosts,
+                movements.row_to(first + i),
+                movements.col_to(first + i),
+                moved[i]);
+        }
+    }
+
+    /** Moves hosts from one location to another
+     *
+     * This is a variant of movement() which processes the movements
+     * starting at *last_index* and stops at the first movement which is not
+     * scheduled for the current step. The movements need to be ordered by
+     * step. The movement() function with MovementTable does not require
+     * tracking of the index.
+     *
+     * @param infected Currently infected hosts
+     * @param susceptible Currently susceptible hosts
+     * @param mortality_tracker Hosts that are infected at a specific time step
+     * @param total_hosts Total number of hosts
+     * @param step the current step of the simulation
      * @param last_index the last index to not be used from movements
      * @param movements a vector of ints with row_from, col_from, row_to, col_to, and
      * num_hosts
      * @param movement_schedule a vector matching movements with the step at which the
      * movement from movements are applied
      *
+     * @returns index of the first movement not applied (*last_index* for the
+     * next call)
+     *
      * @note Mortality and non-host individuals are not supported in movements.
      */
     unsigned movement(
@@ -251,75 +499,25 @@ public:
         unsigned step,
         unsigned last_index,
         const std::vector<std::vector<int>>& movements,
-        std::vector<unsigned> movement_schedule)
+        const std::vector<unsigned>& movement_schedule)
     {
         UNUSED(mortality_tracker);  // Mortality is not supported by movements.
         for (unsigned i = last_index; i < movements.size(); i++) {
-            auto moved = movements[i];
+            const auto& moved = movements[i];
             unsigned move_schedule = movement_schedule[i];
             if (move_schedule != step) {
                 return i;
             }
-            int infected_moved = 0;
-            int susceptible_moved = 0;
-            int total_hosts_moved = 0;
-            double inf_ratio = 0;
-            int row_from = moved[0];
-            int col_from = moved[1];
-            int row_to = moved[2];
-            int col_to = moved[3];
-            int hosts = moved[4];
-            if (hosts > total_hosts(row_from, col_from)) {
-                total_hosts_moved = total_hosts(row_from, col_from);
-            }
-            else {
-                total_hosts_moved = hosts;
-            }
-            if (infected(row_from, col_from) > 0
-                && susceptible(row_from, col_from) > 0) {
-                inf_ratio = double(infected(row_from, col_from))
-                            / double(total_hosts(row_from, col_from));
-                int infected_mean = total_hosts_moved * inf_ratio;
-                if (infected_mean > 0) {
-                    if (movement_stochasticity_) {
-                        std::poisson_distribution<int> distribution(infected_mean);
-                        infected_moved = distribution(generator_);
-                    }
-                    else {
-                        infected_moved = infected_mean;
-                    }
-                }
-                if (infected_moved > infected(row_from, col_from)) {
-                    infected_moved = infected(row_from, col_from);
-                }
-                if (infected_moved > total_hosts_moved) {
-                    infected_moved = total_hosts_moved;
-                }
-                susceptible_moved = total_hosts_moved - infected_moved;
-                if (susceptible_moved > susceptible(row_from, col_from)) {
-                    susceptible_moved = susceptible(row_from, col_from);
-                }
-            }
-            else if (
-                infected(row_from, col_from) > 0
-                && susceptible(row_from, col_from) == 0) {
-                infected_moved = total_hosts_moved;
-            }
-            else if (
-                infected(row_from, col_from) == 0
-                && susceptible(row_from, col_from) > 0) {
-                susceptible_moved = total_hosts_moved;
-            }
-            else {
-                continue;
-            }
-
-            infected(row_from, col_from) -= infected_moved;
-            susceptible(row_from, col_from) -= susceptible_moved;
-            total_hosts(row_from, col_from) -= total_hosts_moved;
-            infected(row_to, col_to) += infected_moved;
-            susceptible(row_to, col_to) += susceptible_moved;
-            total_hosts(row_to, col_to) += total_hosts_moved;
+            move_hosts(
+                infected,
+                susceptible,
+                total_hosts,
+                moved[0],
+                moved[1],
+                moved[2],
+                moved[3],
+                moved[4],
+                generator_);
         }
         return movements.size();
     }
@@ -376,13 +574,33 @@ public:
      * create dispersers. In SEI model, the infect_exposed() function is
      * typically called afterwards.
      *
-     * DispersalKernel is callable object or function with one parameter
-     * which is the random number engine (generator). The return value
-     * is row and column in the raster (or outside of it). The current
-     * position is passed as parameters. The return value is in the
-     * form of a tuple with row and column so that std::tie() is usable
-     * on the result, i.e. function returning
-     * `std::make_tuple(row, column)` fulfills this requirement.
+     * DispersalKernel is an object with a sample() function which takes
+     * the random number engine (generator), the current position (row and
+     * column), the number of dispersers, and a vector which it fills with
+     * the new positions, one for each disperser. Each position is a tuple
+     * with row and column in the raster (or outside of it). All dispersers
+     * from one cell are sampled at once before they are established, so the
+     * kernel is called once per cell instead of once per disperser.
+     *
+     * If the kernel also has a sample_counts() function (see
+     * AliasDispersalKernel::sample_counts()), it is used instead of sample()
+     * and it gives each target position with the number of dispersers going
+     * there. Dispersers going to one cell are then established together
+     * and, with establishment stochasticity, only the dispersers which
+     * establish need a random number, so the cost is proportional to the
+     * number of target cells and established dispersers rather than to
+     * the number of dispersers.
+     *
+     * With two-phase establishment (see the constructor), dispersers from all
+     * cells are first dispersed and only counted in their target cells
+     * without changing any hosts. The establishment is then resolved once for
+     * each target cell with all the dispersers which arrived there.
+     * The sampling of targets thus does not depend on the state of the hosts.
+     * The weather coefficient of the source cell is applied during
+     * the dispersal as the probability that a disperser survives, so
+     * the results follow the same distribution as without the two phases
+     * (for weather coefficients up to one), but they are not the same.
+     * With weather, this requires establishment stochasticity.
      *
      * The *total_populations* can be total number of hosts in the basic case
      * or it can be the total size of population of all relevant species
@@ -400,74 +618,107 @@ public:
      * @param[in,out] mortality_tracker Newly infected hosts (if applicable)
      * @param[in] total_populations All host and non-host individuals in the area
      * @param[in,out] outside_dispersers Dispersers escaping the rasters
+     * (vector with one item per disperser or AggregatedOutsideDispersers)
      * @param weather Whether or not weather coefficients should be used
      * @param[in] weather_coefficient Weather coefficient for each location
      * @param dispersal_kernel Dispersal kernel to move dispersers
      * @param establishment_probability Probability of establishment with no
      * stochasticity
      *
+     * The *exposed_or_infected* can be also ExposedCohorts which takes
+     * the hosts as exposed in the current step.
+     *
      * @note If the parameters or their default values don't correspond
      * with the disperse_and_infect() function, it is a bug.
      */
-    template<typename DispersalKernel>
+    template<
+        typename DispersalKernel,
+        typename OutsideDispersers,
+        typename ExposedOrInfected>
     void disperse(
         const IntegerRaster& dispersers,
         IntegerRaster& susceptible,
-        IntegerRaster& exposed_or_infected,
+        ExposedOrInfected& exposed_or_infected,
         IntegerRaster& mortality_tracker,
         const IntegerRaster& total_populations,
-        std::vector<std::tuple<int, int>>& outside_dispersers,
+        OutsideDispersers& outside_dispersers,
         bool weather,
         const FloatRaster& weather_coefficient,
         DispersalKernel& dispersal_kernel,
         const std::vector<std::vector<int>>& suitable_cells,
         double establishment_probability = 0.5)
     {
-        std::uniform_real_distribution<double> distribution_uniform(0.0, 1.0);
+        if (two_phase_establishment_ && weather && !establishment_stochasticity_)
+            throw std::invalid_argument(
+                "Simulation::disperse: Two-phase establishment with weather"
+                " requires establishment stochasticity");
         int row;
         int col;
+        int count;
+        // targets of all dispersers from one cell
+        std::vector<std::tuple<int, int>> targets;
+        // targets with number of dispersers (if provided by the kernel)
+        std::vector<std::tuple<int, int, int>> counted_targets;
+        if (two_phase_establishment_ && arrivals_.empty())
+            arrivals_.assign(std::size_t(rows_) * cols_, 0);
 
         for (auto indices : suitable_cells) {
             int i = indices[0];
             int j = indices[1];
-            if (dispersers(i, j) > 0) {
-                for (int k = 0; k < dispersers(i, j); k++) {
-                    std::tie(row, col) = dispersal_kernel(generator_, i, j);
-                    if (row < 0 || row >= rows_ || col < 0 || col >= cols_) {
-                        // export dispersers dispersed outside of modeled area
-                        outside_dispersers.emplace_back(std::make_tuple(row, col));
-                        continue;
-                    }
-                    if (susceptible(row, col) > 0) {
-                        double probability_of_establishment =
-                            (double)(susceptible(row, col))
-                            / total_populations(row, col);
-                        double establishment_tester = 1 - establishment_probability;
-                        if (establishment_stochasticity_)
-                            establishment_tester = distribution_uniform(generator_);
-
-                        if (weather)
-                            probability_of_establishment *= weather_coefficient(i, j);
-                        if (establishment_tester < probability_of_establishment) {
-                            exposed_or_infected(row, col) += 1;
-                            susceptible(row, col) -= 1;
-                            if (model_type_ == ModelType::SusceptibleInfected) {
-                                mortality_tracker(row, col) += 1;
-                            }
-                            else if (
-                                model_type_ == ModelType::SusceptibleExposedInfected) {
-                                // no-op
-                            }
-                            else {
-                                throw std::runtime_error(
-                                    "Unknown ModelType value in "
-                                    "Simulation::disperse()");
-                            }
-                        }
-                    }
+            if (dispersers(i, j) <= 0)
+                continue;
+            double weather_factor = weather ? weather_coefficient(i, j) : 1;
+            // Establishes (or only records) *count* dispersers arriving
+            // to *row* and *col*.
+            auto arrive = [&](int row, int col, int count) {
+                if (row < 0 || row >= rows_ || col < 0 || col >= cols_) {
+                    // export dispersers dispersed outside of modeled area
+                    add_outside_dispersers(outside_dispersers, row, col, count);
+                    return;
                 }
+                if (two_phase_establishment_)
+                    record_arrivals(row, col, count, weather_factor);
+                else
+                    establish_dispersers(
+                        row,
+                        col,
+                        count,
+                        weather_factor,
+                        susceptible,
+                        exposed_or_infected,
+                        mortality_tracker,
+                        total_populations,
+                        establishment_probability);
+            };
+            sample_targets(
+                dispersal_kernel, i, j, dispersers(i, j), targets, counted_targets, 0);
+            for (const auto& target : targets) {
+                std::tie(row, col) = target;
+                arrive(row, col, 1);
+            }
+            for (const auto& target : counted_targets) {
+                std::tie(row, col, count) = target;
+                arrive(row, col, count);
             }
         }
+        if (!two_phase_establishment_)
+            return;
+        // Weather was already applied to the arrivals.
+        for (auto index : arrival_cells_) {
+            count = arrivals_[index];
+            arrivals_[index] = 0;
+            establish_dispersers(
+                index / cols_,
+                index % cols_,
+                count,
+                1,
+                susceptible,
+                exposed_or_infected,
+                mortality_tracker,
+                total_populations,
+                establishment_probability);
+        }
+        arrival_cells_.clear();
     }
 
     /** Move overflowing pest population to other hosts.
@@ -499,12 +750,12 @@ public:
      * @note Mortality is not supported by this function, i.e., the mortality rasters
      *       are not modified while the infected are.
      */
-    template<typename DispersalKernel>
+    template<typename DispersalKernel, typename OutsideDispersers>
     void move_overpopulated_pests(
         IntegerRaster& susceptible,
         IntegerRaster& infected,
         const IntegerRaster& total_hosts,
-        std::vector<std::tuple<int, int>>& outside_dispersers,
+        OutsideDispersers& outside_dispersers,
         DispersalKernel& dispersal_kernel,
         const std::vector<std::vector<int>>& suitable_cells,
         double overpopulation_percentage,
@@ -539,11 +790,10 @@ public:
                 int leaving = original_count * leaving_percentage;
                 susceptible(i, j) += leaving;
                 infected(i, j) -= leaving;
+                update_extent(i, j, infected(i, j));
                 if (row < 0 || row >= rows_ || col < 0 || col >= cols_) {
                     // Collect pests dispersed outside of modeled area.
-                    outside_dispersers.reserve(outside_dispersers.size() + leaving);
-                    for (int pest = 0; pest < leaving; ++pest)
-                        outside_dispersers.emplace_back(row, col);
+                    add_outside_dispersers(outside_dispersers, row, col, leaving);
                     continue;
                 }
                 // Doing the move here would create inconsistent results as some
@@ -574,6 +824,7 @@ public:
                 susceptible(row, col) -= leaving;
                 infected(row, col) += leaving;
             }
+            update_extent(row, col, infected(row, col));
         }
     }
 
@@ -628,6 +879,12 @@ public:
             if (step >= latency_period_) {
                 // Oldest item needs to be in the front
                 auto& oldest = exposed.front();
+                if (infection_extent_) {
+                    for (RasterIndex i = 0; i < rows_; ++i)
+                        for (RasterIndex j = 0; j < cols_; ++j)
+                            if (oldest(i, j) > 0)
+                                update_extent(i, j, infected(i, j) + oldest(i, j));
+                }
                 // Move hosts to infected raster
                 infected += oldest;
                 mortality_tracker += oldest;
@@ -650,6 +907,45 @@ public:
         }
     }
 
+    /** Infect exposed hosts stored as cohorts of cells
+     *
+     * This is the same as the other overload, but only the cells of
+     * the oldest cohort are visited. The latency period of *exposed*
+     * needs to be the same as the latency period of the simulation.
+     * Hosts exposed in the current step are stored as the youngest cohort.
+     */
+    void infect_exposed(
+        unsigned step,
+        ExposedCohorts& exposed,
+        IntegerRaster& infected,
+        IntegerRaster& mortality_tracker)
+    {
+        if (model_type_ == ModelType::SusceptibleExposedInfected) {
+            if (exposed.latency_period() != latency_period_)
+                throw std::invalid_argument(
+                    "Simulation::infect_exposed: Latency period of exposed cohorts"
+                    " differs from the latency period of the simulation");
+            exposed.store_youngest();
+            if (step >= latency_period_) {
+                auto& oldest = exposed.oldest();
+                for (const auto& cell : oldest) {
+                    infected(cell.row, cell.col) += cell.count;
+                    mortality_tracker(cell.row, cell.col) += cell.count;
+                    update_extent(cell.row, cell.col, infected(cell.row, cell.col));
+                }
+                oldest.clear();
+            }
+            exposed.rotate();
+        }
+        else if (model_type_ == ModelType::SusceptibleInfected) {
+            // no-op
+        }
+        else {
+            throw std::runtime_error(
+                "Unknown ModelType value in Simulation::infect_exposed()");
+        }
+    }
+
     /** Disperse, expose, and infect based on dispersers
      *
      * This function wraps disperse() and infect_exposed() for use in SI
@@ -674,45 +970,312 @@ public:
      * while this function's parameter *infected* is always the infected
      * individuals. Besides parameters from disperse(), this function
      * has parameter *exposed* which is the same as the one from the
-     * infect_exposed() function.
+     * infect_exposed() function, i.e., a vector of rasters or ExposedCohorts.
      */
-    template<typename DispersalKernel>
+    template<typename DispersalKernel, typename OutsideDispersers, typename Exposed>
     void disperse_and_infect(
         unsigned step,
         const IntegerRaster& dispersers,
         IntegerRaster& susceptible,
-        std::vector<IntegerRaster>& exposed,
+        Exposed& exposed,
         IntegerRaster& infected,
         IntegerRaster& mortality_tracker,
         const IntegerRaster& total_populations,
-        std::vector<std::tuple<int, int>>& outside_dispersers,
+        OutsideDispersers& outside_dispersers,
         bool weather,
         const FloatRaster& weather_coefficient,
         DispersalKernel& dispersal_kernel,
         const std::vector<std::vector<int>>& suitable_cells,
         double establishment_probability = 0.5)
     {
-        auto* infected_or_exposed = &infected;
-        if (model_type_ == ModelType::SusceptibleExposedInfected) {
-            // The empty - not yet exposed - raster is in the back
-            // and will become youngest exposed one.
-            infected_or_exposed = &exposed.back();
-        }
-        this->disperse(
-            dispersers,
-            susceptible,
-            *infected_or_exposed,
-            mortality_tracker,
-            total_populations,
-            outside_dispersers,
-            weather,
-            weather_coefficient,
-            dispersal_kernel,
-            suitable_cells,
-            establishment_probability);
         if (model_type_ == ModelType::SusceptibleExposedInfected) {
+            this->disperse(
+                dispersers,
+                susceptible,
+                youngest_exposed(exposed),
+                mortality_tracker,
+                total_populations,
+                outside_dispersers,
+                weather,
+                weather_coefficient,
+                dispersal_kernel,
+                suitable_cells,
+                establishment_probability);
             this->infect_exposed(step, exposed, infected, mortality_tracker);
         }
+        else {
+            this->disperse(
+                dispersers,
+                susceptible,
+                infected,
+                mortality_tracker,
+                total_populations,
+                outside_dispersers,
+                weather,
+                weather_coefficient,
+                dispersal_kernel,
+                suitable_cells,
+                establishment_probability);
+        }
+    }
+
+private:
+    /** Returns the empty - not yet exposed - raster which will become
+     * the youngest exposed one (it is in the back)
+     */
+    IntegerRaster& youngest_exposed(std::vector<IntegerRaster>& exposed)
+    {
+        return exposed.back();
+    }
+
+    /** Returns cohorts which take the hosts exposed in the current step */
+    ExposedCohorts& youngest_exposed(ExposedCohorts& exposed)
+    {
+        return exposed;
+    }
+
+    /** Establishes *count* dispersers arriving to *row* and *col*
+     *
+     * Dispersers establish one after another, so the probability of
+     * establishment decreases with each established one. Probability
+     * of establishment is multiplied by *weather_factor*.
+     */
+    template<typename ExposedOrInfected>
+    void establish_dispersers(
+        int row,
+        int col,
+        int count,
+        double weather_factor,
+        IntegerRaster& susceptible,
+        ExposedOrInfected& exposed_or_infected,
+        IntegerRaster& mortality_tracker,
+        const IntegerRaster& total_populations,
+        double establishment_probability)
+    {
+        std::uniform_real_distribution<double> distribution_uniform(0.0, 1.0);
+        while (count > 0 && susceptible(row, col) > 0) {
+            double probability_of_establishment =
+                (double)(susceptible(row, col)) / total_populations(row, col);
+            probability_of_establishment *= weather_factor;
+            if (!establishment_stochasticity_) {
+                if (1 - establishment_probability >= probability_of_establishment)
+                    return;
+            }
+            else if (count == 1) {
+                if (distribution_uniform(generator_) >= probability_of_establishment)
+                    return;
+            }
+            else if (probability_of_establishment < 1) {
+                if (probability_of_establishment <= 0)
+                    return;
+                // Skip dispersers which fail before the next one establishes.
+                std::geometric_distribution<long long> failures(
+                    probability_of_establishment);
+                count -= std::min<long long>(failures(generator_), count);
+                if (!count)
+                    return;
+            }
+            exposed_or_infected(row, col) += 1;
+            susceptible(row, col) -= 1;
+            --count;
+            if (model_type_ == ModelType::SusceptibleInfected) {
+                mortality_tracker(row, col) += 1;
+                update_extent(row, col, exposed_or_infected(row, col));
+            }
+            else if (model_type_ == ModelType::SusceptibleExposedInfected) {
+                // no-op
+            }
+            else {
+                throw std::runtime_error(
+                    "Unknown ModelType value in Simulation::disperse()");
+            }
+        }
+    }
+
+    /** Adds dispersers arriving to *row* and *col* to the arrivals
+     *
+     * With weather, only the dispersers which survive the weather
+     * (probability given by *weather_factor*) are added, so the establishment
+     * does not need to know where the dispersers came from.
+     */
+    void record_arrivals(int row, int col, int count, double weather_factor)
+    {
+        if (weather_factor < 1) {
+            if (weather_factor <= 0)
+                return;
+            if (count == 1) {
+                std::uniform_real_distribution<double> distribution_uniform(0.0, 1.0);
+                if (distribution_uniform(generator_) >= weather_factor)
+                    return;
+            }
+            else {
+                std::binomial_distribution<int> surviving(count, weather_factor);
+                count = surviving(generator_);
+                if (!count)
+                    return;
+            }
+        }
+        std::size_t index = std::size_t(row) * cols_ + col;
+        if (!arrivals_[index])
+            arrival_cells_.push_back(index);
+        arrivals_[index] += count;
+    }
+
+    /** Samples targets using the kernel's sample_counts() function
+     *
+     * This overload is used for kernels which provide sample_counts()
+     * (preferred because of the int tag).
+     */
+    template<typename DispersalKernel>
+    auto sample_targets(
+        DispersalKernel& dispersal_kernel,
+        int row,
+        int col,
+        int count,
+        std::vector<std::tuple<int, int>>& targets,
+        std::vector<std::tuple<int, int, int>>& counted_targets,
+        int)
+        -> decltype(dispersal_kernel.sample_counts(
+            generator_, row, col, count, counted_targets))
+    {
+        targets.clear();
+        dispersal_kernel.sample_counts(generator_, row, col, count, counted_targets);
+    }
+
+    /** Samples targets using the kernel's sample() function
+     */
+    template<typename DispersalKernel>
+    void sample_targets(
+        DispersalKernel& dispersal_kernel,
+        int row,
+        int col,
+        int count,
+        std::vector<std::tuple<int, int>>& targets,
+        std::vector<std::tuple<int, int, int>>& counted_targets,
+        long)
+    {
+        counted_targets.clear();
+        dispersal_kernel.sample(generator_, row, col, count, targets);
+    }
+
+    /** Numbers of hosts moved by one shipment
+     */
+    struct MovedHosts
+    {
+        int infected{0};
+        int susceptible{0};
+        int total_hosts{0};
+    };
+
+    /** Removes hosts of one shipment from the source cell
+     *
+     * The number of infected hosts moved is based on the ratio of infected
+     * hosts in the source cell and, if enabled, it is stochastic.
+     *
+     * @returns numbers of hosts which left the source cell
+     */
+    template<typename Generator>
+    MovedHosts remove_moving_hosts(
+        IntegerRaster& infected,
+        IntegerRaster& susceptible,
+        IntegerRaster& total_hosts,
+        RasterIndex row_from,
+        RasterIndex col_from,
+        int hosts,
+        Generator& generator)
+    {
+        int infected_moved = 0;
+        int susceptible_moved = 0;
+        int total_hosts_moved = 0;
+        double inf_ratio = 0;
+        if (hosts > total_hosts(row_from, col_from)) {
+            total_hosts_moved = total_hosts(row_from, col_from);
+        }
+        else {
+            total_hosts_moved = hosts;
+        }
+        if (infected(row_from, col_from) > 0 && susceptible(row_from, col_from) > 0) {
+            inf_ratio = double(infected(row_from, col_from))
+                        / double(total_hosts(row_from, col_from));
+            int infected_mean = total_hosts_moved * inf_ratio;
+            if (infected_mean > 0) {
+                if (movement_stochasticity_) {
+                    std::poisson_distribution<int> distribution(infected_mean);
+                    infected_moved = distribution(generator);
+                }
+                else {
+                    infected_moved = infected_mean;
+                }
+            }
+            if (infected_moved > infected(row_from, col_from)) {
+                infected_moved = infected(row_from, col_from);
+            }
+            if (infected_moved > total_hosts_moved) {
+                infected_moved = total_hosts_moved;
+            }
+            susceptible_moved = total_hosts_moved - infected_moved;
+            if (susceptible_moved > susceptible(row_from, col_from)) {
+                susceptible_moved = susceptible(row_from, col_from);
+            }
+        }
+        else if (
+            infected(row_from, col_from) > 0
+            && susceptible(row_from, col_from) == 0) {
+            infected_moved = total_hosts_moved;
+        }
+        else if (
+            infected(row_from, col_from) == 0
+            && susceptible(row_from, col_from) > 0) {
+            susceptible_moved = total_hosts_moved;
+        }
+        else {
+            return MovedHosts();
+        }
+
+        infected(row_from, col_from) -= infected_moved;
+        susceptible(row_from, col_from) -= susceptible_moved;
+        total_hosts(row_from, col_from) -= total_hosts_moved;
+        MovedHosts moved;
+        moved.infected = infected_moved;
+        moved.susceptible = susceptible_moved;
+        moved.total_hosts = total_hosts_moved;
+        return moved;
+    }
+
+    /** Adds hosts of one shipment to the destination cell
+     */
+    void add_moved_hosts(
+        IntegerRaster& infected,
+        IntegerRaster& susceptible,
+        IntegerRaster& total_hosts,
+        RasterIndex row_to,
+        RasterIndex col_to,
+        const MovedHosts& moved)
+    {
+        infected(row_to, col_to) += moved.infected;
+        susceptible(row_to, col_to) += moved.susceptible;
+        total_hosts(row_to, col_to) += moved.total_hosts;
+        update_extent(row_to, col_to, infected(row_to, col_to));
+    }
+
+    /** Moves hosts of one shipment from one cell to another
+     */
+    template<typename Generator>
+    void move_hosts(
+        IntegerRaster& infected,
+        IntegerRaster& susceptible,
+        IntegerRaster& total_hosts,
+        RasterIndex row_from,
+        RasterIndex col_from,
+        RasterIndex row_to,
+        RasterIndex col_to,
+        int hosts,
+        Generator& generator)
+    {
+        auto moved = remove_moving_hosts(
+            infected, susceptible, total_hosts, row_from, col_from, hosts, generator);
+        update_extent(row_from, col_from, infected(row_from, col_from));
+        add_moved_hosts(infected, susceptible, total_hosts, row_to, col_to, moved);
     }
 };
 
@@ -18,12 +18,113 @@
 
 #include "utils.hpp"
 
+#include <cstddef>
 #include <tuple>
 #include <vector>
 #include <cmath>
 
 namespace pops {
 
+/**
+ * Incrementally maintained extent (bounding box) of infection.
+ *
+ * Keeps number of infected cells in each row and in each column,
+ * so the bounding box is available in O(rows + cols) without scanning
+ * the whole raster. Code which changes the infected raster needs to
+ * report the new value of each changed cell using update().
+ */
+class InfectionExtent
+{
+public:
+    InfectionExtent(int rows, int cols)
+        : rows_(rows),
+          cols_(cols),
+          num_infected_cells_(0),
+          infected_cells_(std::size_t(rows) * cols, false),
+          row_counts_(rows, 0),
+          col_counts_(cols, 0)
+    {}
+
+    /**
+     * Initializes the extent from the infected raster.
+     */
+    template<typename Raster>
+    InfectionExtent(
+        const Raster& infected, const std::vector<std::vector<int>>& suitable_cells)
+        : InfectionExtent(infected.rows(), infected.cols())
+    {
+        for (const auto& indices : suitable_cells)
+            update(indices[0], indices[1], infected(indices[0], indices[1]));
+    }
+
+    /**
+     * Records new number of infected hosts in a cell.
+     */
+    template<typename Value>
+    void update(int row, int col, Value value)
+    {
+        bool infected = value > 0;
+        auto cell = infected_cells_.begin() + std::size_t(row) * cols_ + col;
+        if (*cell == infected)
+            return;
+        *cell = infected;
+        int change = infected ? 1 : -1;
+        row_counts_[row] += change;
+        col_counts_[col] += change;
+        num_infected_cells_ += change;
+    }
+
+    int rows() const
+    {
+        return rows_;
+    }
+
+    int cols() const
+    {
+        return cols_;
+    }
+
+    /**
+     * Returns number of cells with infection.
+     */
+    int num_infected_cells() const
+    {
+        return num_infected_cells_;
+    }
+
+    /**
+     * Returns north, south, east, west coordinates (as number of rows/cols)
+     * of the bbox of infection. If there is no infection, returns -1 for all
+     * directions.
+     */
+    BBoxInt bbox() const
+    {
+        if (!num_infected_cells_)
+            return std::make_tuple(-1, -1, -1, -1);
+        int n = 0;
+        while (!row_counts_[n])
+            ++n;
+        int s = rows_ - 1;
+        while (!row_counts_[s])
+            --s;
+        int w = 0;
+        while (!col_counts_[w])
+            ++w;
+        int e = cols_ - 1;
+        while (!col_counts_[e])
+            --e;
+        return std::make_tuple(n, s, e, w);
+    }
+
+private:
+    int rows_;
+    int cols_;
+    int num_infected_cells_;
+    std::vector<bool> infected_cells_;
+    std::vector<int> row_counts_;
+    std::vector<int> col_counts_;
+};
+
 /**
  * Class storing and computing step spread rate for one simulation.
  */
@@ -110,6 +211,40 @@ private:
         return true;
     }
 
+    /**
+     * Stores bbox of infection for a step and computes the step spread rate
+     * from it and from bbox of the previous step.
+     */
+    void set_step_boundary(const BBoxInt& bbox, unsigned step)
+    {
+        boundaries.at(step + 1) = bbox;
+        if (!is_boundary_valid(bbox)) {
+            rates.at(step) =
+                std::make_tuple(std::nan(""), std::nan(""), std::nan(""), std::nan(""));
+            return;
+        }
+        int n1, n2, s1, s2, e1, e2, w1, w2;
+        std::tie(n1, s1, e1, w1) = boundaries.at(step);
+        std::tie(n2, s2, e2, w2) = bbox;
+        double n_rate = ((n1 - n2) * north_south_resolution);
+        double s_rate = ((s2 - s1) * north_south_resolution);
+        double e_rate = ((e2 - e1) * west_east_resolution);
+        double w_rate = ((w1 - w2) * west_east_resolution);
+
+        bool bn, bs, be, bw;
+        std::tie(bn, bs, be, bw) = is_out_of_bounds(bbox);
+        if (n_rate == 0 && bn)
+            n_rate = std::nan("");
+        if (s_rate == 0 && bs)
+            s_rate = std::nan("");
+        if (e_rate == 0 && be)
+            e_rate = std::nan("");
+        if (w_rate == 0 && bw)
+            w_rate = std::nan("");
+
+        rates.at(step) = std::make_tuple(n_rate, s_rate, e_rate, w_rate);
+    }
+
 public:
     SpreadRate(
         const Raster& raster,
@@ -130,6 +265,25 @@ public:
         boundaries.at(0) = infection_boundary(raster, suitable_cells);
     }
 
+    /**
+     * Creates the spread rate tracker with the initial bbox of infection
+     * taken from the incrementally maintained extent.
+     */
+    SpreadRate(
+        const InfectionExtent& extent, double ew_res, double ns_res, unsigned num_steps)
+        : width(extent.cols()),
+          height(extent.rows()),
+          west_east_resolution(ew_res),
+          north_south_resolution(ns_res),
+          num_steps(num_steps),
+          boundaries(num_steps + 1, std::make_tuple(0, 0, 0, 0)),
+          rates(
+              num_steps,
+              std::make_tuple(std::nan(""), std::nan(""), std::nan(""), std::nan("")))
+    {
+        boundaries.at(0) = extent.bbox();
+    }
+
     SpreadRate() = delete;
 
     /**
@@ -153,33 +307,17 @@ public:
         unsigned step,
         const std::vector<std::vector<int>>& suitable_cells)
     {
-        BBoxInt bbox = infection_boundary(raster, suitable_cells);
-        boundaries.at(step + 1) = bbox;
-        if (!is_boundary_valid(bbox)) {
-            rates.at(step) =
-                std::make_tuple(std::nan(""), std::nan(""), std::nan(""), std::nan(""));
-            return;
-        }
-        int n1, n2, s1, s2, e1, e2, w1, w2;
-        std::tie(n1, s1, e1, w1) = boundaries.at(step);
-        std::tie(n2, s2, e2, w2) = bbox;
-        double n_rate = ((n1 - n2) * north_south_resolution);
-        double s_rate = ((s2 - s1) * north_south_resolution);
-        double e_rate = ((e2 - e1) * west_east_resolution);
-        double w_rate = ((w1 - w2) * west_east_resolution);
-
-        bool bn, bs, be, bw;
-        std::tie(bn, bs, be, bw) = is_out_of_bounds(bbox);
-        if (n_rate == 0 && bn)
-            n_rate = std::nan("");
-        if (s_rate == 0 && bs)
-            s_rate = std::nan("");
-        if (e_rate == 0 && be)
-            e_rate = std::nan("");
-        if (w_rate == 0 && bw)
-            w_rate = std::nan("");
+        set_step_boundary(infection_boundary(raster, suitable_cells), step);
+    }
 
-        rates.at(step) = std::make_tuple(n_rate, s_rate, e_rate, w_rate);
+    /**
+     * Computes spread rate in the same way as the other overload, but uses
+     * incrementally maintained extent of infection instead of scanning
+     * the infection raster.
+     */
+    void compute_step_spread_rate(const InfectionExtent& extent, unsigned step)
+    {
+        set_step_boundary(extent.bbox(), step);
     }
 };
 
@@ -16,6 +16,16 @@
 #ifndef POPS_STATISTICS_HPP
 #define POPS_STATISTICS_HPP
 
+#include "exposed_cohorts.hpp"
+#include "parallel.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 namespace pops {
 
 /**
@@ -23,11 +33,11 @@ namespace pops {
  * from all cells of a raster.
  */
 template<typename IntegerRaster>
-unsigned sum_of_infected(
+std::uint64_t sum_of_infected(
     const IntegerRaster& infected, const std::vector<std::vector<int>>& suitable_cells)
 {
-    unsigned sum = 0;
-    for (auto indices : suitable_cells) {
+    std::uint64_t sum = 0;
+    for (const auto& indices : suitable_cells) {
         int i = indices[0];
         int j = indices[1];
         sum += infected(i, j);
@@ -45,8 +55,8 @@ double area_of_infected(
     double ns_res,
     const std::vector<std::vector<int>>& suitable_cells)
 {
-    unsigned cells = 0;
-    for (auto indices : suitable_cells) {
+    std::uint64_t cells = 0;
+    for (const auto& indices : suitable_cells) {
         int i = indices[0];
         int j = indices[1];
         if (infected(i, j) > 0)
@@ -55,5 +65,175 @@ double area_of_infected(
     return cells * ew_res * ns_res;
 }
 
+/**
+ * Statistics computed by StatisticsCalculator.
+ *
+ * Metrics for which the input was not provided are zero (or empty).
+ */
+struct Statistics
+{
+    /** Number of infected hosts */
+    std::uint64_t infected{0};
+    /** Number of cells with infected hosts */
+    std::uint64_t infected_cells{0};
+    /** Area of cells with infected hosts (map units) */
+    double infected_area{0};
+    /** Number of exposed hosts in all exposed cohorts */
+    std::uint64_t exposed{0};
+    /** Number of susceptible hosts */
+    std::uint64_t susceptible{0};
+    /** Number of cells infected now, but not in the previous infected raster */
+    std::uint64_t newly_infected_cells{0};
+    /** Number of cells with infected hosts in each quarantine area (by id) */
+    std::map<int, std::uint64_t> infected_cells_in_areas;
+};
+
+/**
+ * Computes multiple statistics in one pass over suitable cells.
+ *
+ * Only the infected raster is required. Other inputs are set using the setter
+ * functions and metrics are computed only for the inputs which were set.
+ * The rasters are referenced, not copied, so they need to exist until
+ * compute() is called.
+ *
+ * The cells are split into chunks processed in separate threads, the partial
+ * results are merged in order, so the result does not depend on number
+ * of threads. All counts use 64-bit accumulators.
+ */
+template<typename IntegerRaster>
+class StatisticsCalculator
+{
+public:
+    StatisticsCalculator(
+        const IntegerRaster& infected,
+        const std::vector<std::vector<int>>& suitable_cells)
+        : infected_(infected), suitable_cells_(suitable_cells)
+    {}
+
+    StatisticsCalculator& susceptible(const IntegerRaster& susceptible)
+    {
+        susceptible_ = &susceptible;
+        return *this;
+    }
+
+    StatisticsCalculator& exposed(const std::vector<IntegerRaster>& exposed)
+    {
+        exposed_ = &exposed;
+        return *this;
+    }
+
+    /**
+     * Exposed hosts stored as ExposedCohorts
+     *
+     * The cohorts are visited with ExposedCohorts::for_each() in compute(),
+     * so the hosts exposed in the current step are stored in the youngest
+     * cohort. Only cells in the cohorts are visited, not the suitable cells.
+     */
+    StatisticsCalculator& exposed(ExposedCohorts& exposed)
+    {
+        exposed_cohorts_ = &exposed;
+        return *this;
+    }
+
+    /** Infected raster from a previous step used for newly infected cells */
+    StatisticsCalculator& previous_infected(const IntegerRaster& previous_infected)
+    {
+        previous_infected_ = &previous_infected;
+        return *this;
+    }
+
+    /** Raster with quarantine area ids (0 for no area) */
+    StatisticsCalculator& quarantine_areas(const IntegerRaster& quarantine_areas)
+    {
+        quarantine_areas_ = &quarantine_areas;
+        return *this;
+    }
+
+    StatisticsCalculator& num_threads(unsigned num_threads)
+    {
+        num_threads_ = num_threads;
+        return *this;
+    }
+
+    /**
+     * Computes the statistics, *ew_res* and *ns_res* are used for the area.
+     */
+    Statistics compute(double ew_res, double ns_res) const
+    {
+        // Partial results by beginning of the chunk, merged in order.
+        std::map<std::size_t, Statistics> partial;
+        std::mutex mutex;
+        parallel_for_chunks(
+            suitable_cells_.size(),
+            num_threads_,
+            [&](std::size_t begin, std::size_t end) {
+                Statistics chunk;
+                compute_range(begin, end, chunk);
+                std::lock_guard<std::mutex> lock(mutex);
+                partial[begin] = std::move(chunk);
+            });
+        Statistics result;
+        for (const auto& chunk : partial) {
+            const auto& item = chunk.second;
+            result.infected += item.infected;
+            result.infected_cells += item.infected_cells;
+            result.exposed += item.exposed;
+            result.susceptible += item.susceptible;
+            result.newly_infected_cells += item.newly_infected_cells;
+            for (const auto& area : item.infected_cells_in_areas)
+                result.infected_cells_in_areas[area.first] += area.second;
+        }
+        if (exposed_cohorts_)
+            exposed_cohorts_->for_each([&result](int, int, int& count) {
+                result.exposed += count;
+            });
+        result.infected_area = result.infected_cells * ew_res * ns_res;
+        return result;
+    }
+
+private:
+    const IntegerRaster& infected_;
+    const std::vector<std::vector<int>>& suitable_cells_;
+    const IntegerRaster* susceptible_{nullptr};
+    const std::vector<IntegerRaster>* exposed_{nullptr};
+    ExposedCohorts* exposed_cohorts_{nullptr};
+    const IntegerRaster* previous_infected_{nullptr};
+    const IntegerRaster* quarantine_areas_{nullptr};
+    unsigned num_threads_{1};
+
+    void compute_range(std::size_t begin, std::size_t end, Statistics& result) const
+    {
+        // Neighboring cells are often in the same area, so the last area is cached.
+        int last_area = 0;
+        std::uint64_t* last_area_count = nullptr;
+        for (std::size_t index = begin; index < end; ++index) {
+            int i = suitable_cells_[index][0];
+            int j = suitable_cells_[index][1];
+            auto infected = infected_(i, j);
+            if (infected > 0) {
+                result.infected += infected;
+                ++result.infected_cells;
+                if (previous_infected_ && !((*previous_infected_)(i, j) > 0))
+                    ++result.newly_infected_cells;
+                if (quarantine_areas_) {
+                    int area = (*quarantine_areas_)(i, j);
+                    if (area) {
+                        if (!last_area_count || area != last_area) {
+                            last_area = area;
+                            last_area_count = &result.infected_cells_in_areas[area];
+                        }
+                        ++(*last_area_count);
+                    }
+                }
+            }
+            if (susceptible_)
+                result.susceptible += (*susceptible_)(i, j);
+            if (exposed_)
+                for (const auto& exposed : *exposed_)
+                    result.exposed += exposed(i, j);
+        }
+    }
+};
+
 }  // namespace pops
 #endif  // POPS_STATISTICS_HPP
@@ -22,6 +22,9 @@
 #include "neighbor_kernel.hpp"
 #include "kernel_types.hpp"
 
+#include <tuple>
+#include <vector>
+
 namespace pops {
 
 /*! Dispersal kernel providing all the radial kernels.
@@ -83,6 +86,28 @@ public:
         }
     }
 
+    /*! \copydoc RadialDispersalKernel::sample()
+     *
+     * The kernel is selected once for all the dispersers.
+     */
+    template<typename Generator>
+    void sample(
+        Generator& generator,
+        int row,
+        int col,
+        int count,
+        std::vector<std::tuple<int, int>>& targets)
+    {
+        if (dispersal_kernel_type_ == DispersalKernelType::Uniform)
+            uniform_kernel_.sample(generator, row, col, count, targets);
+        else if (dispersal_kernel_type_ == DispersalKernelType::DeterministicNeighbor)
+            deterministic_neighbor_kernel_.sample(generator, row, col, count, targets);
+        else if (deterministic_)
+            deterministic_kernel_.sample(generator, row, col, count, targets);
+        else
+            radial_kernel_.sample(generator, row, col, count, targets);
+    }
+
     /*! \copydoc RadialDispersalKernel::supports_kernel()
      */
     static bool supports_kernel(const DispersalKernelType type)
@@ -0,0 +1,351 @@
+/*
+ * PoPS model - raster stored in cache-friendly tiles
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_TILED_RASTER_HPP
+#define POPS_TILED_RASTER_HPP
+
+#include "raster.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pops {
+
+/**
+ * Interleaves bits of row and column (Z-order or Morton code).
+ *
+ * Cells (or tiles) close to each other in both directions have close codes.
+ */
+inline std::uint64_t morton_code(std::uint32_t row, std::uint32_t col)
+{
+    std::uint64_t code = 0;
+    for (unsigned bit = 0; bit < 32; ++bit) {
+        code |= std::uint64_t((col >> bit) & 1u) << (2 * bit);
+        code |= std::uint64_t((row >> bit) & 1u) << (2 * bit + 1);
+    }
+    return code;
+}
+
+/** Number of bits needed for index within a tile */
+constexpr unsigned tile_bits(unsigned tile_size)
+{
+    return tile_size > 1 ? 1 + tile_bits(tile_size / 2) : 0;
+}
+
+/**
+ * Raster with values stored in square tiles.
+ *
+ * The raster is split into tiles of *TileSize* by *TileSize* cells.
+ * Values in one tile are stored together (row by row) and the tiles are
+ * stored in Morton order (see morton_code()), so tiles next to each other
+ * in any direction are mostly close in memory. With row-major storage,
+ * cells a few rows apart are far apart in memory when the raster has many
+ * columns, so writes of dispersers to cells around a source hit a different
+ * memory page for each row. With tiles, the cells around a source are
+ * in a few tiles which stay in the cache.
+ *
+ * The class provides the same access by row and column as Raster
+ * and can be used as the raster type of Simulation. Combine it with cells
+ * ordered by tile_ordered_cells() to also visit sources tile by tile.
+ *
+ * The values are not stored in row-major order, so there is no data()
+ * function. Use the constructor from Raster and to_raster() to convert
+ * from and to the row-major layout.
+ *
+ * Tiles at the bottom and right edges are stored whole. The cells outside
+ * of the raster in these tiles are never used.
+ */
+template<typename Number, typename Index = int, unsigned TileSize = 64>
+class TiledRaster
+{
+    static_assert(
+        TileSize && !(TileSize & (TileSize - 1)), "TileSize must be a power of two");
+
+public:
+    typedef Number NumberType;
+    typedef Index IndexType;
+
+    static const unsigned tile_size = TileSize;
+
+    TiledRaster() : rows_(0), cols_(0), tile_rows_(0), tile_cols_(0) {}
+
+    /** Creates raster with all values set to zero */
+    TiledRaster(Index rows, Index cols) : TiledRaster(rows, cols, 0) {}
+
+    /** Creates raster with all values set to *value* */
+    TiledRaster(Index rows, Index cols, Number value)
+        : rows_(rows),
+          cols_(cols),
+          tile_rows_((rows + TileSize - 1) / TileSize),
+          tile_cols_((cols + TileSize - 1) / TileSize)
+    {
+        if (rows < 0 || cols < 0)
+            throw std::invalid_argument("TiledRaster: Size cannot be negative");
+        std::vector<std::pair<std::uint64_t, std::size_t>> tiles;
+        tiles.reserve(std::size_t(tile_rows_) * tile_cols_);
+        for (Index i = 0; i < tile_rows_; ++i)
+            for (Index j = 0; j < tile_cols_; ++j)
+                tiles.emplace_back(morton_code(i, j), tiles.size());
+        std::sort(tiles.begin(), tiles.end());
+        tile_offsets_.resize(tiles.size());
+        for (std::size_t rank = 0; rank < tiles.size(); ++rank)
+            tile_offsets_[tiles[rank].second] = rank * TileSize * TileSize;
+        values_.assign(tiles.size() * TileSize * TileSize, value);
+    }
+
+    /** Copies values from a row-major raster */
+    template<typename OtherNumber>
+    explicit TiledRaster(const Raster<OtherNumber, Index>& raster)
+        : TiledRaster(raster.rows(), raster.cols())
+    {
+        for (Index i = 0; i < rows_; ++i)
+            for (Index j = 0; j < cols_; ++j)
+                (*this)(i, j) = raster(i, j);
+    }
+
+    /** Copies values to a row-major raster */
+    Raster<Number, Index> to_raster() const
+    {
+        Raster<Number, Index> raster(rows_, cols_);
+        for (Index i = 0; i < rows_; ++i)
+            for (Index j = 0; j < cols_; ++j)
+                raster(i, j) = (*this)(i, j);
+        return raster;
+    }
+
+    Index rows() const
+    {
+        return rows_;
+    }
+
+    Index cols() const
+    {
+        return cols_;
+    }
+
+    const Number& operator()(Index row, Index col) const
+    {
+        return values_[offset(row, col)];
+    }
+
+    Number& operator()(Index row, Index col)
+    {
+        return values_[offset(row, col)];
+    }
+
+    void fill(Number value)
+    {
+        std::fill(values_.begin(), values_.end(), value);
+    }
+
+    void zero()
+    {
+        fill(0);
+    }
+
+    /** Applies *op* to each value in storage order (tile by tile) */
+    template<class UnaryOperation>
+    void for_each(UnaryOperation op)
+    {
+        for_each_cell([this, &op](Index row, Index col) { op((*this)(row, col)); });
+    }
+
+    /** Calls *function* with row and column of each cell in storage order */
+    template<class CellFunction>
+    void for_each_cell(CellFunction function) const
+    {
+        std::vector<std::pair<std::size_t, std::size_t>> tiles;
+        tiles.reserve(tile_offsets_.size());
+        for (std::size_t tile = 0; tile < tile_offsets_.size(); ++tile)
+            tiles.emplace_back(tile_offsets_[tile], tile);
+        std::sort(tiles.begin(), tiles.end());
+        for (const auto& tile : tiles) {
+            Index first_row = Index(tile.second / tile_cols_) * TileSize;
+            Index first_col = Index(tile.second % tile_cols_) * TileSize;
+            Index last_row = std::min<Index>(first_row + TileSize, rows_);
+            Index last_col = std::min<Index>(first_col + TileSize, cols_);
+            for (Index i = first_row; i < last_row; ++i)
+                for (Index j = first_col; j < last_col; ++j)
+                    function(i, j);
+        }
+    }
+
+    template<typename OtherNumber>
+    typename std::enable_if<std::is_arithmetic<OtherNumber>::value, TiledRaster&>::type
+    operator+=(OtherNumber value)
+    {
+        for (auto& a : values_)
+            a += value;
+        return *this;
+    }
+
+    template<typename OtherNumber>
+    typename std::enable_if<std::is_arithmetic<OtherNumber>::value, TiledRaster&>::type
+    operator-=(OtherNumber value)
+    {
+        for (auto& a : values_)
+            a -= value;
+        return *this;
+    }
+
+    template<typename OtherNumber>
+    typename std::enable_if<std::is_arithmetic<OtherNumber>::value, TiledRaster&>::type
+    operator*=(OtherNumber value)
+    {
+        for (auto& a : values_)
+            a *= value;
+        return *this;
+    }
+
+    template<typename OtherNumber>
+    typename std::enable_if<std::is_arithmetic<OtherNumber>::value, TiledRaster&>::type
+    operator/=(OtherNumber value)
+    {
+        for (auto& a : values_)
+            a /= value;
+        return *this;
+    }
+
+    TiledRaster& operator+=(const TiledRaster& other)
+    {
+        check_size(other);
+        for (std::size_t i = 0; i < values_.size(); ++i)
+            values_[i] += other.values_[i];
+        return *this;
+    }
+
+    TiledRaster& operator-=(const TiledRaster& other)
+    {
+        check_size(other);
+        for (std::size_t i = 0; i < values_.size(); ++i)
+            values_[i] -= other.values_[i];
+        return *this;
+    }
+
+    TiledRaster& operator*=(const TiledRaster& other)
+    {
+        check_size(other);
+        for (std::size_t i = 0; i < values_.size(); ++i)
+            values_[i] *= other.values_[i];
+        return *this;
+    }
+
+    TiledRaster& operator/=(const TiledRaster& other)
+    {
+        check_size(other);
+        // Padding cells may contain zeros, so only cells of the raster are used.
+        for_each_cell([this, &other](Index i, Index j) {
+            (*this)(i, j) /= other(i, j);
+        });
+        return *this;
+    }
+
+    /** Compares values of the cells in the raster */
+    bool operator==(const TiledRaster& other) const
+    {
+        if (rows_ != other.rows_ || cols_ != other.cols_)
+            return false;
+        for (Index i = 0; i < rows_; ++i)
+            for (Index j = 0; j < cols_; ++j)
+                if ((*this)(i, j) != other(i, j))
+                    return false;
+        return true;
+    }
+
+    bool operator!=(const TiledRaster& other) const
+    {
+        return !(*this == other);
+    }
+
+    friend inline std::ostream&
+    operator<<(std::ostream& stream, const TiledRaster& image)
+    {
+        return stream << image.to_raster();
+    }
+
+private:
+    static const unsigned bits_ = tile_bits(TileSize);
+    static const Index mask_ = TileSize - 1;
+
+    Index rows_;
+    Index cols_;
+    Index tile_rows_;
+    Index tile_cols_;
+    // first value of each tile, tiles indexed row by row
+    std::vector<std::size_t> tile_offsets_;
+    std::vector<Number> values_;
+
+    std::size_t offset(Index row, Index col) const
+    {
+        return tile_offsets_[std::size_t(row >> bits_) * tile_cols_ + (col >> bits_)]
+               + (std::size_t(row & mask_) << bits_) + (col & mask_);
+    }
+
+    void check_size(const TiledRaster& other) const
+    {
+        if (rows_ != other.rows_ || cols_ != other.cols_)
+            throw std::invalid_argument(
+                "TiledRaster: Raster sizes do not match (" + std::to_string(rows_)
+                + "x" + std::to_string(cols_) + " and " + std::to_string(other.rows_)
+                + "x" + std::to_string(other.cols_) + ")");
+    }
+};
+
+/**
+ * Returns the cells ordered tile by tile in the storage order of TiledRaster
+ * with the same tile size.
+ *
+ * Each cell is a vector with row and column (as suitable cells used by
+ * Simulation). Cells in one tile are ordered row by row. Going through
+ * the cells in this order keeps the cells around the current one
+ * in the cache for any raster type.
+ *
+ * Note that the order of cells determines which random numbers are used
+ * for which cell, so stochastic results with the reordered cells differ
+ * from results with the original order.
+ */
+template<unsigned TileSize = 64>
+std::vector<std::vector<int>>
+tile_ordered_cells(const std::vector<std::vector<int>>& cells)
+{
+    static_assert(
+        TileSize && !(TileSize & (TileSize - 1)), "TileSize must be a power of two");
+    const unsigned bits = tile_bits(TileSize);
+    const std::uint32_t mask = TileSize - 1;
+    std::vector<std::pair<std::uint64_t, std::size_t>> keys;
+    keys.reserve(cells.size());
+    for (std::size_t i = 0; i < cells.size(); ++i) {
+        std::uint32_t row = cells[i][0];
+        std::uint32_t col = cells[i][1];
+        std::uint64_t tile = morton_code(row >> bits, col >> bits);
+        std::uint64_t in_tile = ((row & mask) << bits) | (col & mask);
+        keys.emplace_back((tile << (2 * bits)) | in_tile, i);
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<std::vector<int>> ordered;
+    ordered.reserve(cells.size());
+    for (const auto& key : keys)
+        ordered.push_back(cells[key.second]);
+    return ordered;
+}
+
+}  // namespace pops
+
+#endif  // POPS_TILED_RASTER_HPP
@@ -0,0 +1,332 @@
+/*
+ * PoPS model - delta-encoded time series of rasters
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * The code contained herein is licensed under the GNU General Public
+ * License. You may obtain a copy of the GNU General Public License
+ * Version 2 or later at the following locations:
+ *
+ * http://www.opensource.org/licenses/gpl-license.html
+ * http://www.gnu.org/copyleft/gpl.html
+ */
+
+#ifndef POPS_TIME_SERIES_HPP
+#define POPS_TIME_SERIES_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace pops {
+
+/*
+ * The stream contains a header, frames, an index of frames, and a trailer.
+ * All numbers are in native byte order.
+ *
+ * header: magic (8 bytes), rows, cols, size of value in bytes (uint32 each)
+ * keyframe: kind 0 (uint8), number of values (uint64), all values
+ * delta frame: kind 1 (uint8), number of changed cells (uint64),
+ *     cell indices (uint32 each), new values of the cells
+ * index: offset of the frame (uint64) and kind (uint64) for each frame
+ * trailer: number of frames, offset of the index (uint64 each), end magic
+ */
+
+namespace time_series {
+
+const char header_magic[] = "PoPSDTS1";
+const char trailer_magic[] = "PoPSDTSE";
+const std::uint8_t keyframe = 0;
+const std::uint8_t delta_frame = 1;
+
+template<typename T>
+inline void write_value(std::ostream& stream, const T& value)
+{
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+inline void write_values(std::ostream& stream, const std::vector<T>& values)
+{
+    stream.write(
+        reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template<typename T>
+inline void read_value(std::istream& stream, T& value)
+{
+    stream.read(reinterpret_cast<char*>(&value), sizeof(T));
+    if (!stream)
+        throw std::runtime_error("Time series: Unexpected end of stream");
+}
+
+template<typename T>
+inline void read_values(std::istream& stream, T* values, std::size_t count)
+{
+    stream.read(reinterpret_cast<char*>(values), count * sizeof(T));
+    if (!stream)
+        throw std::runtime_error("Time series: Unexpected end of stream");
+}
+
+}  // namespace time_series
+
+/**
+ * Writes a time series of rasters (e.g., infected hosts in output steps)
+ * as a keyframe followed by changes from the previous raster.
+ *
+ * Only indices and new values of changed cells are stored for most
+ * of the rasters. A full raster (keyframe) is stored for the first raster,
+ * after every *keyframe_interval* rasters to limit the work needed
+ * for random access, and whenever storing the changes would take more
+ * space than the full raster.
+ *
+ * The index of the frames is written by finish() which must be called
+ * before the stream is read by DeltaTimeSeriesReader. The stream needs
+ * to report its position, e.g., a file or string stream.
+ */
+template<typename IntegerRaster>
+class DeltaTimeSeriesWriter
+{
+public:
+    typedef typename IntegerRaster::NumberType Value;
+
+    DeltaTimeSeriesWriter(
+        std::ostream& stream, int rows, int cols, unsigned keyframe_interval = 16)
+        : stream_(stream),
+          rows_(rows),
+          cols_(cols),
+          keyframe_interval_(keyframe_interval),
+          previous_(std::size_t(rows) * cols)
+    {
+        if (!keyframe_interval)
+            throw std::invalid_argument(
+                "DeltaTimeSeriesWriter: Keyframe interval must be at least one");
+        if (previous_.size() > UINT32_MAX)
+            throw std::invalid_argument(
+                "DeltaTimeSeriesWriter: Raster has too many cells for 32-bit indices");
+        stream_.write(time_series::header_magic, 8);
+        time_series::write_value(stream_, std::uint32_t(rows_));
+        time_series::write_value(stream_, std::uint32_t(cols_));
+        time_series::write_value(stream_, std::uint32_t(sizeof(Value)));
+    }
+
+    /** Appends a raster as the next frame of the series */
+    void append(const IntegerRaster& raster)
+    {
+        if (finished_)
+            throw std::logic_error(
+                "DeltaTimeSeriesWriter: Writer was already finished");
+        if (raster.rows() != rows_ || raster.cols() != cols_)
+            throw std::invalid_argument(
+                "DeltaTimeSeriesWriter: Raster size differs from the series");
+        const Value* data = raster.data();
+        std::size_t size = previous_.size();
+        std::uint64_t offset = stream_.tellp();
+        bool keyframe =
+            index_.empty() || frames_since_keyframe_ + 1 >= keyframe_interval_;
+        if (!keyframe) {
+            changed_indices_.clear();
+            changed_values_.clear();
+            // Stop collecting changes once they are larger than the full raster.
+            std::size_t limit = size * sizeof(Value) / (sizeof(Value) + 4);
+            for (std::size_t i = 0; i < size; ++i) {
+                if (data[i] != previous_[i]) {
+                    changed_indices_.push_back(std::uint32_t(i));
+                    changed_values_.push_back(data[i]);
+                    if (changed_indices_.size() > limit)
+                        break;
+                }
+            }
+            keyframe = changed_indices_.size() > limit;
+        }
+        if (keyframe) {
+            time_series::write_value(stream_, time_series::keyframe);
+            time_series::write_value(stream_, std::uint64_t(size));
+            stream_.write(reinterpret_cast<const char*>(data), size * sizeof(Value));
+            frames_since_keyframe_ = 0;
+        }
+        else {
+            time_series::write_value(stream_, time_series::delta_frame);
+            time_series::write_value(stream_, std::uint64_t(changed_indices_.size()));
+            time_series::write_values(stream_, changed_indices_);
+            time_series::write_values(stream_, changed_values_);
+            ++frames_since_keyframe_;
+        }
+        if (!stream_)
+            throw std::runtime_error("DeltaTimeSeriesWriter: Cannot write frame");
+        index_.push_back(offset);
+        index_.push_back(keyframe ? time_series::keyframe : time_series::delta_frame);
+        std::copy(data, data + size, previous_.begin());
+    }
+
+    /** Writes the index of frames, no frames can be added after that */
+    void finish()
+    {
+        if (finished_)
+            return;
+        std::uint64_t index_offset = stream_.tellp();
+        time_series::write_values(stream_, index_);
+        time_series::write_value(stream_, std::uint64_t(size()));
+        time_series::write_value(stream_, index_offset);
+        stream_.write(time_series::trailer_magic, 8);
+        stream_.flush();
+        if (!stream_)
+            throw std::runtime_error("DeltaTimeSeriesWriter: Cannot write index");
+        finished_ = true;
+    }
+
+    /** Number of frames */
+    unsigned size() const
+    {
+        return index_.size() / 2;
+    }
+
+private:
+    std::ostream& stream_;
+    int rows_;
+    int cols_;
+    unsigned keyframe_interval_;
+    unsigned frames_since_keyframe_{0};
+    bool finished_{false};
+    std::vector<Value> previous_;
+    std::vector<std::uint32_t> changed_indices_;
+    std::vector<Value> changed_values_;
+    // offset and kind for each frame
+    std::vector<std::uint64_t> index_;
+};
+
+/**
+ * Reads rasters from a time series written by DeltaTimeSeriesWriter.
+ *
+ * Any frame can be read. The frame is reconstructed from the nearest
+ * preceding keyframe, or from the previously read frame when reading
+ * forward, so reading the frames in order touches each stored value once.
+ */
+template<typename IntegerRaster>
+class DeltaTimeSeriesReader
+{
+public:
+    typedef typename IntegerRaster::NumberType Value;
+
+    DeltaTimeSeriesReader(std::istream& stream) : stream_(stream)
+    {
+        char magic[8];
+        time_series::read_values(stream_, magic, 8);
+        if (std::memcmp(magic, time_series::header_magic, 8) != 0)
+            throw std::runtime_error("DeltaTimeSeriesReader: Not a time series");
+        std::uint32_t rows, cols, value_size;
+        time_series::read_value(stream_, rows);
+        time_series::read_value(stream_, cols);
+        time_series::read_value(stream_, value_size);
+        if (value_size != sizeof(Value))
+            throw std::runtime_error(
+                "DeltaTimeSeriesReader: Size of values does not match the raster");
+        rows_ = rows;
+        cols_ = cols;
+        stream_.seekg(-24, std::ios::end);
+        std::uint64_t num_frames, index_offset;
+        time_series::read_value(stream_, num_frames);
+        time_series::read_value(stream_, index_offset);
+        time_series::read_values(stream_, magic, 8);
+        if (std::memcmp(magic, time_series::trailer_magic, 8) != 0)
+            throw std::runtime_error(
+                "DeltaTimeSeriesReader: Time series is incomplete (no index)");
+        index_.resize(2 * num_frames);
+        stream_.seekg(index_offset);
+        time_series::read_values(stream_, index_.data(), index_.size());
+        current_.resize(std::size_t(rows_) * cols_);
+    }
+
+    int rows() const
+    {
+        return rows_;
+    }
+
+    int cols() const
+    {
+        return cols_;
+    }
+
+    /** Number of frames */
+    unsigned size() const
+    {
+        return index_.size() / 2;
+    }
+
+    /** Reconstructs frame with the given index */
+    IntegerRaster read(unsigned frame)
+    {
+        IntegerRaster raster(rows_, cols_);
+        read(frame, raster);
+        return raster;
+    }
+
+    /** Reconstructs frame with the given index into an existing raster */
+    void read(unsigned frame, IntegerRaster& raster)
+    {
+        if (frame >= size())
+            throw std::out_of_range("DeltaTimeSeriesReader: No such frame");
+        if (raster.rows() != rows_ || raster.cols() != cols_)
+            throw std::invalid_argument(
+                "DeltaTimeSeriesReader: Raster size differs from the series");
+        // The current frame is invalid if reading fails.
+        bool continue_current = has_current_;
+        has_current_ = false;
+        unsigned start = frame;
+        while (index_[2 * start + 1] != time_series::keyframe)
+            --start;
+        // Continue from the current frame if there is no keyframe in between.
+        if (continue_current && current_frame_ >= start && current_frame_ <= frame)
+            start = current_frame_ + 1;
+        for (unsigned i = start; i <= frame; ++i)
+            apply_frame(i);
+        current_frame_ = frame;
+        has_current_ = true;
+        std::copy(current_.begin(), current_.end(), raster.data());
+    }
+
+private:
+    std::istream& stream_;
+    int rows_{0};
+    int cols_{0};
+    std::vector<std::uint64_t> index_;
+    std::vector<Value> current_;
+    unsigned current_frame_{0};
+    bool has_current_{false};
+    std::vector<std::uint32_t> indices_;
+    std::vector<Value> values_;
+
+    void apply_frame(unsigned frame)
+    {
+        stream_.seekg(index_[2 * frame]);
+        std::uint8_t kind;
+        std::uint64_t count;
+        time_series::read_value(stream_, kind);
+        time_series::read_value(stream_, count);
+        if (kind == time_series::keyframe) {
+            if (count != current_.size())
+                throw std::runtime_error("DeltaTimeSeriesReader: Corrupted keyframe");
+            time_series::read_values(stream_, current_.data(), count);
+            return;
+        }
+        indices_.resize(count);
+        values_.resize(count);
+        time_series::read_values(stream_, indices_.data(), count);
+        time_series::read_values(stream_, values_.data(), count);
+        for (std::size_t i = 0; i < count; ++i) {
+            if (indices_[i] >= current_.size())
+                throw std::runtime_error("DeltaTimeSeriesReader: Corrupted frame");
+            current_[indices_[i]] = values_[i];
+        }
+    }
+};
+
+}  // namespace pops
+
+#endif  // POPS_TIME_SERIES_HPP
@@ -19,13 +19,21 @@
 
 #include "raster.hpp"
 #include "date.hpp"
+#include "exposed_cohorts.hpp"
 #include "scheduling.hpp"
+#include "spread_rate.hpp"
+#include "utils.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
 #include <functional>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
 namespace pops {
 
@@ -88,6 +96,12 @@ public:
         IntegerRaster& susceptible,
         IntegerRaster& resistant,
         const std::vector<std::vector<int>>& spatial_indeices) = 0;
+    virtual void apply_treatment(
+        IntegerRaster& infected,
+        ExposedCohorts& exposed,
+        IntegerRaster& susceptible,
+        IntegerRaster& resistant,
+        const std::vector<std::vector<int>>& spatial_indeices) = 0;
     virtual void end_treatment(
         IntegerRaster& susceptible,
         IntegerRaster& resistant,
@@ -95,32 +109,81 @@ public:
     virtual void apply_treatment_mortality(
         IntegerRaster& infected,
         const std::vector<std::vector<int>>& spatial_indeices) = 0;
+    virtual void
+    update_infection_extent(const IntegerRaster& infected, InfectionExtent& extent) = 0;
     virtual ~AbstractTreatment() {}
 };
 
 /*!
  * Base treatment class.
  * Holds functions common between all treatment classes.
+ *
+ * The treatment map is stored as a sparse list of treated cells, i.e.,
+ * cells with non-zero value in the map, together with their efficacy
+ * (the map value), so the memory scales with the treated area rather than
+ * with the size of the map.
+ *
+ * Application of the treatment goes through *suitable_cells* and looks up
+ * the efficacy in the treated cells (which are ordered by row and column),
+ * so only suitable cells are treated and the rasters are accessed only
+ * in the treated ones.
+ *
+ * Exposed hosts stored as ExposedCohorts are treated by going through
+ * the exposed cells and looking up their efficacy in the treated cells
+ * (which are ordered by row and column).
  */
 template<typename IntegerRaster, typename FloatRaster>
 class BaseTreatment : public AbstractTreatment<IntegerRaster, FloatRaster>
 {
 protected:
+    /** Type of the efficacy values (the same as in the treatment map) */
+    typedef typename std::decay<decltype(std::declval<const FloatRaster&>()(0, 0))>::type
+        Efficacy;
+
+    /** Treated cell with its efficacy */
+    struct TreatedCell
+    {
+        int row;
+        int col;
+        Efficacy efficacy;
+    };
+
     unsigned start_step_;
     unsigned end_step_;
-    FloatRaster map_;
+    std::vector<TreatedCell> cells_;
     TreatmentApplication application_;
 
+    /** Returns the treated cell at *row* and *col* or null if not treated */
+    const TreatedCell* find_cell(int row, int col) const
+    {
+        // The cells are created row by row, so they are ordered.
+        auto found = std::lower_bound(
+            cells_.begin(),
+            cells_.end(),
+            std::make_pair(row, col),
+            [](const TreatedCell& cell, const std::pair<int, int>& position) {
+                return std::make_pair(cell.row, cell.col) < position;
+            });
+        if (found == cells_.end() || found->row != row || found->col != col)
+            return nullptr;
+        return &*found;
+    }
+
 public:
     BaseTreatment(
         const FloatRaster& map,
         unsigned start,
         TreatmentApplication treatment_application)
-        : start_step_(start),
-          end_step_(start),
-          map_(map),
-          application_(treatment_application)
-    {}
+        : start_step_(start), end_step_(start), application_(treatment_application)
+    {
+        for (int i = 0; i < map.rows(); ++i) {
+            for (int j = 0; j < map.cols(); ++j) {
+                if (map(i, j) != 0)
+                    cells_.push_back({i, j, map(i, j)});
+            }
+        }
+        cells_.shrink_to_fit();
+    }
     unsigned get_start() override
     {
         return start_step_;
@@ -133,17 +196,27 @@ public:
         IntegerRaster& infected,
         const std::vector<std::vector<int>>& suitable_cells) override
     {
-        for (auto indices : suitable_cells) {
+        for (const auto& indices : suitable_cells) {
             int i = indices[0];
             int j = indices[1];
+            const auto* cell = find_cell(i, j);
+            if (!cell)
+                continue;
             if (application_ == TreatmentApplication::Ratio) {
-                infected(i, j) = infected(i, j) - (infected(i, j) * map_(i, j));
+                infected(i, j) = infected(i, j) - (infected(i, j) * cell->efficacy);
             }
             else if (application_ == TreatmentApplication::AllInfectedInCell) {
-                infected(i, j) = map_(i, j) ? 0 : infected(i, j);
+                infected(i, j) = 0;
             }
         }
     }
+    /** Reports infected hosts in the treated cells to the infection extent */
+    void update_infection_extent(
+        const IntegerRaster& infected, InfectionExtent& extent) override
+    {
+        for (const auto& cell : cells_)
+            extent.update(cell.row, cell.col, infected(cell.row, cell.col));
+    }
 };
 
 /*!
@@ -178,28 +251,52 @@ public:
         IntegerRaster&,
         const std::vector<std::vector<int>>& suitable_cells) override
     {
-        for (auto indices : suitable_cells) {
+        for (const auto& indices : suitable_cells) {
             int i = indices[0];
             int j = indices[1];
+            const auto* cell = this->find_cell(i, j);
+            if (!cell)
+                continue;
             if (this->application_ == TreatmentApplication::Ratio) {
-                infected(i, j) = infected(i, j) - (infected(i, j) * this->map_(i, j));
+                infected(i, j) = infected(i, j) - (infected(i, j) * cell->efficacy);
             }
             else if (this->application_ == TreatmentApplication::AllInfectedInCell) {
-                infected(i, j) = this->map_(i, j) ? 0 : infected(i, j);
+                infected(i, j) = 0;
             }
             for (auto& raster : exposed) {
                 if (this->application_ == TreatmentApplication::Ratio) {
-                    raster(i, j) = raster(i, j) - (raster(i, j) * this->map_(i, j));
+                    raster(i, j) = raster(i, j) - (raster(i, j) * cell->efficacy);
                 }
                 else if (
                     this->application_ == TreatmentApplication::AllInfectedInCell) {
-                    raster(i, j) = this->map_(i, j) ? 0 : raster(i, j);
+                    raster(i, j) = 0;
                 }
             }
             susceptible(i, j) =
-                susceptible(i, j) - (susceptible(i, j) * this->map_(i, j));
+                susceptible(i, j) - (susceptible(i, j) * cell->efficacy);
         }
     }
+    void apply_treatment(
+        IntegerRaster& infected,
+        ExposedCohorts& exposed,
+        IntegerRaster& susceptible,
+        IntegerRaster& resistant,
+        const std::vector<std::vector<int>>& suitable_cells) override
+    {
+        std::vector<IntegerRaster> no_exposed;
+        apply_treatment(infected, no_exposed, susceptible, resistant, suitable_cells);
+        exposed.for_each([this](int row, int col, int& count) {
+            const auto* cell = this->find_cell(row, col);
+            if (!cell)
+                return;
+            if (this->application_ == TreatmentApplication::Ratio) {
+                count = count - (count * cell->efficacy);
+            }
+            else if (this->application_ == TreatmentApplication::AllInfectedInCell) {
+                count = 0;
+            }
+        });
+    }
     void end_treatment(
         IntegerRaster&, IntegerRaster&, const std::vector<std::vector<int>>&) override
     {
@@ -246,28 +343,31 @@ public:
         IntegerRaster& resistant,
         const std::vector<std::vector<int>>& suitable_cells) override
     {
-        for (auto indices : suitable_cells) {
+        for (const auto& indices : suitable_cells) {
             int i = indices[0];
             int j = indices[1];
+            const auto* cell = this->find_cell(i, j);
+            if (!cell)
+                continue;
             int infected_resistant = 0;
             int exposed_resistant_sum = 0;
-            int susceptible_resistant = susceptible(i, j) * this->map_(i, j);
+            int susceptible_resistant = susceptible(i, j) * cell->efficacy;
             int current_resistant = resistant(i, j);
             if (this->application_ == TreatmentApplication::Ratio) {
-                infected_resistant = infected(i, j) * this->map_(i, j);
+                infected_resistant = infected(i, j) * cell->efficacy;
             }
             else if (this->application_ == TreatmentApplication::AllInfectedInCell) {
-                infected_resistant = this->map_(i, j) ? infected(i, j) : 0;
+                infected_resistant = infected(i, j);
             }
             infected(i, j) -= infected_resistant;
             for (auto& exposed : exposed_vector) {
                 int exposed_resistant = 0;
                 if (this->application_ == TreatmentApplication::Ratio) {
-                    exposed_resistant = exposed(i, j) * this->map_(i, j);
+                    exposed_resistant = exposed(i, j) * cell->efficacy;
                 }
                 else if (
                     this->application_ == TreatmentApplication::AllInfectedInCell) {
-                    exposed_resistant = this->map_(i, j) ? exposed(i, j) : 0;
+                    exposed_resistant = exposed(i, j);
                 }
                 exposed(i, j) -= exposed_resistant;
                 exposed_resistant_sum += exposed_resistant;
@@ -277,15 +377,43 @@ public:
             susceptible(i, j) -= susceptible_resistant;
         }
     }
+    void apply_treatment(
+        IntegerRaster& infected,
+        ExposedCohorts& exposed,
+        IntegerRaster& susceptible,
+        IntegerRaster& resistant,
+        const std::vector<std::vector<int>>& suitable_cells) override
+    {
+        std::vector<IntegerRaster> no_exposed;
+        apply_treatment(infected, no_exposed, susceptible, resistant, suitable_cells);
+        // Resistant exposed hosts are added to the already updated resistant.
+        exposed.for_each([this, &resistant](int row, int col, int& count) {
+            const auto* cell = this->find_cell(row, col);
+            if (!cell)
+                return;
+            int exposed_resistant = 0;
+            if (this->application_ == TreatmentApplication::Ratio) {
+                exposed_resistant = count * cell->efficacy;
+            }
+            else if (this->application_ == TreatmentApplication::AllInfectedInCell) {
+                exposed_resistant = count;
+            }
+            count -= exposed_resistant;
+            resistant(row, col) += exposed_resistant;
+        });
+    }
     void end_treatment(
         IntegerRaster& susceptible,
         IntegerRaster& resistant,
         const std::vector<std::vector<int>>& suitable_cells) override
     {
-        for (auto indices : suitable_cells) {
+        for (const auto& indices : suitable_cells) {
             int i = indices[0];
             int j = indices[1];
-            if (this->map_(i, j) > 0) {
+            const auto* cell = this->find_cell(i, j);
+            if (!cell)
+                continue;
+            if (cell->efficacy > 0) {
                 susceptible(i, j) += resistant(i, j);
                 resistant(i, j) = 0;
             }
@@ -309,17 +437,32 @@ template<typename IntegerRaster, typename FloatRaster>
 class Treatments
 {
 private:
-    std::vector<AbstractTreatment<IntegerRaster, FloatRaster>*> treatments;
+    typedef AbstractTreatment<IntegerRaster, FloatRaster> Treatment;
+
+    /** Start or end of a treatment (index to the list of treatments) */
+    struct TreatmentEvent
+    {
+        std::size_t treatment;
+        bool start;
+    };
+
+    std::vector<std::unique_ptr<Treatment>> treatments;
+    // Events for each step which has any, in order in which treatments were added.
+    std::map<unsigned, std::vector<TreatmentEvent>> events_;
     Scheduler scheduler_;
 
-public:
-    Treatments(const Scheduler& scheduler) : scheduler_(scheduler) {}
-    ~Treatments()
+    void add_events(std::size_t index)
     {
-        for (auto item : treatments) {
-            delete item;
-        }
+        unsigned start = treatments[index]->get_start();
+        unsigned end = treatments[index]->get_end();
+        events_[start].push_back({index, true});
+        // Start takes precedence when a treatment starts and ends in one step.
+        if (end != start)
+            events_[end].push_back({index, false});
     }
+
+public:
+    Treatments(const Scheduler& scheduler) : scheduler_(scheduler) {}
     /*!
      * \brief Add treatment, based on parameters it is distinguished
      * which treatment it will be.
@@ -341,16 +484,20 @@ public:
         TreatmentApplication treatment_application)
     {
         unsigned start = scheduler_.schedule_action_date(start_date);
+        // Owned before it is added, so it is not leaked if adding throws.
+        std::unique_ptr<Treatment> treatment;
         if (num_days == 0)
-            treatments.push_back(new SimpleTreatment<IntegerRaster, FloatRaster>(
+            treatment.reset(new SimpleTreatment<IntegerRaster, FloatRaster>(
                 map, start, treatment_application));
         else {
             Date end_date(start_date);
             end_date.add_days(num_days);
             unsigned end = scheduler_.schedule_action_date(end_date);
-            treatments.push_back(new PesticideTreatment<IntegerRaster, FloatRaster>(
+            treatment.reset(new PesticideTreatment<IntegerRaster, FloatRaster>(
                 map, start, end, treatment_application));
         }
+        treatments.push_back(std::move(treatment));
+        add_events(treatments.size() - 1);
     }
     /*!
      * \brief Do management if needed.
@@ -358,33 +505,44 @@ public:
      * Decides internally whether any treatment needs to be
      * activated/deactivated.
      *
+     * Only treatments starting or ending in the current step are visited.
+     *
+     * The exposed hosts are a vector of rasters (one for each cohort)
+     * or ExposedCohorts.
+     *
      * \param current simulation step
      * \param infected raster of infected host
      * \param susceptible raster of susceptible host
      * \param resistant raster of resistant host
+     * \param infection_extent extent of infected hosts to update
+     * in the treated cells (optional)
      * \return true if any management action was necessary
      */
+    template<typename Exposed>
     bool manage(
         unsigned current,
         IntegerRaster& infected,
-        std::vector<IntegerRaster>& exposed,
+        Exposed& exposed,
         IntegerRaster& susceptible,
         IntegerRaster& resistant,
-        const std::vector<std::vector<int>>& suitable_cells)
+        const std::vector<std::vector<int>>& suitable_cells,
+        InfectionExtent* infection_extent = nullptr)
     {
-        bool changed = false;
-        for (unsigned i = 0; i < treatments.size(); i++) {
-            if (treatments[i]->should_start(current)) {
-                treatments[i]->apply_treatment(
+        auto events = events_.find(current);
+        if (events == events_.end())
+            return false;
+        for (const auto& event : events->second) {
+            auto& treatment = treatments[event.treatment];
+            if (event.start) {
+                treatment->apply_treatment(
                     infected, exposed, susceptible, resistant, suitable_cells);
-                changed = true;
-            }
-            else if (treatments[i]->should_end(current)) {
-                treatments[i]->end_treatment(susceptible, resistant, suitable_cells);
-                changed = true;
+                if (infection_extent)
+                    treatment->update_infection_extent(infected, *infection_extent);
             }
+            else
+                treatment->end_treatment(susceptible, resistant, suitable_cells);
         }
-        return changed;
+        return true;
     }
     /*!
      * \brief Separately manage mortality infected cohorts
@@ -397,12 +555,17 @@ public:
         IntegerRaster& infected,
         const std::vector<std::vector<int>>& suitable_cells)
     {
+        auto events = events_.find(current);
+        if (events == events_.end())
+            return false;
         bool applied = false;
-        for (unsigned i = 0; i < treatments.size(); i++)
-            if (treatments[i]->should_start(current)) {
-                treatments[i]->apply_treatment_mortality(infected, suitable_cells);
+        for (const auto& event : events->second) {
+            if (event.start) {
+                treatments[event.treatment]->apply_treatment_mortality(
+                    infected, suitable_cells);
                 applied = true;
             }
+        }
         return applied;
     }
     /*!
@@ -412,15 +575,17 @@ public:
      */
     void clear_after_step(unsigned step)
     {
-        for (auto& treatment : treatments) {
-            if (treatment->get_start() > step) {
-                delete treatment;
-                treatment = nullptr;
-            }
-        }
         treatments.erase(
-            std::remove(treatments.begin(), treatments.end(), nullptr),
+            std::remove_if(
+                treatments.begin(),
+                treatments.end(),
+                [step](const std::unique_ptr<Treatment>& treatment) {
+                    return treatment->get_start() > step;
+                }),
             treatments.end());
+        events_.clear();
+        for (std::size_t i = 0; i < treatments.size(); ++i)
+            add_events(i);
     }
 };
 
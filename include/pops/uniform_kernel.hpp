@@ -19,6 +19,8 @@
 #include "kernel_types.hpp"
 
 #include <random>
+#include <tuple>
+#include <vector>
 
 namespace pops {
 
@@ -62,6 +64,21 @@ public:
         return std::make_tuple(row, col);
     }
 
+    /*! \copydoc RadialDispersalKernel::sample()
+     */
+    template<typename Generator>
+    void sample(
+        Generator& generator,
+        int row,
+        int col,
+        int count,
+        std::vector<std::tuple<int, int>>& targets)
+    {
+        targets.resize(count);
+        for (auto& target : targets)
+            target = (*this)(generator, row, col);
+    }
+
     /*! \copydoc RadialDispersalKernel::supports_kernel()
      */
     static bool supports_kernel(const DispersalKernelType type)
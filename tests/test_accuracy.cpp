@@ -0,0 +1,178 @@
+#ifdef POPS_TEST
+
+/*
+ * Tests for the PoPS accuracy metrics and distance transform.
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * This file is part of PoPS.
+
+ * PoPS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+
+ * PoPS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <pops/accuracy.hpp>
+#include <pops/distance_transform.hpp>
+#include <pops/raster.hpp>
+
+using namespace pops;
+
+int test_accuracy_metrics()
+{
+    int err = 0;
+    Raster<int> simulated = {{0, 2, 0, 0}, {1, 3, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 5}};
+    Raster<int> observed = {{0, 1, 1, 0}, {0, 3, 0, 0}, {0, 0, 2, 0}, {0, 0, 0, 0}};
+    std::vector<std::vector<int>> suitable_cells;
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            suitable_cells.push_back({i, j});
+
+    AccuracyMetrics metrics = accuracy_metrics(simulated, observed, suitable_cells);
+    AccuracyMetrics all_cells = accuracy_metrics(simulated, observed);
+    for (const auto& item : {metrics, all_cells}) {
+        if (item.true_positives != 2 || item.false_positives != 2
+            || item.false_negatives != 2 || item.true_negatives != 10
+            || item.sum_of_squared_differences != 1 + 1 + 1 + 4 + 25) {
+            std::cout << "accuracy_metrics: confusion matrix fails: "
+                      << item.true_positives << " " << item.false_positives << " "
+                      << item.false_negatives << " " << item.true_negatives
+                      << std::endl;
+            err++;
+        }
+    }
+    if (metrics.quantity_disagreement() != 0
+        || metrics.allocation_disagreement() != 0.25
+        || metrics.total_disagreement() != 0.25) {
+        std::cout << "accuracy_metrics: disagreement fails" << std::endl;
+        err++;
+    }
+    // (2 * 10 - 2 * 2) / sqrt(4 * 4 * 12 * 12) = 16 / 48
+    if (std::abs(metrics.mcc() - 1. / 3) > 1e-12) {
+        std::cout << "accuracy_metrics: MCC fails: " << metrics.mcc() << std::endl;
+        err++;
+    }
+    if (std::abs(metrics.rmse() - std::sqrt(32. / 16)) > 1e-12) {
+        std::cout << "accuracy_metrics: RMSE fails: " << metrics.rmse() << std::endl;
+        err++;
+    }
+    Raster<int> empty(4, 4);
+    empty.zero();
+    if (accuracy_metrics(empty, observed).mcc() != 0) {
+        std::cout << "accuracy_metrics: MCC without infection fails" << std::endl;
+        err++;
+    }
+    return err;
+}
+
+int test_nearest_feature_cells()
+{
+    int err = 0;
+    int rows = 23;
+    int cols = 17;
+    double row_spacing = 30;
+    double col_spacing = 20;
+    std::default_random_engine generator(7);
+    std::bernoulli_distribution distribution(0.05);
+    std::vector<bool> features(rows * cols);
+    for (int i = 0; i < rows * cols; ++i)
+        features[i] = distribution(generator);
+    auto nearest = nearest_feature_cells(
+        rows, cols, row_spacing, col_spacing, [&features, cols](int i, int j) {
+            return bool(features[i * cols + j]);
+        });
+    auto distance = [&](int i, int j, int feature) {
+        double dy = (feature / cols - i) * row_spacing;
+        double dx = (feature % cols - j) * col_spacing;
+        return std::sqrt(dx * dx + dy * dy);
+    };
+    // Compare with brute force search.
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            double expected = std::numeric_limits<double>::infinity();
+            for (int k = 0; k < rows * cols; ++k)
+                if (features[k])
+                    expected = std::min(expected, distance(i, j, k));
+            int feature = nearest[i * cols + j];
+            if (feature < 0 || !features[feature]
+                || std::abs(distance(i, j, feature) - expected) > 1e-9) {
+                std::cout << "nearest_feature_cells fails for cell " << i << ", " << j
+                          << std::endl;
+                err++;
+            }
+        }
+    }
+    auto none = nearest_feature_cells(2, 3, 1, 1, [](int, int) { return false; });
+    for (auto feature : none) {
+        if (feature != -1) {
+            std::cout << "nearest_feature_cells without features fails" << std::endl;
+            err++;
+            break;
+        }
+    }
+    return err;
+}
+
+int test_distance_to_nearest_infection()
+{
+    int err = 0;
+    Raster<int> simulated = {{1, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 1}};
+    Raster<int> observed = {{0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 1, 0}};
+    std::vector<std::vector<int>> suitable_cells;
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            suitable_cells.push_back({i, j});
+    double to_observed =
+        mean_distance_to_nearest_infection(simulated, observed, 10, 20, suitable_cells);
+    double expected = (std::sqrt(20. * 20 + 60. * 60) + 10) / 2;
+    if (std::abs(to_observed - expected) > 1e-9) {
+        std::cout << "distance to nearest infection fails: " << to_observed << " "
+                  << expected << std::endl;
+        err++;
+    }
+    double to_simulated =
+        mean_distance_to_nearest_infection(observed, simulated, 10, 20, suitable_cells);
+    if (to_simulated != 10) {
+        std::cout << "distance to nearest infection fails: " << to_simulated
+                  << std::endl;
+        err++;
+    }
+    Raster<int> empty(4, 4);
+    empty.zero();
+    double to_empty =
+        mean_distance_to_nearest_infection(simulated, empty, 10, 20, suitable_cells);
+    if (!std::isnan(to_empty)) {
+        std::cout << "distance to nearest infection without infection fails"
+                  << std::endl;
+        err++;
+    }
+    return err;
+}
+
+int main()
+{
+    int num_errors = 0;
+
+    num_errors += test_accuracy_metrics();
+    num_errors += test_nearest_feature_cells();
+    num_errors += test_distance_to_nearest_infection();
+    std::cout << "Accuracy number of errors: " << num_errors << std::endl;
+    return num_errors;
+}
+
+#endif  // POPS_TEST
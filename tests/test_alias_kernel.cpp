@@ -0,0 +1,331 @@
+#ifdef POPS_TEST
+
+/*
+ * Tests for the PoPS alias table dispersal kernel.
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * This file is part of PoPS.
+
+ * PoPS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+
+ * PoPS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include <pops/alias_kernel.hpp>
+#include <pops/radial_kernel.hpp>
+#include <pops/raster.hpp>
+
+using namespace pops;
+
+std::vector<DispersalKernelType> supported_types()
+{
+    return {
+        DispersalKernelType::Cauchy,
+        DispersalKernelType::Exponential,
+        DispersalKernelType::Weibull,
+        DispersalKernelType::Normal,
+        DispersalKernelType::LogNormal,
+        DispersalKernelType::PowerLaw,
+        DispersalKernelType::HyperbolicSecant};
+}
+
+double shape_for(DispersalKernelType type)
+{
+    return type == DispersalKernelType::PowerLaw ? 3 : 1.5;
+}
+
+int test_quantile()
+{
+    int err = 0;
+    std::default_random_engine generator(42);
+    for (auto type : supported_types()) {
+        double shape = shape_for(type);
+        double scale = type == DispersalKernelType::LogNormal ? 1 : 50;
+        RadialDistanceQuantile quantile(type, scale, shape);
+        // Distances of the radial kernel are measured using a kernel with
+        // fine resolution going north (rounding makes the check approximate).
+        double resolution = 0.001;
+        RadialDispersalKernel<Raster<int>> radial(
+            resolution, resolution, type, scale, Direction::N, 1e6, shape);
+        for (double p : {0.5, 0.9}) {
+            double distance = quantile(p);
+            int below = 0;
+            const int count = 20000;
+            for (int i = 0; i < count; ++i) {
+                auto target = radial(generator, 0, 0);
+                if (-std::get<0>(target) * resolution <= distance)
+                    ++below;
+            }
+            double fraction = double(below) / count;
+            if (std::abs(fraction - p) > 0.02) {
+                std::cout << "quantile: type " << static_cast<int>(type)
+                          << ", distance " << distance << " has " << fraction
+                          << " of dispersers instead of " << p << "\n";
+                ++err;
+            }
+        }
+        if (quantile(0) != 0) {
+            std::cout << "quantile: non-zero distance for zero probability\n";
+            ++err;
+        }
+    }
+    return err;
+}
+
+int test_table()
+{
+    int err = 0;
+    for (auto type : supported_types()) {
+        double scale = type == DispersalKernelType::LogNormal ? 1 : 50;
+        auto table = dispersal_alias_table(
+            type, 0.95, 30, 20, scale, Direction::E, 2, shape_for(type));
+        double total = table->tail_probability;
+        for (double probability : table->probabilities)
+            total += probability;
+        if (std::abs(total - 1) > 1e-9) {
+            std::cout << "table: total probability is " << total << "\n";
+            ++err;
+        }
+        if (std::abs(table->tail_probability - 0.05) > 1e-12) {
+            std::cout << "table: tail probability is " << table->tail_probability
+                      << "\n";
+            ++err;
+        }
+        // Probabilities represented by the alias table (tail is the last item).
+        std::size_t size = table->keep.size();
+        if (size != table->offsets.size() + 1 || size != table->alias.size()) {
+            std::cout << "table: inconsistent sizes\n";
+            ++err;
+            continue;
+        }
+        std::vector<double> represented(size, 0);
+        for (std::size_t i = 0; i < size; ++i) {
+            represented[i] += table->keep[i] / size;
+            represented[table->alias[i]] += (1 - table->keep[i]) / size;
+        }
+        for (std::size_t i = 0; i < size; ++i) {
+            double expected =
+                i + 1 < size ? table->probabilities[i] : table->tail_probability;
+            if (std::abs(represented[i] - expected) > 1e-9) {
+                std::cout << "table: item " << i << " has probability "
+                          << represented[i] << " instead of " << expected << "\n";
+                ++err;
+                break;
+            }
+        }
+        for (const auto& offset : table->offsets) {
+            if (std::abs(std::get<0>(offset)) * 20 > table->max_distance + 10
+                || std::abs(std::get<1>(offset)) * 30 > table->max_distance + 15) {
+                std::cout << "table: offset outside of the window\n";
+                ++err;
+                break;
+            }
+        }
+    }
+    try {
+        dispersal_alias_table(DispersalKernelType::Uniform, 0.9, 30, 30, 50);
+        std::cout << "table: no exception for unsupported kernel\n";
+        ++err;
+    }
+    catch (const std::invalid_argument&) {
+    }
+    try {
+        dispersal_alias_table(DispersalKernelType::Cauchy, 1, 30, 30, 50);
+        std::cout << "table: no exception for dispersal percentage 1\n";
+        ++err;
+    }
+    catch (const std::invalid_argument&) {
+    }
+    try {
+        dispersal_alias_table(DispersalKernelType::LogNormal, 0.99, 30, 30, 50);
+        std::cout << "table: no exception for too large window\n";
+        ++err;
+    }
+    catch (const std::invalid_argument&) {
+    }
+    return err;
+}
+
+/**
+ * Compares frequencies of target cells from the alias kernel and
+ * the radial kernel using total variation distance.
+ *
+ * Targets further than the checked area are counted at its edge,
+ * so that the rarely visited cells in the tail do not dominate the distance.
+ */
+int test_same_as_radial()
+{
+    int err = 0;
+    std::default_random_engine generator(7);
+    for (auto type :
+         {DispersalKernelType::Cauchy,
+          DispersalKernelType::Exponential,
+          DispersalKernelType::PowerLaw,
+          DispersalKernelType::Normal}) {
+        double shape = shape_for(type);
+        double scale = type == DispersalKernelType::PowerLaw ? 20 : 40;
+        for (auto direction : {Direction::None, Direction::SW}) {
+            RadialDispersalKernel<Raster<int>> radial(
+                30, 20, type, scale, direction, 2, shape);
+            AliasDispersalKernel alias(30, 20, type, scale, 0.9, direction, 2, shape);
+            std::map<std::tuple<int, int>, int> counts;
+            const int count = 200000;
+            auto clamp = [](std::tuple<int, int> target) {
+                const int edge = 20;
+                return std::make_tuple(
+                    std::max(-edge, std::min(edge, std::get<0>(target))),
+                    std::max(-edge, std::min(edge, std::get<1>(target))));
+            };
+            for (int i = 0; i < count; ++i) {
+                ++counts[clamp(radial(generator, 0, 0))];
+                --counts[clamp(alias(generator, 0, 0))];
+            }
+            double distance = 0;
+            for (const auto& item : counts)
+                distance += std::abs(item.second);
+            distance /= 2 * count;
+            if (distance > 0.035) {
+                std::cout << "same_as_radial: type " << static_cast<int>(type)
+                          << ", direction " << static_cast<int>(direction)
+                          << ", total variation distance " << distance << "\n";
+                ++err;
+            }
+        }
+    }
+    return err;
+}
+
+int test_sample()
+{
+    int err = 0;
+    AliasDispersalKernel kernel(
+        30, 30, DispersalKernelType::Cauchy, 20, 0.9, Direction::N, 1);
+    std::default_random_engine single_generator(42);
+    std::default_random_engine batch_generator(42);
+    std::vector<std::tuple<int, int>> targets;
+    kernel.sample(batch_generator, 10, 20, 100, targets);
+    if (targets.size() != 100) {
+        std::cout << "sample: wrong number of targets\n";
+        return 1;
+    }
+    for (const auto& target : targets) {
+        if (target != kernel(single_generator, 10, 20)) {
+            std::cout << "sample: target differs from single sampling\n";
+            return 1;
+        }
+    }
+    // Kernels with a shared table give the same results.
+    auto table = dispersal_alias_table(
+        DispersalKernelType::Cauchy, 0.9, 30, 30, 20, Direction::N, 1);
+    AliasDispersalKernel shared(
+        30, 30, DispersalKernelType::Cauchy, 20, Direction::N, 1, 1, table);
+    std::default_random_engine generator(43);
+    std::default_random_engine shared_generator(43);
+    kernel.sample(generator, 10, 20, 100, targets);
+    for (const auto& target : targets) {
+        if (target != shared(shared_generator, 10, 20)) {
+            std::cout << "sample: kernel with shared table differs\n";
+            return 1;
+        }
+    }
+    if (!AliasDispersalKernel::supports_kernel(DispersalKernelType::Weibull)
+        || AliasDispersalKernel::supports_kernel(DispersalKernelType::Gamma)
+        || AliasDispersalKernel::supports_kernel(DispersalKernelType::Uniform)) {
+        std::cout << "sample: wrong supported kernels\n";
+        ++err;
+    }
+    return err;
+}
+
+int test_sample_counts()
+{
+    int err = 0;
+    std::default_random_engine generator(42);
+    AliasDispersalKernel kernel(
+        30, 30, DispersalKernelType::Exponential, 60, 0.95, Direction::S, 1);
+    const auto& table = kernel.table();
+    std::vector<std::tuple<int, int, int>> targets;
+    // Few dispersers are sampled one by one.
+    kernel.sample_counts(generator, 5, 6, 10, targets);
+    if (targets.size() != 10) {
+        std::cout << "sample_counts: " << targets.size() << " targets instead of 10\n";
+        ++err;
+    }
+    for (const auto& target : targets) {
+        if (std::get<2>(target) != 1) {
+            std::cout << "sample_counts: count other than one for few dispersers\n";
+            ++err;
+            break;
+        }
+    }
+    // Many dispersers are counted per cell.
+    const int count = 200000;
+    kernel.sample_counts(generator, 5, 6, count, targets);
+    int total = 0;
+    int in_window = 0;
+    int first = 0;
+    for (const auto& target : targets) {
+        total += std::get<2>(target);
+        if (std::get<2>(target) > 1)
+            in_window += std::get<2>(target);
+        if (std::get<0>(target) == 5 + std::get<0>(table.offsets[0])
+            && std::get<1>(target) == 6 + std::get<1>(table.offsets[0]))
+            first += std::get<2>(target);
+    }
+    if (total != count) {
+        std::cout << "sample_counts: " << total << " dispersers instead of " << count
+                  << "\n";
+        ++err;
+    }
+    if (targets.size() > table.offsets.size() + count / 10) {
+        std::cout << "sample_counts: too many targets (" << targets.size() << ")\n";
+        ++err;
+    }
+    // Counts of the most likely cell are binomial.
+    double mean = count * table.probabilities[0];
+    double deviation = std::sqrt(mean * (1 - table.probabilities[0]));
+    if (std::abs(first - mean) > 5 * deviation) {
+        std::cout << "sample_counts: " << first << " dispersers in the most likely cell"
+                  << " instead of about " << mean << "\n";
+        ++err;
+    }
+    if (in_window < 0.9 * count) {
+        std::cout << "sample_counts: only " << in_window << " dispersers counted\n";
+        ++err;
+    }
+    return err;
+}
+
+int main()
+{
+    int num_errors = 0;
+
+    num_errors += test_quantile();
+    num_errors += test_table();
+    num_errors += test_same_as_radial();
+    num_errors += test_sample();
+    num_errors += test_sample_counts();
+    std::cout << "Alias kernel number of errors: " << num_errors << std::endl;
+    return num_errors;
+}
+
+#endif  // POPS_TEST
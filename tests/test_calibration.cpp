@@ -0,0 +1,259 @@
+#ifdef POPS_TEST
+
+/*
+ * Tests for the PoPS ABC calibration.
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * This file is part of PoPS.
+
+ * PoPS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+
+ * PoPS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+#include <pops/calibration.hpp>
+#include <pops/raster.hpp>
+
+using namespace pops;
+
+typedef AbcCalibration<Raster<int>, Raster<double>, Raster<double>::IndexType>
+    TestCalibration;
+
+Config create_config(int rows, int cols)
+{
+    Config config;
+    config.random_seed = 42;
+    config.rows = rows;
+    config.cols = cols;
+    config.ew_res = 30;
+    config.ns_res = 30;
+    config.weather = false;
+    config.reproductive_rate = 2;
+    config.model_type = "SI";
+    config.latency_period_steps = 0;
+    config.natural_kernel_type = "cauchy";
+    config.natural_direction = "none";
+    config.natural_kappa = 0;
+    config.natural_scale = 20;
+    config.use_anthropogenic_kernel = false;
+    config.percent_natural_dispersal = 1;
+    config.anthro_kernel_type = "cauchy";
+    config.anthro_direction = "none";
+    config.anthro_kappa = 0;
+    config.anthro_scale = 20;
+    config.use_spreadrates = false;
+    config.use_quarantine = false;
+    config.set_date_start(2020, 1, 1);
+    config.set_date_end(2020, 12, 31);
+    config.set_step_unit(StepUnit::Month);
+    config.set_step_num_units(1);
+    config.create_schedules();
+    return config;
+}
+
+std::vector<std::vector<int>> all_cells(int rows, int cols)
+{
+    std::vector<std::vector<int>> cells;
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            cells.push_back({i, j});
+    return cells;
+}
+
+int test_early_rejection()
+{
+    int err = 0;
+    int size = 10;
+    Config config = create_config(size, size);
+    Raster<int> infected(size, size);
+    infected.zero();
+    infected(5, 5) = 5;
+    Raster<int> susceptible(size, size);
+    susceptible.fill(20);
+    Raster<int> total_hosts = infected + susceptible;
+    auto cells = all_cells(size, size);
+    std::vector<Raster<double>> no_rasters;
+    TestCalibration calibration(
+        config, infected, susceptible, total_hosts, no_rasters, no_rasters, cells);
+    // The initial state is observed, so spread increases the distance.
+    calibration.add_observation(2, infected);
+    calibration.add_observation(8, infected);
+
+    CalibrationParameters no_spread(config);
+    no_spread.reproductive_rate = 0;
+    CalibrationParameters spread = no_spread;
+    spread.reproductive_rate = 4;
+    auto results = calibration.run({no_spread, spread}, 0.01);
+    if (!results[0].accepted || results[0].distance != 0
+        || results[0].num_checkpoints != 2 || results[0].num_steps != 9) {
+        std::cout << "early_rejection: candidate without spread not accepted"
+                  << " (distance " << results[0].distance << ", steps "
+                  << results[0].num_steps << ")\n";
+        err++;
+    }
+    if (results[1].accepted || results[1].distance <= 0.01
+        || results[1].num_checkpoints != 1 || results[1].num_steps != 3) {
+        std::cout << "early_rejection: spreading candidate not rejected early"
+                  << " (distance " << results[1].distance << ", steps "
+                  << results[1].num_steps << ")\n";
+        err++;
+    }
+    if (results[1].parameters.reproductive_rate != 4) {
+        std::cout << "early_rejection: results not in order of candidates\n";
+        err++;
+    }
+    return err;
+}
+
+int test_independent_of_threads()
+{
+    int size = 10;
+    Config config = create_config(size, size);
+    Raster<int> infected(size, size);
+    infected.zero();
+    infected(4, 4) = 10;
+    infected(6, 7) = 3;
+    Raster<int> susceptible(size, size);
+    susceptible.fill(30);
+    Raster<int> total_hosts = infected + susceptible;
+    auto cells = all_cells(size, size);
+    std::vector<Raster<double>> no_rasters;
+    TestCalibration calibration(
+        config, infected, susceptible, total_hosts, no_rasters, no_rasters, cells);
+    calibration.add_observation(5, infected);
+    calibration.add_observation(11, infected);
+
+    CalibrationParameters low(config);
+    low.reproductive_rate = 0.1;
+    low.natural_scale = 5;
+    CalibrationParameters high = low;
+    high.reproductive_rate = 3;
+    high.natural_scale = 60;
+    auto candidates = sample_uniform_prior(low, high, 12, 7);
+    auto reference = calibration.run(candidates, 0.1, 1);
+    for (unsigned num_threads : {2, 5}) {
+        auto results = calibration.run(candidates, 0.1, num_threads);
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            if (results[i].accepted != reference[i].accepted
+                || results[i].distance != reference[i].distance
+                || results[i].num_steps != reference[i].num_steps) {
+                std::cout << "independent_of_threads: candidate " << i
+                          << " differs with " << num_threads << " threads\n";
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int test_shared_deterministic_windows()
+{
+    int err = 0;
+    int size = 7;
+    Config config = create_config(size, size);
+    config.deterministic = true;
+    config.generate_stochasticity = false;
+    config.establishment_stochasticity = false;
+    config.establishment_probability = 0.5;
+    Raster<int> infected(size, size);
+    infected.zero();
+    infected(3, 3) = 8;
+    Raster<int> susceptible(size, size);
+    susceptible.fill(10);
+    Raster<int> total_hosts = infected + susceptible;
+    auto cells = all_cells(size, size);
+    std::vector<Raster<double>> no_rasters;
+    TestCalibration calibration(
+        config, infected, susceptible, total_hosts, no_rasters, no_rasters, cells);
+    calibration.add_observation(3, infected);
+
+    // Two distinct natural scales (anthropogenic scale stays the same).
+    std::vector<CalibrationParameters> candidates(4, CalibrationParameters(config));
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        candidates[i].reproductive_rate = 1 + i;
+        candidates[i].natural_scale = i % 2 ? 20 : 40;
+    }
+    calibration.run(candidates, 1, 2);
+    if (calibration.window_cache().size() != 2) {
+        std::cout << "shared_deterministic_windows: expected 2 cached windows, got "
+                  << calibration.window_cache().size() << "\n";
+        err++;
+    }
+
+    // Models with and without the cache give the same result.
+    std::vector<Raster<int>> results;
+    DeterministicWindowCache cache;
+    for (bool use_cache : {false, true}) {
+        auto model_infected = infected;
+        auto model_susceptible = susceptible;
+        auto model_total_hosts = total_hosts;
+        Raster<int> dispersers(size, size);
+        Raster<int> zeros(size, size, 0);
+        std::vector<Raster<int>> exposed;
+        std::vector<Raster<int>> mortality_tracker(config.num_mortality_years(), zeros);
+        Raster<int> died(size, size, 0);
+        std::vector<std::tuple<int, int>> outside_dispersers;
+        Treatments<Raster<int>, Raster<double>> treatments(config.scheduler());
+        SpreadRate<Raster<int>> spread_rate(infected, 30, 30, 0, cells);
+        QuarantineEscape<Raster<int>> quarantine(zeros, 30, 30, 0, cells);
+        Raster<double> weather(size, size);
+        MovementTable<Raster<double>::IndexType> movements;
+        typedef Model<Raster<int>, Raster<double>, Raster<double>::IndexType> TestModel;
+        TestModel model = use_cache ? TestModel(config, cache) : TestModel(config);
+        for (int step = 0; step < 3; ++step) {
+            model.run_step(
+                step,
+                model_infected,
+                model_susceptible,
+                model_total_hosts,
+                dispersers,
+                exposed,
+                mortality_tracker,
+                died,
+                no_rasters,
+                weather,
+                treatments,
+                zeros,
+                outside_dispersers,
+                spread_rate,
+                quarantine,
+                zeros,
+                movements,
+                cells);
+        }
+        results.push_back(model_infected);
+    }
+    if (results[0] != results[1] || results[0] == infected) {
+        std::cout << "shared_deterministic_windows: model with cache differs:\n"
+                  << results[0] << results[1];
+        err++;
+    }
+    return err;
+}
+
+int main()
+{
+    int num_errors = 0;
+
+    num_errors += test_early_rejection();
+    num_errors += test_independent_of_threads();
+    num_errors += test_shared_deterministic_windows();
+    std::cout << "Calibration number of errors: " << num_errors << std::endl;
+    return num_errors;
+}
+
+#endif  // POPS_TEST
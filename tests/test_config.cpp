@@ -0,0 +1,176 @@
+#ifdef POPS_TEST
+
+/*
+ * Tests for the PoPS Config class.
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * This file is part of PoPS.
+
+ * PoPS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+
+ * PoPS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <pops/config.hpp>
+
+using namespace pops;
+
+Config create_config()
+{
+    Config config;
+    config.use_lethal_temperature = true;
+    config.lethal_temperature_month = 1;
+    config.use_spreadrates = true;
+    config.spreadrate_frequency = "year";
+    config.use_quarantine = false;
+    config.output_frequency = "month";
+    config.set_date_start(2020, 1, 1);
+    config.set_date_end(2022, 12, 31);
+    config.set_step_unit(StepUnit::Week);
+    config.set_step_num_units(1);
+    config.set_season_start_end_month(3, 10);
+    return config;
+}
+
+int test_schedules_not_created()
+{
+    Config config = create_config();
+    try {
+        config.spread_schedule();
+        std::cout << "schedules_not_created: use before creation not detected\n";
+        return 1;
+    }
+    catch (const std::logic_error&) {
+    }
+    return 0;
+}
+
+int test_shared_schedules()
+{
+    int err = 0;
+    ScheduleCache cache;
+    Config config = create_config();
+    config.create_schedules(cache);
+    // Same dates and frequencies, different model parameters
+    Config other = create_config();
+    other.reproductive_rate = 4.2;
+    other.natural_scale = 10;
+    other.create_schedules(cache);
+    if (&config.scheduler() != &other.scheduler()
+        || &config.spread_schedule() != &other.spread_schedule()) {
+        std::cout << "shared_schedules: schedules with the same inputs not shared\n";
+        err++;
+    }
+    Config copy = config;
+    if (&copy.output_schedule() != &config.output_schedule()) {
+        std::cout << "shared_schedules: copy does not share the schedules\n";
+        err++;
+    }
+    Config changed = create_config();
+    changed.set_season_start_end_month(4, 10);
+    changed.create_schedules(cache);
+    if (&changed.spread_schedule() == &config.spread_schedule()
+        || changed.spread_schedule() == config.spread_schedule()) {
+        std::cout << "shared_schedules: different season uses the same schedule\n";
+        err++;
+    }
+    if (cache.size() != 2) {
+        std::cout << "shared_schedules: expected 2 cached schedules, got "
+                  << cache.size() << "\n";
+        err++;
+    }
+    // The shared schedules are the same as the directly created ones.
+    Scheduler scheduler(Date(2020, 1, 1), Date(2022, 12, 31), StepUnit::Week, 1);
+    if (config.spread_schedule() != scheduler.schedule_spread(Season(3, 10))
+        || config.lethal_schedule() != scheduler.schedule_action_yearly(1, 1)
+        || config.spread_rate_schedule() != scheduler.schedule_action_end_of_year()
+        || config.output_schedule() != scheduler.schedule_action_monthly()
+        || config.scheduler().get_num_steps() != scheduler.get_num_steps()) {
+        std::cout << "shared_schedules: schedules differ from the scheduler\n";
+        err++;
+    }
+    for (unsigned step = 0; step < scheduler.get_num_steps(); ++step) {
+        if (config.mortality_action_step(step)
+                != simulation_step_to_action_step(config.mortality_schedule(), step)
+            || config.lethal_action_step(step)
+                   != simulation_step_to_action_step(config.lethal_schedule(), step)
+            || config.spread_rate_action_step(step)
+                   != simulation_step_to_action_step(
+                       config.spread_rate_schedule(), step)) {
+            std::cout << "shared_schedules: wrong action step for step " << step
+                      << "\n";
+            err++;
+            break;
+        }
+    }
+    return err;
+}
+
+int test_released_schedules()
+{
+    int err = 0;
+    ScheduleCache cache;
+    {
+        Config config = create_config();
+        config.create_schedules(cache);
+    }
+    // The schedules were released with the last configuration using them,
+    // so they are created again.
+    Config config = create_config();
+    config.create_schedules(cache);
+    if (cache.size() != 1 || config.scheduler().get_num_steps() == 0) {
+        std::cout << "released_schedules: schedules not created again\n";
+        err++;
+    }
+    // Released schedules with other key are removed when new ones are added.
+    {
+        Config other = create_config();
+        other.set_season_start_end_month(4, 10);
+        other.create_schedules(cache);
+    }
+    Config changed = create_config();
+    changed.set_season_start_end_month(5, 10);
+    changed.create_schedules(cache);
+    if (cache.size() != 2) {
+        std::cout << "released_schedules: expected 2 cached schedules, got "
+                  << cache.size() << "\n";
+        err++;
+    }
+    // Schedules are shared with the global cache by default.
+    Config global = create_config();
+    global.create_schedules();
+    Config global_copy = create_config();
+    global_copy.create_schedules();
+    if (&global.scheduler() != &global_copy.scheduler()) {
+        std::cout << "released_schedules: global cache not used\n";
+        err++;
+    }
+    return err;
+}
+
+int main()
+{
+    int num_errors = 0;
+
+    num_errors += test_schedules_not_created();
+    num_errors += test_shared_schedules();
+    num_errors += test_released_schedules();
+    std::cout << "Config number of errors: " << num_errors << std::endl;
+    return num_errors;
+}
+
+#endif  // POPS_TEST
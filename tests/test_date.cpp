@@ -173,6 +173,50 @@ int test_to_string()
     return num_errors;
 }
 
+int test_day_number()
+{
+    int num_errors = 0;
+    if (Date(1970, 1, 1).day_number() != 0 || Date(2000, 3, 1).day_number() != 11017
+        || Date(1969, 12, 31).day_number() != -1) {
+        num_errors++;
+        cout << "Wrong day number of a known date" << endl;
+    }
+    // Day numbers are consecutive and convert back to the same date.
+    Date d(1896, 1, 1);
+    int expected = d.day_number();
+    while (d < Date(2104, 12, 31)) {
+        d.add_day();
+        expected++;
+        if (d.day_number() != expected || Date::from_day_number(expected) != d) {
+            num_errors++;
+            cout << "Day number " << d.day_number() << " of " << d
+                 << " does not match " << expected << endl;
+            break;
+        }
+    }
+    return num_errors;
+}
+
+int test_weeks_from_date()
+{
+    int num_errors = 0;
+    Date start(2018, 1, 1);
+    Date d(start);
+    int weeks = 0;
+    // Compare with counting week by week over several years.
+    while (d < Date(2025, 1, 1)) {
+        if (d.weeks_from_date(start) != weeks) {
+            num_errors++;
+            cout << "Weeks from " << start << " to " << d << " is "
+                 << d.weeks_from_date(start) << ", not " << weeks << endl;
+            break;
+        }
+        d.increased_by_week();
+        weeks++;
+    }
+    return num_errors;
+}
+
 int main()
 {
     int num_errors = 0;
@@ -183,6 +227,8 @@ int main()
     num_errors += test_add_days();
     num_errors += test_subtract_days();
     num_errors += test_to_string();
+    num_errors += test_day_number();
+    num_errors += test_weeks_from_date();
     cout << "Test Date class: number of errors: " << num_errors << endl;
 
     return 0;
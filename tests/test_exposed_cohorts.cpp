@@ -0,0 +1,272 @@
+#ifdef POPS_TEST
+
+/*
+ * Tests for the PoPS sparse storage of exposed hosts.
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * This file is part of PoPS.
+
+ * PoPS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+
+ * PoPS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <pops/date.hpp>
+#include <pops/exposed_cohorts.hpp>
+#include <pops/kernel.hpp>
+#include <pops/raster.hpp>
+#include <pops/scheduling.hpp>
+#include <pops/simulation.hpp>
+#include <pops/treatments.hpp>
+
+using namespace pops;
+
+std::vector<std::vector<int>> all_cells(int rows, int cols)
+{
+    std::vector<std::vector<int>> cells;
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            cells.push_back({i, j});
+    return cells;
+}
+
+/** Sum of all exposed cohorts in each cell */
+Raster<int> exposed_sum(const std::vector<Raster<int>>& exposed, int rows, int cols)
+{
+    Raster<int> sum(rows, cols);
+    sum.zero();
+    for (const auto& cohort : exposed)
+        sum += cohort;
+    return sum;
+}
+
+Raster<int> exposed_sum(ExposedCohorts& exposed)
+{
+    Raster<int> sum(exposed.rows(), exposed.cols());
+    sum.zero();
+    exposed.for_each([&sum](int row, int col, int& count) { sum(row, col) += count; });
+    return sum;
+}
+
+/**
+ * Runs SEI simulation with the exposed hosts in rasters and in cohorts.
+ *
+ * The random numbers are used in the same way, so the results are the same.
+ * Optionally, treatments are applied in some of the steps.
+ */
+int run_sei_same_as_rasters(const std::string& name, bool with_treatments)
+{
+    int err = 0;
+    // Raster comparison assumes square rasters.
+    int rows = 16;
+    int cols = 16;
+    unsigned latency = 3;
+    Raster<int> infected(rows, cols);
+    infected.zero();
+    infected(3, 4) = 10;
+    infected(10, 12) = 5;
+    Raster<int> susceptible(rows, cols);
+    susceptible.fill(40);
+    Raster<int> total = infected + susceptible;
+    Raster<double> weather(rows, cols);
+    weather.fill(0.8);
+    Raster<int> zeros(rows, cols);
+    zeros.zero();
+    Raster<int> dispersers = zeros;
+    Raster<int> mortality = zeros;
+    Raster<int> resistant = zeros;
+    std::vector<Raster<int>> exposed(latency + 1, zeros);
+
+    Raster<int> cohorts_infected = infected;
+    Raster<int> cohorts_susceptible = susceptible;
+    Raster<int> cohorts_mortality = mortality;
+    Raster<int> cohorts_resistant = resistant;
+    ExposedCohorts cohorts(rows, cols, latency);
+
+    Scheduler scheduler(Date(2020, 1, 1), Date(2020, 12, 31), StepUnit::Month, 1);
+    Treatments<Raster<int>, Raster<double>> treatments(scheduler);
+    Raster<double> simple(rows, cols);
+    simple.zero();
+    Raster<double> pesticide = simple;
+    for (int i = 0; i < rows; ++i) {
+        simple(i, 5) = 0.5;
+        pesticide(i, 2) = 1;
+        pesticide(i, 11) = 0.3;
+    }
+    treatments.add_treatment(simple, Date(2020, 4, 1), 0, TreatmentApplication::Ratio);
+    treatments.add_treatment(
+        pesticide, Date(2020, 5, 1), 60, TreatmentApplication::AllInfectedInCell);
+
+    auto cells = all_cells(rows, cols);
+    Simulation<Raster<int>, Raster<double>> simulation(
+        5, rows, cols, ModelType::SusceptibleExposedInfected, latency);
+    Simulation<Raster<int>, Raster<double>> cohorts_simulation(
+        5, rows, cols, ModelType::SusceptibleExposedInfected, latency);
+    RadialDispersalKernel<Raster<int>> kernel(
+        10, 10, DispersalKernelType::Cauchy, 20, Direction::None, 0, 1);
+    std::vector<std::tuple<int, int>> outside;
+    std::vector<std::tuple<int, int>> cohorts_outside;
+    int max_resistant = 0;
+    for (unsigned step = 0; step < 10; ++step) {
+        if (with_treatments) {
+            treatments.manage(step, infected, exposed, susceptible, resistant, cells);
+            treatments.manage(
+                step,
+                cohorts_infected,
+                cohorts,
+                cohorts_susceptible,
+                cohorts_resistant,
+                cells);
+            max_resistant = std::max(max_resistant, resistant(5, 2));
+        }
+        simulation.generate(dispersers, infected, true, weather, 2, cells);
+        simulation.disperse_and_infect(
+            step,
+            dispersers,
+            susceptible,
+            exposed,
+            infected,
+            mortality,
+            total,
+            outside,
+            true,
+            weather,
+            kernel,
+            cells);
+        cohorts_simulation.generate(
+            dispersers, cohorts_infected, true, weather, 2, cells);
+        cohorts_simulation.disperse_and_infect(
+            step,
+            dispersers,
+            cohorts_susceptible,
+            cohorts,
+            cohorts_infected,
+            cohorts_mortality,
+            total,
+            cohorts_outside,
+            true,
+            weather,
+            kernel,
+            cells);
+        if (infected != cohorts_infected || susceptible != cohorts_susceptible
+            || mortality != cohorts_mortality || resistant != cohorts_resistant) {
+            std::cout << name << ": hosts differ in step " << step << "\n";
+            ++err;
+            break;
+        }
+        if (exposed_sum(exposed, rows, cols) != exposed_sum(cohorts)) {
+            std::cout << name << ": exposed hosts differ in step " << step << "\n";
+            ++err;
+            break;
+        }
+    }
+    int total_infected = 0;
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            total_infected += infected(i, j);
+    if (total_infected <= 15) {
+        std::cout << name << ": no hosts became infected\n";
+        ++err;
+    }
+    if (with_treatments && !max_resistant) {
+        std::cout << name << ": no resistant hosts\n";
+        ++err;
+    }
+    return err;
+}
+
+int test_same_as_rasters()
+{
+    return run_sei_same_as_rasters("same_as_rasters", false);
+}
+
+int test_treatments()
+{
+    return run_sei_same_as_rasters("treatments", true);
+}
+
+int test_cohorts()
+{
+    int err = 0;
+    ExposedCohorts cohorts(3, 4, 2);
+    if (cohorts.latency_period() != 2 || cohorts.rows() != 3 || cohorts.cols() != 4) {
+        std::cout << "cohorts: wrong size\n";
+        ++err;
+    }
+    // Cell read while it stays zero is not stored.
+    cohorts(0, 0);
+    cohorts(1, 2) += 3;
+    cohorts(2, 3) += 1;
+    cohorts(1, 2) += 1;
+    cohorts.store_youngest();
+    if (cohorts(1, 2) != 0) {
+        std::cout << "cohorts: youngest not empty after storing\n";
+        ++err;
+    }
+    cohorts.rotate();
+    cohorts.rotate();
+    const auto& oldest = cohorts.oldest();
+    if (oldest.size() != 2 || oldest[0].row != 1 || oldest[0].col != 2
+        || oldest[0].count != 4 || oldest[1].count != 1) {
+        std::cout << "cohorts: wrong cells in the oldest cohort\n";
+        ++err;
+    }
+    try {
+        cohorts.rotate();
+        std::cout << "cohorts: no exception for non-empty oldest cohort\n";
+        ++err;
+    }
+    catch (const std::logic_error&) {
+    }
+    // Zero latency infects hosts exposed in the same step.
+    Raster<int> infected(3, 4);
+    infected.zero();
+    Raster<int> mortality = infected;
+    ExposedCohorts no_latency(3, 4, 0);
+    Simulation<Raster<int>, Raster<double>> simulation(
+        1, 3, 4, ModelType::SusceptibleExposedInfected, 0);
+    no_latency(2, 1) += 2;
+    simulation.infect_exposed(0, no_latency, infected, mortality);
+    if (infected(2, 1) != 2 || mortality(2, 1) != 2) {
+        std::cout << "cohorts: hosts not infected with zero latency\n";
+        ++err;
+    }
+    try {
+        simulation.infect_exposed(1, cohorts, infected, mortality);
+        std::cout << "cohorts: no exception for different latency period\n";
+        ++err;
+    }
+    catch (const std::invalid_argument&) {
+    }
+    return err;
+}
+
+int main()
+{
+    int num_errors = 0;
+
+    num_errors += test_same_as_rasters();
+    num_errors += test_treatments();
+    num_errors += test_cohorts();
+    std::cout << "Exposed cohorts number of errors: " << num_errors << std::endl;
+    return num_errors;
+}
+
+#endif  // POPS_TEST
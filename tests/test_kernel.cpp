@@ -0,0 +1,205 @@
+#ifdef POPS_TEST
+
+/*
+ * Tests for the PoPS batched sampling of dispersal kernels.
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * This file is part of PoPS.
+
+ * PoPS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+
+ * PoPS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <pops/kernel.hpp>
+#include <pops/raster.hpp>
+
+using namespace pops;
+
+/**
+ * Checks that sample() gives the same targets as repeated calls
+ * of the function call operator with the same random numbers.
+ */
+template<typename Kernel>
+int check_same_as_single(
+    const std::string& name, Kernel single_kernel, Kernel batch_kernel, int count)
+{
+    std::default_random_engine single_generator(42);
+    std::default_random_engine batch_generator(42);
+    std::vector<std::tuple<int, int>> targets(3);  // existing items are replaced
+    // Two source cells to check also a change of the cell.
+    for (int source = 0; source < 2; ++source) {
+        int row = 10 + source;
+        int col = 20 - source;
+        batch_kernel.sample(batch_generator, row, col, count, targets);
+        if (targets.size() != std::size_t(count)) {
+            std::cout << name << ": " << targets.size() << " targets instead of "
+                      << count << "\n";
+            return 1;
+        }
+        for (int i = 0; i < count; ++i) {
+            auto expected = single_kernel(single_generator, row, col);
+            if (targets[i] != expected) {
+                std::cout << name << ": target " << i << " differs: "
+                          << std::get<0>(targets[i]) << ", " << std::get<1>(targets[i])
+                          << " instead of " << std::get<0>(expected) << ", "
+                          << std::get<1>(expected) << "\n";
+                return 1;
+            }
+        }
+    }
+    if (single_generator() != batch_generator()) {
+        std::cout << name << ": different number of random numbers used\n";
+        return 1;
+    }
+    return 0;
+}
+
+int test_radial()
+{
+    int err = 0;
+    for (auto type :
+         {DispersalKernelType::Cauchy,
+          DispersalKernelType::Exponential,
+          DispersalKernelType::Weibull,
+          DispersalKernelType::Normal,
+          DispersalKernelType::LogNormal,
+          DispersalKernelType::PowerLaw,
+          DispersalKernelType::HyperbolicSecant,
+          DispersalKernelType::Gamma}) {
+        double shape = type == DispersalKernelType::PowerLaw ? 3 : 1.5;
+        RadialDispersalKernel<Raster<int>> kernel(
+            30, 30, type, 50, Direction::NE, 2, shape);
+        err += check_same_as_single("radial", kernel, kernel, 100);
+    }
+    return err;
+}
+
+int test_other_kernels()
+{
+    int err = 0;
+    UniformDispersalKernel uniform(40, 50);
+    err += check_same_as_single("uniform", uniform, uniform, 50);
+    DeterministicNeighborDispersalKernel neighbor(Direction::SW);
+    err += check_same_as_single("neighbor", neighbor, neighbor, 7);
+
+    Raster<int> dispersers(30, 30);
+    dispersers.fill(12);
+    auto window = deterministic_probability_window(
+        DispersalKernelType::Cauchy, 0.99, 30, 30, 20);
+    DeterministicDispersalKernel<Raster<int>> deterministic(
+        DispersalKernelType::Cauchy, dispersers, window);
+    err += check_same_as_single("deterministic", deterministic, deterministic, 12);
+
+    RadialDispersalKernel<Raster<int>> radial(30, 30, DispersalKernelType::Cauchy, 20);
+    RadialDispersalKernel<Raster<int>> long_radial(
+        30, 30, DispersalKernelType::Exponential, 400);
+    SwitchDispersalKernel<Raster<int>> natural(
+        DispersalKernelType::Cauchy, radial, deterministic, uniform);
+    SwitchDispersalKernel<Raster<int>> anthropogenic(
+        DispersalKernelType::Exponential, long_radial, deterministic, uniform);
+    SwitchDispersalKernel<Raster<int>> switch_uniform(
+        DispersalKernelType::Uniform, radial, deterministic, uniform);
+    err += check_same_as_single("switch", natural, natural, 30);
+    err += check_same_as_single("switch_uniform", switch_uniform, switch_uniform, 30);
+    DispersalKernel<Raster<int>> natural_only(natural, anthropogenic, false, 0.9);
+    err += check_same_as_single("natural_only", natural_only, natural_only, 40);
+    return err;
+}
+
+/**
+ * Checks the split of dispersers between natural and anthropogenic kernels
+ * (natural going east, anthropogenic going west).
+ */
+int test_natural_anthropogenic_split()
+{
+    int err = 0;
+    std::default_random_engine generator(42);
+    DeterministicNeighborDispersalKernel east(Direction::E);
+    DeterministicNeighborDispersalKernel west(Direction::W);
+    NaturalAnthropogenicDispersalKernel<
+        DeterministicNeighborDispersalKernel,
+        DeterministicNeighborDispersalKernel>
+        kernel(east, west, true, 0.8);
+    std::vector<std::tuple<int, int>> targets(3);
+    int num_natural = 0;
+    int total = 0;
+    for (int count : {0, 1, 10, 1000, 5000}) {
+        kernel.sample(generator, 10, 20, count, targets);
+        if (targets.size() != std::size_t(count)) {
+            std::cout << "natural_anthropogenic_split: " << targets.size()
+                      << " targets instead of " << count << "\n";
+            return 1;
+        }
+        bool natural = true;
+        for (const auto& target : targets) {
+            if (target == std::make_tuple(10, 21)) {
+                if (!natural) {
+                    std::cout << "natural_anthropogenic_split: natural target after "
+                                 "anthropogenic one\n";
+                    return 1;
+                }
+                ++num_natural;
+            }
+            else if (target == std::make_tuple(10, 19)) {
+                natural = false;
+            }
+            else {
+                std::cout << "natural_anthropogenic_split: unexpected target\n";
+                return 1;
+            }
+        }
+        total += count;
+    }
+    double fraction = double(num_natural) / total;
+    if (std::abs(fraction - 0.8) > 0.02) {
+        std::cout << "natural_anthropogenic_split: " << fraction
+                  << " dispersers used natural kernel instead of 0.8\n";
+        ++err;
+    }
+    return err;
+}
+
+int test_empty_batch()
+{
+    std::default_random_engine generator(42);
+    RadialDispersalKernel<Raster<int>> kernel(30, 30, DispersalKernelType::Cauchy, 20);
+    std::vector<std::tuple<int, int>> targets(5);
+    kernel.sample(generator, 1, 1, 0, targets);
+    if (!targets.empty()) {
+        std::cout << "empty_batch: targets not cleared\n";
+        return 1;
+    }
+    return 0;
+}
+
+int main()
+{
+    int num_errors = 0;
+
+    num_errors += test_radial();
+    num_errors += test_other_kernels();
+    num_errors += test_natural_anthropogenic_split();
+    num_errors += test_empty_batch();
+    std::cout << "Kernel number of errors: " << num_errors << std::endl;
+    return num_errors;
+}
+
+#endif  // POPS_TEST
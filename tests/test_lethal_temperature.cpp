@@ -0,0 +1,258 @@
+#ifdef POPS_TEST
+
+/*
+ * Tests for the PoPS cells with lethal temperature.
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * This file is part of PoPS.
+
+ * PoPS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+
+ * PoPS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include <pops/config.hpp>
+#include <pops/lethal_temperature.hpp>
+#include <pops/model.hpp>
+#include <pops/raster.hpp>
+#include <pops/simulation.hpp>
+
+using namespace pops;
+
+int test_cells()
+{
+    int err = 0;
+    std::vector<Raster<double>> temperatures = {
+        {{-5, 2}, {-1, -8}}, {{3, 3}, {3, 3}}, {{-10, -10}, {-10, -10}}};
+    // Cell (1, 1) is not suitable.
+    std::vector<std::vector<int>> suitable_cells = {{0, 0}, {0, 1}, {1, 0}};
+    LethalTemperatureCells cells(temperatures, -2, suitable_cells);
+    if (cells.size() != 3 || cells.lethal_temperature() != -2) {
+        std::cout << "cells: wrong number of steps or lethal temperature\n";
+        return 1;
+    }
+    if (cells[0].size() != 1 || cells[0][0].row != 0 || cells[0][0].col != 0) {
+        std::cout << "cells: wrong cells in the first step\n";
+        ++err;
+    }
+    if (!cells[1].empty()) {
+        std::cout << "cells: cells in a step without lethal temperature\n";
+        ++err;
+    }
+    if (cells[2].size() != 3) {
+        std::cout << "cells: " << cells[2].size() << " cells instead of 3\n";
+        ++err;
+    }
+    if (LethalTemperatureCells().size() != 0) {
+        std::cout << "cells: default object is not empty\n";
+        ++err;
+    }
+    return err;
+}
+
+int test_remove()
+{
+    int err = 0;
+    Raster<double> temperature = {{-5, 2, -3}, {-1, -8, 0}, {4, -6, -9}};
+    std::vector<std::vector<int>> suitable_cells = {
+        {0, 0}, {0, 1}, {0, 2}, {1, 0}, {1, 1}, {1, 2}, {2, 1}, {2, 2}};
+    Raster<int> infected = {{5, 3, 0}, {1, 2, 7}, {4, 6, 1}};
+    Raster<int> susceptible = {{10, 5, 8}, {3, 4, 2}, {9, 1, 5}};
+    Raster<int> cells_infected = infected;
+    Raster<int> cells_susceptible = susceptible;
+    Simulation<Raster<int>, Raster<double>> simulation(42, 3, 3);
+    simulation.remove(infected, susceptible, temperature, -2.5, suitable_cells);
+    LethalTemperatureCells cells(
+        std::vector<Raster<double>>{temperature}, -2.5, suitable_cells);
+    simulation.remove(cells_infected, cells_susceptible, cells[0]);
+    if (cells_infected != infected || cells_susceptible != susceptible) {
+        std::cout << "remove: results differ from removal with temperature:\n"
+                  << cells_infected << infected << cells_susceptible << susceptible;
+        ++err;
+    }
+    if (infected(0, 0) != 0 || infected(2, 0) != 4 || susceptible(2, 2) != 6) {
+        std::cout << "remove: wrong hosts removed\n";
+        ++err;
+    }
+    return err;
+}
+
+/**
+ * Runs steps of a model with temperature rasters and with the cells
+ * created from them.
+ */
+int test_model()
+{
+    int err = 0;
+    Raster<int> infected = {{5, 0, 2}, {0, 3, 0}, {1, 0, 4}};
+    Raster<int> susceptible = {{10, 20, 8}, {14, 15, 6}, {9, 12, 7}};
+    Raster<int> total_hosts = infected + susceptible;
+    Raster<int> zeros(3, 3);
+    zeros.zero();
+    std::vector<std::vector<int>> suitable_cells;
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            suitable_cells.push_back({i, j});
+
+    Config config;
+    config.weather = false;
+    // No dispersers, so only the lethal temperature changes the hosts.
+    config.reproductive_rate = 0;
+    config.natural_kernel_type = "cauchy";
+    config.natural_scale = 0.9;
+    config.use_anthropogenic_kernel = false;
+    config.anthro_kernel_type = "cauchy";
+    config.anthro_scale = 0.9;
+    config.random_seed = 42;
+    config.rows = 3;
+    config.cols = 3;
+    config.model_type = "SI";
+    config.use_lethal_temperature = true;
+    config.lethal_temperature = -4;
+    config.lethal_temperature_month = 1;
+    config.ew_res = 1;
+    config.ns_res = 1;
+    config.set_date_start(2020, 1, 1);
+    config.set_date_end(2022, 12, 31);
+    config.set_step_unit(StepUnit::Month);
+    config.set_step_num_units(1);
+    config.create_schedules();
+
+    std::vector<Raster<double>> temperatures = {
+        {{-5, 0, -8}, {1, -6, 0}, {-9, 0, 0}},
+        {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}},
+        {{-10, -10, -10}, {-10, -10, -10}, {-10, -10, -10}}};
+    LethalTemperatureCells lethal_cells(
+        temperatures, config.lethal_temperature, suitable_cells);
+
+    Raster<int> cells_infected = infected;
+    Raster<int> cells_susceptible = susceptible;
+    Raster<int> dispersers = zeros;
+    Raster<int> died = zeros;
+    Raster<int> resistant = zeros;
+    std::vector<Raster<int>> exposed;
+    std::vector<Raster<int>> mortality_tracker(1, zeros);
+    std::vector<Raster<int>> cells_mortality_tracker(1, zeros);
+    std::vector<std::tuple<int, int>> outside_dispersers;
+    Treatments<Raster<int>, Raster<double>> treatments(config.scheduler());
+    SpreadRate<Raster<int>> spread_rate(infected, 1, 1, 0, suitable_cells);
+    QuarantineEscape<Raster<int>> quarantine(zeros, 1, 1, 0, suitable_cells);
+    std::vector<std::vector<int>> movements;
+    Raster<double> weather(3, 3);
+    weather.zero();
+
+    Raster<int> after_first = {{0, 0, 0}, {0, 0, 0}, {0, 0, 4}};
+    Model<Raster<int>, Raster<double>, int> model(config);
+    Model<Raster<int>, Raster<double>, int> cells_model(config);
+    for (unsigned step = 0; step < config.scheduler().get_num_steps(); ++step) {
+        model.run_step(
+            step,
+            infected,
+            susceptible,
+            total_hosts,
+            dispersers,
+            exposed,
+            mortality_tracker,
+            died,
+            temperatures,
+            weather,
+            treatments,
+            resistant,
+            outside_dispersers,
+            spread_rate,
+            quarantine,
+            zeros,
+            movements,
+            suitable_cells);
+        cells_model.run_step(
+            step,
+            cells_infected,
+            cells_susceptible,
+            total_hosts,
+            dispersers,
+            exposed,
+            cells_mortality_tracker,
+            died,
+            lethal_cells,
+            weather,
+            treatments,
+            resistant,
+            outside_dispersers,
+            spread_rate,
+            quarantine,
+            zeros,
+            movements,
+            suitable_cells);
+        if (cells_infected != infected || cells_susceptible != susceptible) {
+            std::cout << "model: results differ in step " << step << "\n";
+            ++err;
+            break;
+        }
+        if (step == 0 && infected != after_first) {
+            std::cout << "model: wrong infected after the first lethal step:\n"
+                      << infected;
+            ++err;
+        }
+    }
+    // All infected hosts are removed in the last lethal step.
+    if (infected != zeros) {
+        std::cout << "model: infected hosts after lethal temperature:\n" << infected;
+        ++err;
+    }
+    config.lethal_temperature = -3;
+    Model<Raster<int>, Raster<double>, int> other_model(config);
+    try {
+        other_model.run_step(
+            0,
+            cells_infected,
+            cells_susceptible,
+            total_hosts,
+            dispersers,
+            exposed,
+            cells_mortality_tracker,
+            died,
+            lethal_cells,
+            weather,
+            treatments,
+            resistant,
+            outside_dispersers,
+            spread_rate,
+            quarantine,
+            zeros,
+            movements,
+            suitable_cells);
+        std::cout << "model: no exception for different lethal temperature\n";
+        ++err;
+    }
+    catch (const std::invalid_argument&) {
+    }
+    return err;
+}
+
+int main()
+{
+    int num_errors = 0;
+
+    num_errors += test_cells();
+    num_errors += test_remove();
+    num_errors += test_model();
+    std::cout << "Lethal temperature number of errors: " << num_errors << std::endl;
+    return num_errors;
+}
+
+#endif  // POPS_TEST
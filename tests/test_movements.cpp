@@ -0,0 +1,424 @@
+#ifdef POPS_TEST
+
+/*
+ * Tests for the PoPS movement table.
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * This file is part of PoPS.
+
+ * PoPS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+
+ * PoPS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pops/config.hpp>
+#include <pops/model.hpp>
+#include <pops/movements.hpp>
+#include <pops/raster.hpp>
+#include <pops/simulation.hpp>
+#include <pops/statistics.hpp>
+
+using namespace pops;
+
+int test_step_ranges()
+{
+    int err = 0;
+    // Unordered schedule, step 1 has no movements.
+    std::vector<std::vector<int>> movements = {
+        {0, 0, 1, 1, 1}, {0, 1, 1, 0, 2}, {1, 0, 0, 0, 3}, {1, 1, 0, 1, 4}};
+    std::vector<unsigned> schedule = {2, 0, 2, 0};
+    MovementTable<int> table(movements, schedule);
+    if (table.size() != 4 || table.num_steps() != 3) {
+        std::cout << "step_ranges: size " << table.size() << " or num_steps "
+                  << table.num_steps() << " is wrong\n";
+        err++;
+    }
+    auto range = table.step_range(0);
+    if (range.first != 0 || range.second != 2 || table.num_hosts(0) != 2
+        || table.num_hosts(1) != 4) {
+        std::cout << "step_ranges: step 0 is wrong\n";
+        err++;
+    }
+    range = table.step_range(1);
+    if (range.first != range.second) {
+        std::cout << "step_ranges: step 1 should be empty\n";
+        err++;
+    }
+    range = table.step_range(2);
+    if (range.first != 2 || range.second != 4 || table.num_hosts(2) != 1
+        || table.row_from(3) != 1 || table.col_to(3) != 0) {
+        std::cout << "step_ranges: step 2 is wrong\n";
+        err++;
+    }
+    range = table.step_range(10);
+    if (range.first != range.second) {
+        std::cout << "step_ranges: step after last should be empty\n";
+        err++;
+    }
+    return err;
+}
+
+int test_invalid_input()
+{
+    int err = 0;
+    std::vector<std::vector<int>> movements = {{0, 0, 1, 1, 1}, {0, 1, 1, 0, 2}};
+    try {
+        MovementTable<int> table(movements, {1});
+        std::cout << "invalid_input: size mismatch not detected\n";
+        err++;
+    }
+    catch (const std::invalid_argument&) {
+    }
+    MovementTable<int> table;
+    table.add(0, 0, 0, 1, 1, 5);
+    try {
+        table.step_range(0);
+        std::cout << "invalid_input: use before finalize not detected\n";
+        err++;
+    }
+    catch (const std::logic_error&) {
+    }
+    table.finalize();
+    try {
+        table.add(0, 0, 0, 1, 1, 5);
+        std::cout << "invalid_input: add after finalize not detected\n";
+        err++;
+    }
+    catch (const std::logic_error&) {
+    }
+    return err;
+}
+
+int test_same_as_vectors()
+{
+    Raster<int> infected = {{5, 0, 2}, {0, 3, 0}, {1, 0, 0}};
+    Raster<int> susceptible = {{10, 20, 9}, {14, 15, 0}, {3, 0, 2}};
+    Raster<int> total_hosts = infected + susceptible;
+    Raster<int> mortality_tracker(infected.rows(), infected.cols(), 0);
+    std::vector<std::vector<int>> movements = {
+        {0, 0, 1, 1, 4},
+        {1, 1, 0, 0, 3},
+        {0, 2, 2, 2, 2},
+        {0, 0, 0, 1, 6},
+        {2, 0, 1, 2, 4}};
+    std::vector<unsigned> schedule = {0, 0, 1, 3, 3};
+    MovementTable<int> table(movements, schedule);
+
+    auto infected_vectors = infected;
+    auto susceptible_vectors = susceptible;
+    auto total_hosts_vectors = total_hosts;
+    auto infected_table = infected;
+    auto susceptible_table = susceptible;
+    auto total_hosts_table = total_hosts;
+    Simulation<Raster<int>, Raster<double>> simulation_vectors(
+        42, infected.rows(), infected.cols());
+    Simulation<Raster<int>, Raster<double>> simulation_table(
+        42, infected.rows(), infected.cols());
+    unsigned last_index = 0;
+    for (unsigned step = 0; step < 5; ++step) {
+        last_index = simulation_vectors.movement(
+            infected_vectors,
+            susceptible_vectors,
+            mortality_tracker,
+            total_hosts_vectors,
+            step,
+            last_index,
+            movements,
+            schedule);
+        simulation_table.movement(
+            infected_table,
+            susceptible_table,
+            mortality_tracker,
+            total_hosts_table,
+            step,
+            table);
+    }
+    if (infected_vectors != infected_table || susceptible_vectors != susceptible_table
+        || total_hosts_vectors != total_hosts_table) {
+        std::cout << "same_as_vectors: results differ (vectors, table):\n"
+                  << infected_vectors << susceptible_vectors << infected_table
+                  << susceptible_table;
+        return 1;
+    }
+    if (infected_table == infected) {
+        std::cout << "same_as_vectors: no hosts were moved\n";
+        return 1;
+    }
+    return 0;
+}
+
+/** Applies movements using movement() and batched_movement() for all steps
+ * and compares the results.
+ */
+int compare_batched_with_sequential(
+    const std::string& name,
+    const std::vector<std::vector<int>>& movements,
+    const std::vector<unsigned>& schedule)
+{
+    Raster<int> infected = {{5, 0, 2}, {0, 3, 0}, {1, 0, 0}};
+    Raster<int> susceptible = {{10, 20, 9}, {14, 15, 0}, {3, 0, 2}};
+    Raster<int> total_hosts = infected + susceptible;
+    Raster<int> mortality_tracker(infected.rows(), infected.cols(), 0);
+    MovementTable<int> table(movements, schedule);
+
+    auto infected_sequential = infected;
+    auto susceptible_sequential = susceptible;
+    auto total_hosts_sequential = total_hosts;
+    auto infected_batched = infected;
+    auto susceptible_batched = susceptible;
+    auto total_hosts_batched = total_hosts;
+    bool movement_stochasticity = false;
+    Simulation<Raster<int>, Raster<double>> simulation_sequential(
+        42,
+        infected.rows(),
+        infected.cols(),
+        ModelType::SusceptibleInfected,
+        0,
+        true,
+        true,
+        movement_stochasticity);
+    Simulation<Raster<int>, Raster<double>> simulation_batched(
+        42,
+        infected.rows(),
+        infected.cols(),
+        ModelType::SusceptibleInfected,
+        0,
+        true,
+        true,
+        movement_stochasticity);
+    for (unsigned step = 0; step < table.num_steps(); ++step) {
+        simulation_sequential.movement(
+            infected_sequential,
+            susceptible_sequential,
+            mortality_tracker,
+            total_hosts_sequential,
+            step,
+            table);
+        simulation_batched.batched_movement(
+            infected_batched,
+            susceptible_batched,
+            mortality_tracker,
+            total_hosts_batched,
+            step,
+            table,
+            4);
+    }
+    if (infected_sequential != infected_batched
+        || susceptible_sequential != susceptible_batched
+        || total_hosts_sequential != total_hosts_batched) {
+        std::cout << name << ": results differ (sequential, batched):\n"
+                  << infected_sequential << susceptible_sequential << infected_batched
+                  << susceptible_batched;
+        return 1;
+    }
+    return 0;
+}
+
+int test_batched_same_as_sequential()
+{
+    int err = 0;
+    // No destination is also a source in the same step.
+    err += compare_batched_with_sequential(
+        "batched_no_conflict",
+        {{0, 0, 1, 1, 4},
+         {0, 2, 2, 2, 2},
+         {0, 0, 2, 1, 6},
+         {1, 0, 0, 1, 3},
+         {1, 1, 2, 2, 4}},
+        {0, 0, 0, 1, 1});
+    // Cell (1, 1) receives hosts and ships them further in the same step.
+    err += compare_batched_with_sequential(
+        "batched_conflict",
+        {{0, 0, 1, 1, 4}, {1, 1, 2, 2, 20}, {2, 0, 0, 0, 1}, {0, 0, 0, 1, 3}},
+        {0, 0, 0, 1});
+    return err;
+}
+
+int test_batched_independent_of_threads()
+{
+    int rows = 20;
+    int cols = 20;
+    Raster<int> infected(rows, cols, 3);
+    Raster<int> susceptible(rows, cols, 50);
+    Raster<int> total_hosts = infected + susceptible;
+    Raster<int> mortality_tracker(rows, cols, 0);
+    // Sources in the top half, destinations in the bottom half.
+    MovementTable<int> table;
+    std::default_random_engine generator(1);
+    std::uniform_int_distribution<int> row_distribution(0, rows / 2 - 1);
+    std::uniform_int_distribution<int> col_distribution(0, cols - 1);
+    for (unsigned step = 0; step < 3; ++step) {
+        for (int i = 0; i < 500; ++i) {
+            table.add(
+                step,
+                row_distribution(generator),
+                col_distribution(generator),
+                rows / 2 + row_distribution(generator),
+                col_distribution(generator),
+                5);
+        }
+    }
+    table.finalize();
+    std::vector<std::vector<int>> cells;
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            cells.push_back({i, j});
+    std::vector<Raster<int>> results;
+    for (unsigned num_threads : {1, 3, 8}) {
+        auto infected_copy = infected;
+        auto susceptible_copy = susceptible;
+        auto total_hosts_copy = total_hosts;
+        Simulation<Raster<int>, Raster<double>> simulation(42, rows, cols);
+        for (unsigned step = 0; step < table.num_steps(); ++step) {
+            simulation.batched_movement(
+                infected_copy,
+                susceptible_copy,
+                mortality_tracker,
+                total_hosts_copy,
+                step,
+                table,
+                num_threads);
+        }
+        if (sum_of_infected(infected_copy, cells) != sum_of_infected(infected, cells)) {
+            std::cout << "batched_independent_of_threads: infected hosts not "
+                         "preserved with "
+                      << num_threads << " threads\n";
+            return 1;
+        }
+        results.push_back(infected_copy);
+    }
+    for (const auto& result : results) {
+        if (result != results[0]) {
+            std::cout << "batched_independent_of_threads: results differ\n";
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Runs model steps with movements as nested vectors and changes
+ * the movements between the steps.
+ *
+ * With *in_place*, the same vector is modified between the steps
+ * instead of passing a different vector.
+ */
+int test_model_new_movements(bool in_place)
+{
+    int err = 0;
+    Raster<int> infected = {{5, 0, 2}, {0, 3, 0}, {1, 0, 0}};
+    Raster<int> susceptible = {{10, 20, 9}, {14, 15, 0}, {3, 0, 2}};
+    Raster<int> total_hosts = infected + susceptible;
+    Raster<int> zeros(3, 3);
+    zeros.zero();
+    std::vector<std::vector<int>> suitable_cells;
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            suitable_cells.push_back({i, j});
+
+    Config config;
+    config.weather = false;
+    // No dispersers, so only the movements change the hosts.
+    config.reproductive_rate = 0;
+    config.natural_kernel_type = "cauchy";
+    config.natural_scale = 0.9;
+    config.use_anthropogenic_kernel = false;
+    config.anthro_kernel_type = "cauchy";
+    config.anthro_scale = 0.9;
+    config.random_seed = 42;
+    config.rows = 3;
+    config.cols = 3;
+    config.model_type = "SI";
+    config.ew_res = 1;
+    config.ns_res = 1;
+    config.use_movements = true;
+    config.movement_stochasticity = false;
+    config.movement_schedule = {1};
+    config.set_date_start(2020, 1, 1);
+    config.set_date_end(2020, 12, 31);
+    config.set_step_unit(StepUnit::Month);
+    config.set_step_num_units(1);
+    config.create_schedules();
+
+    Raster<int> dispersers = zeros;
+    Raster<int> died = zeros;
+    Raster<int> resistant = zeros;
+    std::vector<Raster<int>> exposed;
+    std::vector<Raster<int>> mortality_tracker(1, zeros);
+    std::vector<Raster<double>> temperatures;
+    std::vector<std::tuple<int, int>> outside_dispersers;
+    Treatments<Raster<int>, Raster<double>> treatments(config.scheduler());
+    SpreadRate<Raster<int>> spread_rate(infected, 1, 1, 0, suitable_cells);
+    QuarantineEscape<Raster<int>> quarantine(zeros, 1, 1, 0, suitable_cells);
+    Raster<double> weather(3, 3);
+    weather.zero();
+
+    std::vector<std::vector<int>> first_movements = {{0, 0, 1, 1, 4}};
+    std::vector<std::vector<int>> second_movements = {{0, 2, 2, 2, 2}};
+    std::vector<std::vector<int>> movements = first_movements;
+    Model<Raster<int>, Raster<double>, int> model(config);
+    for (unsigned step = 0; step < 2; ++step) {
+        if (in_place && step == 1)
+            movements[0] = second_movements[0];
+        model.run_step(
+            step,
+            infected,
+            susceptible,
+            total_hosts,
+            dispersers,
+            exposed,
+            mortality_tracker,
+            died,
+            temperatures,
+            weather,
+            treatments,
+            resistant,
+            outside_dispersers,
+            spread_rate,
+            quarantine,
+            zeros,
+            in_place ? movements
+                     : (step == 0 ? first_movements : second_movements),
+            suitable_cells);
+    }
+    // Only the movements passed in the step with movements are applied.
+    Raster<int> expected_total = {{15, 20, 9}, {14, 18, 0}, {4, 0, 4}};
+    if (total_hosts != expected_total) {
+        std::cout << "model_new_movements: wrong hosts moved:\n" << total_hosts;
+        ++err;
+    }
+    return err;
+}
+
+int main()
+{
+    int num_errors = 0;
+
+    num_errors += test_step_ranges();
+    num_errors += test_invalid_input();
+    num_errors += test_same_as_vectors();
+    num_errors += test_batched_same_as_sequential();
+    num_errors += test_batched_independent_of_threads();
+    num_errors += test_model_new_movements(false);
+    num_errors += test_model_new_movements(true);
+    std::cout << "Movements number of errors: " << num_errors << std::endl;
+    return num_errors;
+}
+
+#endif  // POPS_TEST
@@ -0,0 +1,197 @@
+#ifdef POPS_TEST
+
+/*
+ * Tests for the PoPS asynchronous output writer.
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * This file is part of PoPS.
+
+ * PoPS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+
+ * PoPS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <pops/config.hpp>
+#include <pops/exposed_cohorts.hpp>
+#include <pops/output.hpp>
+#include <pops/raster.hpp>
+
+using namespace pops;
+
+std::vector<int> read_values(const std::string& name, std::size_t size)
+{
+    std::vector<int> values(size);
+    std::ifstream file(name, std::ios::binary);
+    file.read(reinterpret_cast<char*>(values.data()), size * sizeof(int));
+    if (!file)
+        values.clear();
+    return values;
+}
+
+std::string read_text(const std::string& name)
+{
+    std::ifstream file(name);
+    std::stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+int test_write_state()
+{
+    int err = 0;
+    Raster<int> infected = {{1, 2}, {3, 4}};
+    Raster<int> susceptible = {{10, 20}, {30, 40}};
+    std::vector<Raster<int>> exposed = {{{1, 0}, {0, 1}}, {{2, 2}, {0, 0}}};
+    Raster<int> died = {{0, 0}, {5, 0}};
+    Raster<int> resistant = {{0, 7}, {0, 0}};
+    std::string prefix = "test_output_state_";
+    {
+        // One frame, so the second write waits for the first one.
+        AsyncOutputWriter<Raster<int>> writer(prefix, 1);
+        writer.write_state(
+            0, "2020-12-31", infected, susceptible, exposed, died, resistant);
+        // The snapshot is independent of later changes.
+        infected(0, 0) = 100;
+        writer.write_state(1, "2021-12-31", infected, susceptible, {}, died, resistant);
+        writer.finish();
+        if (writer.num_written() != 2) {
+            std::cout << "write_state: " << writer.num_written()
+                      << " frames written instead of 2\n";
+            err++;
+        }
+    }
+    // bands: infected, susceptible, exposed, died, resistant
+    std::vector<int> expected = {
+        1, 2, 3, 4, 10, 20, 30, 40, 3, 2, 0, 1, 0, 0, 5, 0, 0, 7, 0, 0};
+    if (read_values(prefix + "0.bin", expected.size()) != expected) {
+        std::cout << "write_state: wrong values in the first frame\n";
+        err++;
+    }
+    std::vector<int> values = read_values(prefix + "1.bin", 16);
+    if (values.empty() || values[0] != 100 || values[8] != 0 || values[15] != 0) {
+        std::cout << "write_state: wrong values in the second frame\n";
+        err++;
+    }
+    std::string header = read_text(prefix + "0.hdr");
+    for (const char* line :
+         {"ENVI\n",
+          "samples = 2\n",
+          "lines = 2\n",
+          "bands = 5\n",
+          "data type = 3\n",
+          "interleave = bsq\n",
+          "band names = {infected, susceptible, exposed, died, resistant}\n"}) {
+        if (header.find(line) == std::string::npos) {
+            std::cout << "write_state: header does not contain: " << line
+                      << header;
+            err++;
+        }
+    }
+    if (read_text(prefix + "1.hdr").find("{PoPS step 1 2021-12-31}")
+        == std::string::npos) {
+        std::cout << "write_state: header of the second frame has no date\n";
+        err++;
+    }
+    return err;
+}
+
+int test_write_state_cohorts()
+{
+    int err = 0;
+    Raster<int> infected = {{1, 2}, {3, 4}};
+    Raster<int> susceptible = {{10, 20}, {30, 40}};
+    Raster<int> died = {{0, 0}, {5, 0}};
+    Raster<int> resistant = {{0, 7}, {0, 0}};
+    ExposedCohorts exposed(2, 2, 1);
+    exposed(0, 0) = 1;
+    exposed(1, 1) = 1;
+    exposed.store_youngest();
+    exposed.rotate();
+    // Not stored yet, summed as well.
+    exposed(0, 0) = 2;
+    exposed(0, 1) = 2;
+
+    Config config;
+    config.use_spreadrates = false;
+    config.output_frequency = "month";
+    config.set_date_start(2020, 1, 1);
+    config.set_date_end(2020, 2, 29);
+    config.set_step_unit(StepUnit::Week);
+    config.set_step_num_units(1);
+    config.create_schedules();
+
+    std::string prefix = "test_output_cohorts_";
+    unsigned num_scheduled = 0;
+    {
+        AsyncOutputWriter<Raster<int>> writer(prefix);
+        for (unsigned step = 0; step < config.scheduler().get_num_steps(); ++step) {
+            if (writer.write_scheduled(
+                    config, step, infected, susceptible, exposed, died, resistant))
+                ++num_scheduled;
+        }
+        writer.finish();
+        if (num_scheduled != 2 || writer.num_written() != 2) {
+            std::cout << "write_state_cohorts: " << writer.num_written()
+                      << " frames written instead of 2\n";
+            err++;
+        }
+    }
+    // Exposed hosts from the cohorts are kept.
+    std::vector<int> expected = {
+        1, 2, 3, 4, 10, 20, 30, 40, 3, 2, 0, 1, 0, 0, 5, 0, 0, 7, 0, 0};
+    for (unsigned step = 0; step < config.scheduler().get_num_steps(); ++step) {
+        if (!config.output_schedule()[step])
+            continue;
+        std::string name = prefix + std::to_string(step) + ".bin";
+        if (read_values(name, expected.size()) != expected) {
+            std::cout << "write_state_cohorts: wrong values in " << name << "\n";
+            err++;
+        }
+    }
+    return err;
+}
+
+int test_write_error()
+{
+    Raster<int> raster = {{1, 2}, {3, 4}};
+    AsyncOutputWriter<Raster<int>> writer("nonexistent_directory/output_");
+    writer.write(0, "2020-12-31", {"infected"}, {&raster});
+    try {
+        writer.finish();
+        std::cout << "write_error: error not reported\n";
+        return 1;
+    }
+    catch (const std::runtime_error&) {
+    }
+    return 0;
+}
+
+int main()
+{
+    int num_errors = 0;
+
+    num_errors += test_write_state();
+    num_errors += test_write_state_cohorts();
+    num_errors += test_write_error();
+    std::cout << "Output number of errors: " << num_errors << std::endl;
+    return num_errors;
+}
+
+#endif  // POPS_TEST
@@ -0,0 +1,188 @@
+#ifdef POPS_TEST
+
+/*
+ * Tests for the PoPS aggregated outside dispersers.
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * This file is part of PoPS.
+
+ * PoPS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+
+ * PoPS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include <pops/outside_dispersers.hpp>
+#include <pops/radial_kernel.hpp>
+#include <pops/raster.hpp>
+#include <pops/simulation.hpp>
+
+using namespace pops;
+
+int test_counts()
+{
+    int err = 0;
+    AggregatedOutsideDispersers outside(10, 20);
+    outside.add(-1, 5);  // N, distance 1
+    outside.add(-1, 5, 3);  // N, distance 1
+    outside.add(12, 25, 2);  // SE, distance 6
+    outside.add(4, -9);  // W, distance 9
+    outside.add(3, 20, 4);  // E, distance 1
+    if (outside.total() != 11 || outside.count(-1, 5) != 4 || outside.count(12, 25) != 2
+        || outside.count(0, 0) != 0 || outside.num_cells() != 4
+        || outside.uncounted() != 0) {
+        std::cout << "counts: wrong total or cell counts\n";
+        err++;
+    }
+    if (outside.direction_count(Direction::N) != 4
+        || outside.direction_count(Direction::SE) != 2
+        || outside.direction_count(Direction::W) != 1
+        || outside.direction_count(Direction::E) != 4
+        || outside.direction_count(Direction::S) != 0) {
+        std::cout << "counts: wrong direction counts\n";
+        err++;
+    }
+    std::vector<std::uint64_t> expected_distances = {8, 0, 2, 1};
+    if (outside.distance_counts() != expected_distances) {
+        std::cout << "counts: wrong distance counts:";
+        for (auto count : outside.distance_counts())
+            std::cout << " " << count;
+        std::cout << "\n";
+        err++;
+    }
+    auto cells = outside.cells();
+    if (cells.size() != 4 || cells[0].row != -1 || cells[0].col != 5
+        || cells[0].count != 4 || cells[3].row != 12 || cells[3].col != 25) {
+        std::cout << "counts: cells are wrong or not ordered\n";
+        err++;
+    }
+    try {
+        outside.add(3, 3);
+        std::cout << "counts: cell inside of the raster not detected\n";
+        err++;
+    }
+    catch (const std::invalid_argument&) {
+    }
+    outside.clear();
+    if (outside.total() || outside.num_cells() || !outside.distance_counts().empty()) {
+        std::cout << "counts: not cleared\n";
+        err++;
+    }
+    return err;
+}
+
+int test_cell_limit()
+{
+    AggregatedOutsideDispersers outside(5, 5, 2);
+    // Zero count does not use a cell.
+    outside.add(-4, 0, 0);
+    outside.add(-1, 0);
+    outside.add(-2, 0);
+    outside.add(-3, 0, 5);
+    // Already counted cell is still counted.
+    outside.add(-1, 0);
+    if (outside.total() != 8 || outside.num_cells() != 2 || outside.uncounted() != 5
+        || outside.count(-1, 0) != 2 || outside.direction_count(Direction::N) != 8) {
+        std::cout << "cell_limit: wrong counts with limit\n";
+        return 1;
+    }
+    return 0;
+}
+
+int test_same_as_vector()
+{
+    Raster<int> dispersers = {{10, 0, 0}, {0, 30, 0}, {0, 0, 5}};
+    Raster<int> susceptible(3, 3);
+    susceptible.fill(100);
+    Raster<int> total_populations = susceptible;
+    Raster<double> weather(3, 3);
+    std::vector<std::vector<int>> suitable_cells;
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            suitable_cells.push_back({i, j});
+    RadialDispersalKernel<Raster<int>> kernel(
+        30, 30, DispersalKernelType::Cauchy, 60, Direction::None, 0, 1);
+
+    std::vector<std::tuple<int, int>> vector_dispersers;
+    auto vector_infected = Raster<int>(3, 3);
+    vector_infected.zero();
+    auto vector_susceptible = susceptible;
+    auto mortality_tracker = vector_infected;
+    Simulation<Raster<int>, Raster<double>> vector_simulation(42, 3, 3);
+    vector_simulation.disperse(
+        dispersers,
+        vector_susceptible,
+        vector_infected,
+        mortality_tracker,
+        total_populations,
+        vector_dispersers,
+        false,
+        weather,
+        kernel,
+        suitable_cells);
+
+    AggregatedOutsideDispersers aggregated(3, 3);
+    auto aggregated_infected = Raster<int>(3, 3);
+    aggregated_infected.zero();
+    auto aggregated_susceptible = susceptible;
+    Simulation<Raster<int>, Raster<double>> aggregated_simulation(42, 3, 3);
+    aggregated_simulation.disperse(
+        dispersers,
+        aggregated_susceptible,
+        aggregated_infected,
+        mortality_tracker,
+        total_populations,
+        aggregated,
+        false,
+        weather,
+        kernel,
+        suitable_cells);
+
+    if (vector_infected != aggregated_infected || vector_dispersers.empty()
+        || aggregated.total() != vector_dispersers.size()) {
+        std::cout << "same_as_vector: results differ (" << vector_dispersers.size()
+                  << " and " << aggregated.total() << " outside dispersers)\n";
+        return 1;
+    }
+    for (const auto& item : vector_dispersers) {
+        int row = std::get<0>(item);
+        int col = std::get<1>(item);
+        std::uint64_t expected = 0;
+        for (const auto& other : vector_dispersers)
+            expected += other == item;
+        if (aggregated.count(row, col) != expected) {
+            std::cout << "same_as_vector: count for " << row << ", " << col
+                      << " is " << aggregated.count(row, col) << " not " << expected
+                      << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main()
+{
+    int num_errors = 0;
+
+    num_errors += test_counts();
+    num_errors += test_cell_limit();
+    num_errors += test_same_as_vector();
+    std::cout << "Outside dispersers number of errors: " << num_errors << std::endl;
+    return num_errors;
+}
+
+#endif  // POPS_TEST
@@ -24,6 +24,7 @@
  * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <stdexcept>
 #include <vector>
 #include <pops/raster.hpp>
 #include <pops/quarantine.hpp>
@@ -139,6 +140,26 @@ int test_quarantine()
         err++;
     }
 
+    if (runs[0].distances() != runs[1].distances()) {
+        std::cout << "Runs don't share distances" << std::endl;
+        err++;
+    }
+    // Tracker created with the shared distances gives the same results.
+    QuarantineEscape<Raster<int>> shared(runs[0].distances(), 3);
+    shared.infection_escape_quarantine(infection11, areas, 0, suitable_cells);
+    if (shared.distance(0) != runs[0].distance(0)
+        || shared.direction(0) != runs[0].direction(0)) {
+        std::cout << "Shared distances fail" << std::endl;
+        err++;
+    }
+    try {
+        QuarantineEscape<Raster<int>> no_distances(nullptr, 3);
+        std::cout << "No exception for missing distances" << std::endl;
+        err++;
+    }
+    catch (const std::invalid_argument&) {
+    }
+
     if (!(!runs[0].escaped(0) && runs[1].escaped(2))) {
         std::cout << "Escaped fails" << std::endl;
         err++;
@@ -155,11 +176,156 @@ int test_quarantine()
     return err;
 }
 
+/** Distance to the true boundary is the same as distance to bbox for rectangles
+ */
+int test_boundary_distance_rectangle()
+{
+    int err = 0;
+    Raster<int> areas(7, 7);
+    areas.zero();
+    std::vector<std::vector<int>> suitable_cells;
+    for (int i = 0; i < 7; ++i) {
+        for (int j = 0; j < 7; ++j) {
+            suitable_cells.push_back({i, j});
+            if (i >= 1 && i <= 5 && j >= 1 && j <= 4)
+                areas(i, j) = 2;
+        }
+    }
+    unsigned num_steps = suitable_cells.size();
+    QuarantineEscape<Raster<int>> bbox(areas, 10, 20, num_steps, suitable_cells);
+    QuarantineEscape<Raster<int>> boundary(
+        areas, 10, 20, num_steps, suitable_cells, QuarantineDistance::Boundary);
+    for (unsigned step = 0; step < num_steps; ++step) {
+        // Only one cell is infected in each step.
+        Raster<int> infected(7, 7);
+        infected.zero();
+        infected(suitable_cells[step][0], suitable_cells[step][1]) = 1;
+        bbox.infection_escape_quarantine(infected, areas, step, suitable_cells);
+        boundary.infection_escape_quarantine(infected, areas, step, suitable_cells);
+        bool escaped = bbox.escaped(step);
+        if (escaped != boundary.escaped(step)
+            || (!escaped && bbox.distance(step) != boundary.distance(step))) {
+            std::cout << "Boundary distance for rectangle fails for cell "
+                      << suitable_cells[step][0] << ", " << suitable_cells[step][1]
+                      << ": " << bbox.distance(step) << " " << boundary.distance(step)
+                      << std::endl;
+            err++;
+        }
+    }
+    return err;
+}
+
+/** Distance to the true boundary is shorter than to bbox for L-shaped area
+ */
+int test_boundary_distance_l_shape()
+{
+    int err = 0;
+    Raster<int> areas(8, 8);
+    areas.fill(1);
+    std::vector<std::vector<int>> suitable_cells;
+    for (int i = 0; i < 8; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            suitable_cells.push_back({i, j});
+            if (i <= 3 && j >= 4)
+                areas(i, j) = 0;
+        }
+    }
+    Raster<int> infected(8, 8);
+    infected.zero();
+    infected(2, 2) = 1;
+    QuarantineEscape<Raster<int>> bbox(areas, 10, 10, 1, suitable_cells);
+    QuarantineEscape<Raster<int>> boundary(
+        areas, 10, 10, 1, suitable_cells, QuarantineDistance::Boundary);
+    bbox.infection_escape_quarantine(infected, areas, 0, suitable_cells);
+    boundary.infection_escape_quarantine(infected, areas, 0, suitable_cells);
+    if (!(bbox.distance(0) == 20 && bbox.direction(0) == Direction::N)) {
+        std::cout << "Bbox distance for L-shape fails: " << bbox.distance(0) << " "
+                  << bbox.direction(0) << std::endl;
+        err++;
+    }
+    if (!(boundary.distance(0) == 10 && boundary.direction(0) == Direction::E)) {
+        std::cout << "Boundary distance for L-shape fails: " << boundary.distance(0)
+                  << " " << boundary.direction(0) << std::endl;
+        err++;
+    }
+    return err;
+}
+
+int test_area_index()
+{
+    int err = 0;
+    QuarantineAreaIndex index;
+    std::vector<int> ids = {3, 1000000, 1, -5, 3, 1000000};
+    std::vector<int> expected = {0, 1, 2, 3, 0, 1};
+    for (unsigned i = 0; i < ids.size(); ++i) {
+        if (index.insert(ids[i]) != expected[i]) {
+            std::cout << "Area index fails for id " << ids[i] << std::endl;
+            err++;
+        }
+    }
+    if (index.size() != 4 || index.find(2) != -1 || index.find(999999) != -1
+        || index.find(-5) != 3) {
+        std::cout << "Area index lookup fails" << std::endl;
+        err++;
+    }
+    // Large ids give the same results as small ones.
+    Raster<int> areas = {{0, 0, 0, 0}, {0, 7, 7, 0}, {0, 7, 7, 0}, {0, 0, 0, 0}};
+    Raster<int> large_areas = areas * 100000;
+    Raster<int> infected = {{0, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}};
+    std::vector<std::vector<int>> suitable_cells;
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            suitable_cells.push_back({i, j});
+    QuarantineEscape<Raster<int>> small(areas, 10, 10, 1, suitable_cells);
+    QuarantineEscape<Raster<int>> large(large_areas, 10, 10, 1, suitable_cells);
+    small.infection_escape_quarantine(infected, areas, 0, suitable_cells);
+    large.infection_escape_quarantine(infected, large_areas, 0, suitable_cells);
+    if (small.distance(0) != large.distance(0)
+        || small.direction(0) != large.direction(0)) {
+        std::cout << "Quarantine with large area ids fails" << std::endl;
+        err++;
+    }
+    return err;
+}
+
+/** Negative area ids have no bbox, but don't break the computation */
+int test_negative_area_id()
+{
+    int err = 0;
+    Raster<int> areas = {{0, 0, 0, 0}, {-2, 3, 3, 0}, {-2, 3, 3, 0}, {0, 0, 0, 0}};
+    Raster<int> infected = {{0, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}};
+    std::vector<std::vector<int>> suitable_cells;
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            suitable_cells.push_back({i, j});
+    try {
+        QuarantineEscape<Raster<int>> quarantine(areas, 10, 10, 1, suitable_cells);
+        quarantine.infection_escape_quarantine(infected, areas, 0, suitable_cells);
+        if (quarantine.escaped(0) || quarantine.distance(0) != 0
+            || quarantine.direction(0) != Direction::N) {
+            std::cout << "Quarantine with negative area id fails: "
+                      << quarantine.distance(0) << " " << quarantine.direction(0)
+                      << std::endl;
+            err++;
+        }
+    }
+    catch (const std::exception& e) {
+        std::cout << "Quarantine with negative area id throws: " << e.what()
+                  << std::endl;
+        err++;
+    }
+    return err;
+}
+
 int main()
 {
     int num_errors = 0;
 
     num_errors += test_quarantine();
+    num_errors += test_boundary_distance_rectangle();
+    num_errors += test_boundary_distance_l_shape();
+    num_errors += test_area_index();
+    num_errors += test_negative_area_id();
     std::cout << "Quarantine number of errors: " << num_errors << std::endl;
     return num_errors;
 }
@@ -0,0 +1,296 @@
+#ifdef POPS_TEST
+
+/*
+ * Tests for the PoPS strided raster views.
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * This file is part of PoPS.
+
+ * PoPS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+
+ * PoPS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include <pops/quarantine.hpp>
+#include <pops/radial_kernel.hpp>
+#include <pops/raster.hpp>
+#include <pops/raster_view.hpp>
+#include <pops/scheduling.hpp>
+#include <pops/simulation.hpp>
+#include <pops/spread_rate.hpp>
+#include <pops/treatments.hpp>
+
+using namespace pops;
+
+typedef RasterView<int> IntView;
+typedef RasterView<double> FloatView;
+
+/** Copies a raster to a column-major buffer */
+template<typename Number>
+std::vector<Number> to_column_major(const Raster<Number>& raster)
+{
+    std::vector<Number> buffer(raster.rows() * raster.cols());
+    for (int i = 0; i < raster.rows(); ++i)
+        for (int j = 0; j < raster.cols(); ++j)
+            buffer[j * raster.rows() + i] = raster(i, j);
+    return buffer;
+}
+
+std::vector<std::vector<int>> all_cells(int rows, int cols)
+{
+    std::vector<std::vector<int>> cells;
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            cells.push_back({i, j});
+    return cells;
+}
+
+int test_layouts()
+{
+    int err = 0;
+    Raster<int> raster = {{1, 2, 3}, {4, 5, 6}};
+    auto buffer = to_column_major(raster);
+    IntView column_major = IntView::column_major(buffer.data(), 2, 3);
+    IntView row_major(raster);
+    if (!column_major.equals(raster) || !row_major.equals(column_major)
+        || column_major(1, 0) != 4 || column_major.is_contiguous()
+        || !row_major.is_contiguous()) {
+        std::cout << "layouts: views do not match the raster:\n" << column_major;
+        err++;
+    }
+    IntView window = column_major.window(0, 1, 2, 2);
+    window += 10;
+    Raster<int> expected = {{1, 12, 13}, {4, 15, 16}};
+    if (!column_major.equals(expected) || window(1, 1) != 16) {
+        std::cout << "layouts: window does not modify the right cells:\n"
+                  << column_major;
+        err++;
+    }
+    row_major.window(1, 0, 1, 3).assign(column_major.window(0, 0, 1, 3));
+    window.zero();
+    Raster<int> expected_rows = {{1, 2, 3}, {1, 12, 13}};
+    Raster<int> expected_columns = {{1, 0, 0}, {4, 0, 0}};
+    if (!row_major.equals(expected_rows) || !column_major.equals(expected_columns)) {
+        std::cout << "layouts: assign or zero failed:\n" << row_major << column_major;
+        err++;
+    }
+    RasterView<const int> read_only(window);
+    if (read_only(1, 1) != 0 || read_only.cols() != 2
+        || read_only.origin() != &column_major(0, 1)) {
+        std::cout << "layouts: read-only view differs\n";
+        err++;
+    }
+    try {
+        column_major.window(1, 1, 2, 2);
+        std::cout << "layouts: window outside of the view not detected\n";
+        err++;
+    }
+    catch (const std::invalid_argument&) {
+    }
+    return err;
+}
+
+int test_simulation_column_major()
+{
+    int rows = 6;
+    int cols = 9;
+    Raster<int> infected(rows, cols);
+    infected.zero();
+    infected(1, 2) = 12;
+    infected(4, 7) = 5;
+    Raster<int> susceptible(rows, cols);
+    susceptible.fill(40);
+    Raster<int> total = susceptible + infected;
+    Raster<double> weather(rows, cols);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            weather(i, j) = 0.5 + 0.05 * j;
+    auto cells = all_cells(rows, cols);
+
+    // Buffers as R would provide them.
+    auto infected_buffer = to_column_major(infected);
+    auto susceptible_buffer = to_column_major(susceptible);
+    auto total_buffer = to_column_major(total);
+    auto weather_buffer = to_column_major(weather);
+    std::vector<int> dispersers_buffer(rows * cols);
+    std::vector<int> mortality_buffer(rows * cols, 0);
+    std::vector<std::vector<int>> exposed_buffers(3, std::vector<int>(rows * cols, 0));
+    IntView infected_view = IntView::column_major(infected_buffer.data(), rows, cols);
+    IntView susceptible_view =
+        IntView::column_major(susceptible_buffer.data(), rows, cols);
+    IntView total_view = IntView::column_major(total_buffer.data(), rows, cols);
+    FloatView weather_view = FloatView::column_major(weather_buffer.data(), rows, cols);
+    IntView dispersers_view =
+        IntView::column_major(dispersers_buffer.data(), rows, cols);
+    IntView mortality_view = IntView::column_major(mortality_buffer.data(), rows, cols);
+    std::vector<IntView> exposed_views;
+    for (auto& buffer : exposed_buffers)
+        exposed_views.push_back(IntView::column_major(buffer.data(), rows, cols));
+
+    Raster<int> dispersers(rows, cols);
+    Raster<int> mortality(rows, cols);
+    mortality.zero();
+    Raster<int> zeros = mortality;
+    std::vector<Raster<int>> exposed(3, zeros);
+
+    Simulation<Raster<int>, Raster<double>> simulation(
+        7, rows, cols, ModelType::SusceptibleExposedInfected, 2);
+    Simulation<IntView, FloatView> view_simulation(
+        7, rows, cols, ModelType::SusceptibleExposedInfected, 2);
+    RadialDispersalKernel<Raster<int>> kernel(
+        30, 30, DispersalKernelType::Cauchy, 40, Direction::None, 0, 1);
+    RadialDispersalKernel<IntView> view_kernel(
+        30, 30, DispersalKernelType::Cauchy, 40, Direction::None, 0, 1);
+    std::vector<std::tuple<int, int>> outside;
+    std::vector<std::tuple<int, int>> view_outside;
+    for (unsigned step = 0; step < 5; ++step) {
+        simulation.generate(dispersers, infected, true, weather, 2, cells);
+        simulation.disperse_and_infect(
+            step,
+            dispersers,
+            susceptible,
+            exposed,
+            infected,
+            mortality,
+            total,
+            outside,
+            true,
+            weather,
+            kernel,
+            cells);
+        view_simulation.generate(
+            dispersers_view, infected_view, true, weather_view, 2, cells);
+        view_simulation.disperse_and_infect(
+            step,
+            dispersers_view,
+            susceptible_view,
+            exposed_views,
+            infected_view,
+            mortality_view,
+            total_view,
+            view_outside,
+            true,
+            weather_view,
+            view_kernel,
+            cells);
+    }
+    if (!infected_view.equals(infected) || !susceptible_view.equals(susceptible)
+        || !mortality_view.equals(mortality) || !exposed_views[0].equals(exposed[0])
+        || outside != view_outside || infected_view.equals(total)) {
+        std::cout << "simulation_column_major: results differ:\n"
+                  << infected << infected_view;
+        return 1;
+    }
+    return 0;
+}
+
+int test_window()
+{
+    int err = 0;
+    // Region of interest is rows 2-5 and columns 3-7 of a larger raster.
+    int rows = 4;
+    int cols = 5;
+    Raster<int> large_infected(9, 12);
+    large_infected.zero();
+    Raster<int> large_susceptible(9, 12);
+    large_susceptible.fill(50);
+    Raster<int> large_resistant = large_infected;
+    Raster<int> large_areas = large_infected;
+    large_infected(3, 4) = 10;
+    large_infected(4, 6) = 20;
+    for (int i = 2; i < 9; ++i)
+        for (int j = 0; j < 12; ++j)
+            large_areas(i, j) = 1;
+    Raster<double> large_treatment(9, 12);
+    large_treatment.zero();
+    large_treatment(4, 6) = 1;
+
+    // Copies of the region which is what a caller would do without views.
+    Raster<int> infected(rows, cols);
+    Raster<int> susceptible(rows, cols);
+    Raster<int> resistant(rows, cols);
+    Raster<int> areas(rows, cols);
+    Raster<double> treatment(rows, cols);
+    IntView(infected).assign(IntView(large_infected).window(2, 3, rows, cols));
+    IntView(susceptible).assign(IntView(large_susceptible).window(2, 3, rows, cols));
+    IntView(resistant).assign(IntView(large_resistant).window(2, 3, rows, cols));
+    IntView(areas).assign(IntView(large_areas).window(2, 3, rows, cols));
+    FloatView(treatment).assign(FloatView(large_treatment).window(2, 3, rows, cols));
+
+    IntView infected_view = IntView(large_infected).window(2, 3, rows, cols);
+    IntView susceptible_view = IntView(large_susceptible).window(2, 3, rows, cols);
+    IntView resistant_view = IntView(large_resistant).window(2, 3, rows, cols);
+    IntView areas_view = IntView(large_areas).window(2, 3, rows, cols);
+    FloatView treatment_view = FloatView(large_treatment).window(2, 3, rows, cols);
+    auto cells = all_cells(rows, cols);
+
+    Scheduler scheduler(Date(2020, 1, 1), Date(2020, 12, 31), StepUnit::Month, 1);
+    Treatments<Raster<int>, Raster<double>> treatments(scheduler);
+    Treatments<IntView, FloatView> view_treatments(scheduler);
+    treatments.add_treatment(
+        treatment, Date(2020, 1, 1), 0, TreatmentApplication::Ratio);
+    view_treatments.add_treatment(
+        treatment_view, Date(2020, 1, 1), 0, TreatmentApplication::Ratio);
+    std::vector<Raster<int>> exposed;
+    std::vector<IntView> exposed_views;
+    treatments.manage(0, infected, exposed, susceptible, resistant, cells);
+    view_treatments.manage(
+        0, infected_view, exposed_views, susceptible_view, resistant_view, cells);
+    if (!infected_view.equals(infected) || !susceptible_view.equals(susceptible)
+        || infected_view(2, 3) != 0 || large_infected(3, 4) != 10) {
+        std::cout << "window: treatment results differ:\n"
+                  << infected << infected_view;
+        err++;
+    }
+
+    SpreadRate<Raster<int>> spread_rate(infected, 10, 10, 1, cells);
+    SpreadRate<IntView> view_spread_rate(infected_view, 10, 10, 1, cells);
+    infected(0, 4) = 1;
+    infected_view(0, 4) = 1;
+    spread_rate.compute_step_spread_rate(infected, 0, cells);
+    view_spread_rate.compute_step_spread_rate(infected_view, 0, cells);
+    if (spread_rate.step_rate(0) != view_spread_rate.step_rate(0)) {
+        std::cout << "window: spread rates differ\n";
+        err++;
+    }
+
+    QuarantineEscape<Raster<int>> quarantine(areas, 10, 10, 1, cells);
+    QuarantineEscape<IntView> view_quarantine(areas_view, 10, 10, 1, cells);
+    quarantine.infection_escape_quarantine(infected, areas, 0, cells);
+    view_quarantine.infection_escape_quarantine(infected_view, areas_view, 0, cells);
+    if (quarantine.escaped(0) || view_quarantine.escaped(0)
+        || quarantine.distance(0) != view_quarantine.distance(0)
+        || quarantine.direction(0) != view_quarantine.direction(0)) {
+        std::cout << "window: quarantine escape differs\n";
+        err++;
+    }
+    return err;
+}
+
+int main()
+{
+    int num_errors = 0;
+
+    num_errors += test_layouts();
+    num_errors += test_simulation_column_major();
+    num_errors += test_window();
+    std::cout << "Raster view number of errors: " << num_errors << std::endl;
+    return num_errors;
+}
+
+#endif  // POPS_TEST
@@ -25,6 +25,7 @@
 
 #include <vector>
 #include <tuple>
+#include <stdexcept>
 
 #include <pops/scheduling.hpp>
 #include <pops/date.hpp>
@@ -244,6 +245,39 @@ int test_schedule_action_date()
     return num_errors;
 }
 
+int test_schedule_action_date_each_day()
+{
+    int num_errors = 0;
+
+    Date st(2019, 1, 1);
+    Date end(2023, 12, 31);
+
+    Scheduler scheduling(st, end, StepUnit::Week, 3);
+    Date date(st);
+    unsigned expected = 0;
+    while (date <= end) {
+        if (date > scheduling.get_step(expected).end_date())
+            expected++;
+        unsigned n = scheduling.schedule_action_date(date);
+        if (n != expected) {
+            std::cout << "Date " << date << " scheduled in step " << n << " not "
+                      << expected << std::endl;
+            num_errors++;
+            break;
+        }
+        date.add_day();
+    }
+    try {
+        scheduling.schedule_action_date(Date(2018, 12, 31));
+        std::cout << "Date before start not detected" << std::endl;
+        num_errors++;
+    }
+    catch (const std::invalid_argument&) {
+    }
+
+    return num_errors;
+}
+
 int test_schedule_end_of_simulation()
 {
     int num_errors = 0;
@@ -278,6 +312,18 @@ int test_simulation_step_to_action_step()
         std::cout << "Failed simulation_step_to_action_step" << std::endl;
         num_errors++;
     }
+    std::vector<unsigned> action_steps = simulation_steps_to_action_steps(vect_action1);
+    if (action_steps.size() != vect_action1.size()) {
+        std::cout << "Failed simulation_steps_to_action_steps size" << std::endl;
+        return ++num_errors;
+    }
+    for (unsigned step = 0; step < vect_action1.size(); ++step) {
+        if (action_steps[step] != simulation_step_to_action_step(vect_action1, step)) {
+            std::cout << "Failed simulation_steps_to_action_steps for step " << step
+                      << std::endl;
+            num_errors++;
+        }
+    }
 
     return num_errors;
 }
@@ -404,6 +450,7 @@ int main()
     num_errors += test_schedule_action_end_of_year();
     num_errors += test_schedule_action_nsteps();
     num_errors += test_schedule_action_date();
+    num_errors += test_schedule_action_date_each_day();
     num_errors += test_schedule_end_of_simulation();
     num_errors += test_schedule_action_monthly();
     num_errors += test_simulation_step_to_action_step();
@@ -23,6 +23,7 @@
  * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <pops/alias_kernel.hpp>
 #include <pops/raster.hpp>
 #include <pops/radial_kernel.hpp>
 #include <pops/neighbor_kernel.hpp>
@@ -634,6 +635,215 @@ int test_calling_all_functions()
     return 0;
 }
 
+/** Kernel which provides only sample() of the wrapped kernel */
+template<typename Kernel>
+class SampleOnlyKernel
+{
+public:
+    SampleOnlyKernel(Kernel& kernel) : kernel_(kernel) {}
+
+    template<typename Generator>
+    void sample(
+        Generator& generator,
+        int row,
+        int col,
+        int count,
+        std::vector<std::tuple<int, int>>& targets)
+    {
+        kernel_.sample(generator, row, col, count, targets);
+    }
+
+private:
+    Kernel& kernel_;
+};
+
+/** Disperses many dispersers from one cell with and without sample_counts() */
+int test_bulk_dispersal()
+{
+    int ret = 0;
+    int size = 15;
+    int hosts = 500;
+    int num_dispersers = 50000;
+    std::vector<std::vector<int>> suitable_cells;
+    for (int i = 0; i < size; ++i)
+        for (int j = 0; j < size; ++j)
+            suitable_cells.push_back({i, j});
+    Raster<int> dispersers(size, size);
+    dispersers.zero();
+    dispersers(7, 7) = num_dispersers;
+    Raster<double> weather_coefficient(size, size);
+    weather_coefficient.fill(1);
+    AliasDispersalKernel kernel(30, 30, DispersalKernelType::Exponential, 30, 0.99);
+    SampleOnlyKernel<AliasDispersalKernel> sample_only(kernel);
+
+    for (bool stochastic : {true, false}) {
+        int totals[2];
+        for (int bulk = 0; bulk < 2; ++bulk) {
+            Raster<int> susceptible(size, size);
+            susceptible.fill(hosts);
+            Raster<int> total_hosts = susceptible;
+            Raster<int> infected(size, size);
+            infected.zero();
+            Raster<int> mortality_tracker = infected;
+            AggregatedOutsideDispersers outside_dispersers(size, size);
+            Simulation<Raster<int>, Raster<double>> simulation(
+                42, size, size, ModelType::SusceptibleInfected, 0, true, stochastic);
+            if (bulk) {
+                simulation.disperse(
+                    dispersers,
+                    susceptible,
+                    infected,
+                    mortality_tracker,
+                    total_hosts,
+                    outside_dispersers,
+                    true,
+                    weather_coefficient,
+                    kernel,
+                    suitable_cells,
+                    0.2);
+            }
+            else {
+                simulation.disperse(
+                    dispersers,
+                    susceptible,
+                    infected,
+                    mortality_tracker,
+                    total_hosts,
+                    outside_dispersers,
+                    true,
+                    weather_coefficient,
+                    sample_only,
+                    suitable_cells,
+                    0.2);
+            }
+            totals[bulk] = 0;
+            for (int i = 0; i < size; ++i) {
+                for (int j = 0; j < size; ++j) {
+                    if (susceptible(i, j) + infected(i, j) != hosts
+                        || infected(i, j) != mortality_tracker(i, j)) {
+                        cout << "Bulk dispersal: hosts not preserved in cell " << i
+                             << ", " << j << "\n";
+                        ++ret;
+                    }
+                    totals[bulk] += infected(i, j);
+                }
+            }
+            if (totals[bulk] > num_dispersers - int(outside_dispersers.total())) {
+                cout << "Bulk dispersal: more infected than dispersers\n";
+                ++ret;
+            }
+        }
+        if (std::abs(totals[0] - totals[1]) > 0.03 * totals[0]) {
+            cout << "Bulk dispersal (stochastic " << stochastic << "): "
+                 << totals[1] << " infected instead of about " << totals[0] << "\n";
+            ++ret;
+        }
+    }
+    return ret;
+}
+
+/** Compares dispersal with and without two-phase establishment */
+int test_two_phase_establishment()
+{
+    int ret = 0;
+    int size = 15;
+    int hosts = 300;
+    std::vector<std::vector<int>> suitable_cells;
+    for (int i = 0; i < size; ++i)
+        for (int j = 0; j < size; ++j)
+            suitable_cells.push_back({i, j});
+    Raster<int> dispersers(size, size);
+    dispersers.zero();
+    dispersers(7, 7) = 20000;
+    dispersers(3, 4) = 5000;
+    dispersers(10, 12) = 10;
+    Raster<double> weather_coefficient(size, size);
+    weather_coefficient.fill(0.7);
+    Raster<int> total_hosts(size, size);
+    total_hosts.fill(hosts + 100);
+
+    // Returns infected hosts after dispersal.
+    auto run = [&](bool two_phase, bool stochastic, bool weather, unsigned seed) {
+        Raster<int> susceptible(size, size);
+        susceptible.fill(hosts);
+        Raster<int> infected(size, size);
+        infected.zero();
+        Raster<int> mortality_tracker = infected;
+        AggregatedOutsideDispersers outside_dispersers(size, size);
+        RadialDispersalKernel<Raster<int>> kernel(
+            30, 30, DispersalKernelType::Exponential, 40);
+        Simulation<Raster<int>, Raster<double>> simulation(
+            seed,
+            size,
+            size,
+            ModelType::SusceptibleInfected,
+            0,
+            true,
+            stochastic,
+            true,
+            two_phase);
+        simulation.disperse(
+            dispersers,
+            susceptible,
+            infected,
+            mortality_tracker,
+            total_hosts,
+            outside_dispersers,
+            weather,
+            weather_coefficient,
+            kernel,
+            suitable_cells,
+            0.3);
+        for (int i = 0; i < size; ++i) {
+            for (int j = 0; j < size; ++j) {
+                if (susceptible(i, j) + infected(i, j) != hosts) {
+                    cout << "Two-phase establishment: hosts not preserved\n";
+                    ++ret;
+                    return infected;
+                }
+            }
+        }
+        return infected;
+    };
+
+    // Deterministic establishment does not depend on order of dispersers.
+    auto one_phase = run(false, false, false, 42);
+    auto two_phase = run(true, false, false, 42);
+    if (one_phase != two_phase) {
+        cout << "Two-phase establishment (deterministic): infected (actual, "
+                "expected):\n"
+             << two_phase << "  !=\n"
+             << one_phase << "\n";
+        ++ret;
+    }
+    // Stochastic establishment gives similar numbers of infected.
+    for (bool weather : {false, true}) {
+        double totals[2] = {0, 0};
+        for (int two_phase : {0, 1}) {
+            for (unsigned seed = 1; seed <= 5; ++seed) {
+                auto infected = run(two_phase, true, weather, seed);
+                for (int i = 0; i < size; ++i)
+                    for (int j = 0; j < size; ++j)
+                        totals[two_phase] += infected(i, j);
+            }
+        }
+        if (std::abs(totals[0] - totals[1]) > 0.02 * totals[0]) {
+            cout << "Two-phase establishment (weather " << weather
+                 << "): " << totals[1] << " infected instead of about " << totals[0]
+                 << "\n";
+            ++ret;
+        }
+    }
+    try {
+        run(true, false, true, 42);
+        cout << "Two-phase establishment: no exception for deterministic weather\n";
+        ++ret;
+    }
+    catch (const std::invalid_argument&) {
+    }
+    return ret;
+}
+
 int main()
 {
     int ret = 0;
@@ -647,6 +857,8 @@ int main()
     ret += test_with_reduced_stochasticity();
     ret += test_with_sei();
     ret += test_SI_versus_SEI0();
+    ret += test_bulk_dispersal();
+    ret += test_two_phase_establishment();
 
     return ret;
 }
@@ -24,10 +24,15 @@
  * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <string>
 #include <tuple>
 #include <vector>
 #include <cmath>
 
+#include <pops/config.hpp>
+#include <pops/date.hpp>
+#include <pops/model.hpp>
+#include <pops/movements.hpp>
 #include <pops/raster.hpp>
 #include <pops/spread_rate.hpp>
 
@@ -93,11 +98,282 @@ int test_spread_rate()
     return err;
 }
 
+/** Compares rates computed from rasters and from incrementally updated extent
+ */
+int test_incremental_extent()
+{
+    int err = 0;
+    Raster<int> infected = {
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0}};
+
+    Raster<int> infected1 = {
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 1, 2, 7, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0}};
+
+    Raster<int> infected2 = {
+        {0, 0, 0, 0, 0},
+        {0, 0, 2, 0, 0},
+        {1, 1, 2, 7, 0},
+        {0, 0, 0, 9, 0},
+        {0, 0, 0, 0, 0}};
+
+    Raster<int> infected3 = {
+        {0, 0, 0, 0, 0},
+        {0, 0, 2, 0, 1},
+        {1, 1, 0, 7, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0}};
+
+    const std::vector<std::vector<int>> suitable_cells = {
+        {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}, {1, 0}, {1, 1}, {1, 2}, {1, 3},
+        {1, 4}, {2, 0}, {2, 1}, {2, 2}, {2, 3}, {2, 4}, {3, 0}, {3, 1}, {3, 2},
+        {3, 3}, {3, 4}, {4, 0}, {4, 1}, {4, 2}, {4, 3}, {4, 4}};
+
+    std::vector<Raster<int>> steps = {infected1, infected2, infected3};
+    SpreadRate<Raster<int>> spread_rate(infected, 10, 10, 3, suitable_cells);
+    InfectionExtent extent(infected, suitable_cells);
+    SpreadRate<Raster<int>> incremental_spread_rate(extent, 10, 10, 3);
+    Raster<int> previous = infected;
+    for (unsigned step = 0; step < steps.size(); ++step) {
+        const auto& current = steps[step];
+        // Report only the cells which changed.
+        for (int i = 0; i < current.rows(); ++i)
+            for (int j = 0; j < current.cols(); ++j)
+                if (current(i, j) != previous(i, j))
+                    extent.update(i, j, current(i, j));
+        previous = current;
+        spread_rate.compute_step_spread_rate(current, step, suitable_cells);
+        incremental_spread_rate.compute_step_spread_rate(extent, step);
+        double n1, s1, e1, w1, n2, s2, e2, w2;
+        std::tie(n1, s1, e1, w1) = spread_rate.step_rate(step);
+        std::tie(n2, s2, e2, w2) = incremental_spread_rate.step_rate(step);
+        if (!(n1 == n2 && s1 == s2 && e1 == e2 && std::isnan(w1) == std::isnan(w2)
+              && (std::isnan(w1) || w1 == w2))) {
+            std::cout << "incremental spread rate for step " << step << " fails"
+                      << std::endl;
+            err++;
+        }
+    }
+    // Removing all infection gives no extent.
+    for (int i = 0; i < previous.rows(); ++i)
+        for (int j = 0; j < previous.cols(); ++j)
+            extent.update(i, j, 0);
+    if (extent.num_infected_cells() != 0
+        || extent.bbox() != std::make_tuple(-1, -1, -1, -1)) {
+        std::cout << "extent without infection fails" << std::endl;
+        err++;
+    }
+    return err;
+}
+
+/** Configuration for a model which changes infected hosts in all possible ways */
+Config extent_config(const std::string& model_type, bool batched_movements)
+{
+    Config config;
+    config.random_seed = 7;
+    config.rows = 12;
+    config.cols = 12;
+    config.ew_res = 1;
+    config.ns_res = 1;
+    config.model_type = model_type;
+    config.latency_period_steps = 2;
+    config.reproductive_rate = 2;
+    config.natural_kernel_type = "cauchy";
+    config.natural_scale = 1.5;
+    config.natural_direction = "none";
+    config.natural_kappa = 0;
+    config.use_anthropogenic_kernel = false;
+    config.percent_natural_dispersal = 1;
+    config.anthro_kernel_type = "cauchy";
+    config.anthro_scale = 3;
+    config.anthro_direction = "none";
+    config.anthro_kappa = 0;
+    config.use_lethal_temperature = true;
+    config.lethal_temperature = -10;
+    config.lethal_temperature_month = 1;
+    config.use_mortality = true;
+    config.mortality_rate = 0.5;
+    config.first_mortality_year = 1;
+    config.use_treatments = true;
+    config.use_movements = true;
+    config.use_batched_movements = batched_movements;
+    config.movement_schedule = {2, 3, 5, 5};
+    config.use_overpopulation_movements = true;
+    config.overpopulation_percentage = 0.4;
+    config.leaving_percentage = 0.5;
+    config.use_spreadrates = true;
+    config.spreadrate_frequency = "month";
+    config.spreadrate_frequency_n = 1;
+    config.set_date_start(2020, 1, 1);
+    config.set_date_end(2021, 12, 31);
+    config.set_step_unit(StepUnit::Month);
+    config.set_step_num_units(1);
+    config.create_schedules();
+    return config;
+}
+
+/**
+ * Runs model steps and collects the spread rates.
+ *
+ * With *use_extent*, the model updates the extent of infection which is
+ * compared with the extent from a full scan of infected hosts after each step.
+ */
+template<typename Exposed>
+int run_model_with_extent(
+    const std::string& name,
+    Config config,
+    Exposed exposed,
+    bool use_extent,
+    std::vector<BBoxFloat>& rates)
+{
+    int err = 0;
+    int rows = config.rows;
+    int cols = config.cols;
+    Raster<int> infected(rows, cols);
+    infected.zero();
+    infected(2, 3) = 20;
+    infected(8, 8) = 6;
+    Raster<int> susceptible(rows, cols);
+    susceptible.fill(30);
+    Raster<int> total_hosts = infected + susceptible;
+    Raster<int> zeros(rows, cols);
+    zeros.zero();
+    std::vector<std::vector<int>> suitable_cells;
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            suitable_cells.push_back({i, j});
+
+    // Infection in the top rows is removed by lethal temperature.
+    Raster<double> temperature(rows, cols);
+    temperature.zero();
+    for (int j = 0; j < cols; ++j)
+        temperature(0, j) = temperature(1, j) = -15;
+    std::vector<Raster<double>> temperatures(config.num_lethal(), temperature);
+    Raster<double> weather(rows, cols);
+    weather.fill(1);
+    Treatments<Raster<int>, Raster<double>> treatments(config.scheduler());
+    Raster<double> treatment(rows, cols);
+    treatment.zero();
+    for (int i = 0; i < rows; ++i) {
+        treatment(i, 0) = 1;
+        treatment(i, 6) = 0.5;
+    }
+    treatments.add_treatment(
+        treatment, Date(2020, 4, 1), 0, TreatmentApplication::Ratio);
+    treatments.add_treatment(
+        treatment, Date(2020, 9, 1), 30, TreatmentApplication::AllInfectedInCell);
+    // The second shipment takes all hosts from the source cell.
+    MovementTable<int> movements(
+        {{8, 8, 11, 0, 10}, {2, 3, 5, 11, 1000}, {5, 11, 11, 11, 5}, {11, 0, 0, 11, 3}},
+        config.movement_schedule);
+
+    Raster<int> dispersers = zeros;
+    Raster<int> died = zeros;
+    Raster<int> resistant = zeros;
+    std::vector<Raster<int>> mortality_tracker(config.num_mortality_years(), zeros);
+    std::vector<std::tuple<int, int>> outside_dispersers;
+    unsigned num_steps = config.scheduler().get_num_steps();
+    SpreadRate<Raster<int>> spread_rate(infected, 1, 1, num_steps, suitable_cells);
+    QuarantineEscape<Raster<int>> quarantine(zeros, 1, 1, 0, suitable_cells);
+    InfectionExtent extent(infected, suitable_cells);
+
+    Model<Raster<int>, Raster<double>, int> model(config);
+    if (use_extent)
+        model.set_infection_extent(&extent);
+    for (unsigned step = 0; step < num_steps; ++step) {
+        model.run_step(
+            step,
+            infected,
+            susceptible,
+            total_hosts,
+            dispersers,
+            exposed,
+            mortality_tracker,
+            died,
+            temperatures,
+            weather,
+            treatments,
+            resistant,
+            outside_dispersers,
+            spread_rate,
+            quarantine,
+            zeros,
+            movements,
+            suitable_cells);
+        InfectionExtent scan(infected, suitable_cells);
+        if (use_extent
+            && (extent.bbox() != scan.bbox()
+                || extent.num_infected_cells() != scan.num_infected_cells())) {
+            std::cout << name << ": extent differs from full scan in step " << step
+                      << std::endl;
+            err++;
+            break;
+        }
+        rates.push_back(spread_rate.step_rate(step));
+    }
+    return err;
+}
+
+/** Compares extent updated by the model with a full scan and compares
+ * spread rates from the extent with the ones from scans
+ */
+template<typename Exposed>
+int compare_model_extent(const std::string& name, const Config& config, Exposed exposed)
+{
+    int err = 0;
+    std::vector<BBoxFloat> scan_rates;
+    std::vector<BBoxFloat> extent_rates;
+    err += run_model_with_extent(name, config, exposed, false, scan_rates);
+    err += run_model_with_extent(name, config, exposed, true, extent_rates);
+    // Rates are NaN when bbox touches the edge, NaNs are not equal.
+    bool same = scan_rates.size() == extent_rates.size();
+    for (unsigned i = 0; same && i < scan_rates.size(); ++i) {
+        double a[4];
+        double b[4];
+        std::tie(a[0], a[1], a[2], a[3]) = scan_rates[i];
+        std::tie(b[0], b[1], b[2], b[3]) = extent_rates[i];
+        for (int k = 0; k < 4; ++k)
+            if (!(a[k] == b[k] || (std::isnan(a[k]) && std::isnan(b[k]))))
+                same = false;
+    }
+    if (!same) {
+        std::cout << name << ": spread rates differ with extent" << std::endl;
+        err++;
+    }
+    return err;
+}
+
+int test_model_extent()
+{
+    int err = 0;
+    Config si = extent_config("SI", false);
+    Config sei = extent_config("SEI", true);
+    Raster<int> zeros(si.rows, si.cols);
+    zeros.zero();
+    err += compare_model_extent("SI", si, std::vector<Raster<int>>());
+    err += compare_model_extent(
+        "SEI", sei, std::vector<Raster<int>>(sei.latency_period_steps + 1, zeros));
+    err += compare_model_extent(
+        "SEI cohorts",
+        extent_config("SEI", false),
+        ExposedCohorts(sei.rows, sei.cols, sei.latency_period_steps));
+    return err;
+}
+
 int main()
 {
     int num_errors = 0;
 
     num_errors += test_spread_rate();
+    num_errors += test_incremental_extent();
+    num_errors += test_model_extent();
     std::cout << "Spread rate number of errors: " << num_errors << std::endl;
     return num_errors;
 }
@@ -23,7 +23,10 @@
  * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <cstdint>
+#include <map>
 #include <vector>
+#include <pops/exposed_cohorts.hpp>
 #include <pops/raster.hpp>
 #include <pops/statistics.hpp>
 
@@ -79,12 +82,94 @@ int test_area()
     return err;
 }
 
+int test_statistics_calculator()
+{
+    int err = 0;
+    Raster<int> infected = {
+        {0, 0, 0, 0, 25},
+        {1, 0, 0, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 5, 0, 0},
+        {0, 0, 0, 0, 0}};
+    Raster<int> previous = {
+        {0, 0, 0, 0, 20},
+        {0, 0, 0, 0, 0},
+        {0, 0, 1, 0, 0},
+        {0, 0, 0, 0, 0},
+        {0, 0, 0, 0, 0}};
+    Raster<int> susceptible = {
+        {1, 1, 1, 1, 0},
+        {1, 1, 1, 1, 1},
+        {1, 1, 1, 1, 1},
+        {1, 1, 1, 1, 1},
+        {1, 1, 1, 1, 10}};
+    Raster<int> areas = {
+        {1, 1, 1, 3, 3},
+        {1, 1, 1, 3, 3},
+        {0, 0, 2, 0, 0},
+        {0, 0, 2, 0, 0},
+        {0, 0, 0, 0, 0}};
+    std::vector<Raster<int>> exposed = {previous, infected};
+
+    std::vector<std::vector<int>> suitable_cells = {
+        {0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}, {1, 0}, {1, 1}, {1, 2}, {1, 3},
+        {1, 4}, {2, 0}, {2, 1}, {2, 2}, {2, 3}, {2, 4}, {3, 0}, {3, 1}, {3, 2},
+        {3, 3}, {3, 4}, {4, 0}, {4, 1}, {4, 2}, {4, 3}, {4, 4}};
+
+    std::map<int, std::uint64_t> expected_areas = {{1, 1}, {2, 2}, {3, 1}};
+    for (unsigned num_threads : {1, 2, 7, 100}) {
+        StatisticsCalculator<Raster<int>> calculator(infected, suitable_cells);
+        calculator.susceptible(susceptible)
+            .exposed(exposed)
+            .previous_infected(previous)
+            .quarantine_areas(areas)
+            .num_threads(num_threads);
+        Statistics statistics = calculator.compute(0.5, 1);
+        double area = area_of_infected(infected, 0.5, 1, suitable_cells);
+        if (statistics.infected != sum_of_infected(infected, suitable_cells)
+            || statistics.infected_cells != 4
+            || statistics.infected_area != area
+            || statistics.exposed != 53 || statistics.susceptible != 33
+            || statistics.newly_infected_cells != 2
+            || statistics.infected_cells_in_areas != expected_areas) {
+            std::cout << "statistics calculator fails with " << num_threads
+                      << " threads" << std::endl;
+            err++;
+        }
+    }
+    Statistics infected_only =
+        StatisticsCalculator<Raster<int>>(infected, suitable_cells).compute(1, 1);
+    if (infected_only.infected != 32 || infected_only.susceptible != 0
+        || infected_only.newly_infected_cells != 0
+        || !infected_only.infected_cells_in_areas.empty()) {
+        std::cout << "statistics calculator without optional inputs fails" << std::endl;
+        err++;
+    }
+    // Stored cohort and hosts exposed in the current step
+    ExposedCohorts cohorts(5, 5, 2);
+    cohorts(0, 0) = 3;
+    cohorts(2, 4) = 1;
+    cohorts.store_youngest();
+    cohorts.rotate();
+    cohorts(0, 0) = 2;
+    cohorts(4, 4) = 4;
+    StatisticsCalculator<Raster<int>> cohorts_calculator(infected, suitable_cells);
+    Statistics with_cohorts = cohorts_calculator.exposed(cohorts).compute(1, 1);
+    if (with_cohorts.exposed != 10 || with_cohorts.infected != 32) {
+        std::cout << "statistics calculator with exposed cohorts fails: "
+                  << with_cohorts.exposed << " exposed" << std::endl;
+        err++;
+    }
+    return err;
+}
+
 int main()
 {
     int num_errors = 0;
 
     num_errors += test_sum();
     num_errors += test_area();
+    num_errors += test_statistics_calculator();
     std::cout << "Statistics number of errors: " << num_errors << std::endl;
     return num_errors;
 }
@@ -0,0 +1,237 @@
+#ifdef POPS_TEST
+
+/*
+ * Tests for the PoPS tiled raster.
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * This file is part of PoPS.
+
+ * PoPS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+
+ * PoPS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+#include <pops/radial_kernel.hpp>
+#include <pops/raster.hpp>
+#include <pops/simulation.hpp>
+#include <pops/tiled_raster.hpp>
+
+using namespace pops;
+
+template<typename Tiled, typename Number>
+bool same_values(const Tiled& tiled, const Raster<Number>& raster)
+{
+    if (tiled.rows() != raster.rows() || tiled.cols() != raster.cols())
+        return false;
+    for (int i = 0; i < raster.rows(); ++i)
+        for (int j = 0; j < raster.cols(); ++j)
+            if (tiled(i, j) != raster(i, j))
+                return false;
+    return true;
+}
+
+std::vector<std::vector<int>> all_cells(int rows, int cols)
+{
+    std::vector<std::vector<int>> cells;
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            cells.push_back({i, j});
+    return cells;
+}
+
+int test_access()
+{
+    int err = 0;
+    // Size is not a multiple of the tile size.
+    int rows = 37;
+    int cols = 70;
+    Raster<int> raster(rows, cols);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            raster(i, j) = i * 1000 + j;
+    TiledRaster<int, int, 16> tiled(raster);
+    if (!same_values(tiled, raster) || !same_values(tiled.to_raster(), raster)) {
+        std::cout << "access: values differ from the row-major raster\n";
+        err++;
+    }
+    TiledRaster<int, int, 16> copy = tiled;
+    copy(36, 69) = -1;
+    copy += tiled;
+    copy *= 2;
+    if (copy(36, 69) != 2 * (36069 - 1) || copy(0, 1) != 4 || tiled(36, 69) != 36069
+        || copy == tiled) {
+        std::cout << "access: copy or operations failed\n";
+        err++;
+    }
+
+    std::vector<std::tuple<int, int>> visited;
+    tiled.for_each_cell([&visited](int i, int j) { visited.emplace_back(i, j); });
+    // Tiles in Morton order: (0, 0), (0, 1), (1, 0), (1, 1), (0, 2), ...
+    if (visited.size() != std::size_t(rows * cols)
+        || visited[16 * 16] != std::make_tuple(0, 16)
+        || visited[2 * 16 * 16] != std::make_tuple(16, 0)
+        || visited[4 * 16 * 16] != std::make_tuple(0, 32)) {
+        std::cout << "access: cells not visited in tile order\n";
+        err++;
+    }
+    std::sort(visited.begin(), visited.end());
+    if (std::unique(visited.begin(), visited.end()) != visited.end()) {
+        std::cout << "access: cell visited more than once\n";
+        err++;
+    }
+    int count = 0;
+    tiled.for_each([&count](int& value) {
+        value = 1;
+        ++count;
+    });
+    if (count != rows * cols || tiled(36, 69) != 1) {
+        std::cout << "access: for_each visited " << count << " cells\n";
+        err++;
+    }
+    return err;
+}
+
+int test_tile_ordered_cells()
+{
+    int err = 0;
+    auto cells = all_cells(6, 9);
+    auto ordered = tile_ordered_cells<4>(cells);
+    auto sorted = ordered;
+    std::sort(sorted.begin(), sorted.end());
+    if (sorted != cells) {
+        std::cout << "tile_ordered_cells: not a permutation of the cells\n";
+        err++;
+    }
+    // First tile, then the tile on the right, then the tile below.
+    std::vector<std::vector<int>> expected = {
+        {0, 0}, {0, 1}, {0, 2}, {0, 3}, {1, 0}};
+    if (!std::equal(expected.begin(), expected.end(), ordered.begin())
+        || ordered[16] != std::vector<int>({0, 4})
+        || ordered[32] != std::vector<int>({4, 0})) {
+        std::cout << "tile_ordered_cells: wrong order\n";
+        err++;
+    }
+    std::vector<std::tuple<int, int>> visited;
+    TiledRaster<int, int, 4> tiled(6, 9);
+    tiled.for_each_cell([&visited](int i, int j) { visited.emplace_back(i, j); });
+    for (std::size_t i = 0; i < ordered.size(); ++i) {
+        if (visited[i] != std::make_tuple(ordered[i][0], ordered[i][1])) {
+            std::cout << "tile_ordered_cells: differs from storage order\n";
+            err++;
+            break;
+        }
+    }
+    return err;
+}
+
+int test_simulation()
+{
+    typedef TiledRaster<int, int, 8> IntTiles;
+    typedef TiledRaster<double, int, 8> FloatTiles;
+    int rows = 20;
+    int cols = 27;
+    Raster<int> infected(rows, cols);
+    infected.zero();
+    infected(3, 4) = 15;
+    infected(12, 20) = 6;
+    Raster<int> susceptible(rows, cols);
+    susceptible.fill(30);
+    Raster<int> total = infected + susceptible;
+    Raster<double> weather(rows, cols);
+    for (int i = 0; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            weather(i, j) = 0.4 + 0.02 * i;
+    Raster<int> zeros(rows, cols);
+    zeros.zero();
+    Raster<int> dispersers = zeros;
+    Raster<int> mortality = zeros;
+    std::vector<Raster<int>> exposed(3, zeros);
+
+    IntTiles tiled_infected(infected);
+    IntTiles tiled_susceptible(susceptible);
+    IntTiles tiled_total(total);
+    FloatTiles tiled_weather(weather);
+    IntTiles tiled_dispersers(rows, cols);
+    IntTiles tiled_mortality(rows, cols);
+    std::vector<IntTiles> tiled_exposed(3, IntTiles(rows, cols));
+
+    auto cells = tile_ordered_cells<8>(all_cells(rows, cols));
+    Simulation<Raster<int>, Raster<double>> simulation(
+        3, rows, cols, ModelType::SusceptibleExposedInfected, 2);
+    Simulation<IntTiles, FloatTiles> tiled_simulation(
+        3, rows, cols, ModelType::SusceptibleExposedInfected, 2);
+    RadialDispersalKernel<Raster<int>> kernel(
+        10, 10, DispersalKernelType::Cauchy, 20, Direction::None, 0, 1);
+    RadialDispersalKernel<IntTiles> tiled_kernel(
+        10, 10, DispersalKernelType::Cauchy, 20, Direction::None, 0, 1);
+    std::vector<std::tuple<int, int>> outside;
+    std::vector<std::tuple<int, int>> tiled_outside;
+    for (unsigned step = 0; step < 6; ++step) {
+        simulation.generate(dispersers, infected, true, weather, 3, cells);
+        simulation.disperse_and_infect(
+            step,
+            dispersers,
+            susceptible,
+            exposed,
+            infected,
+            mortality,
+            total,
+            outside,
+            true,
+            weather,
+            kernel,
+            cells);
+        tiled_simulation.generate(
+            tiled_dispersers, tiled_infected, true, tiled_weather, 3, cells);
+        tiled_simulation.disperse_and_infect(
+            step,
+            tiled_dispersers,
+            tiled_susceptible,
+            tiled_exposed,
+            tiled_infected,
+            tiled_mortality,
+            tiled_total,
+            tiled_outside,
+            true,
+            tiled_weather,
+            tiled_kernel,
+            cells);
+    }
+    if (!same_values(tiled_infected, infected)
+        || !same_values(tiled_susceptible, susceptible)
+        || !same_values(tiled_exposed[2], exposed[2]) || outside != tiled_outside
+        || same_values(tiled_infected, zeros)) {
+        std::cout << "simulation: results with tiled rasters differ:\n"
+                  << infected << tiled_infected;
+        return 1;
+    }
+    return 0;
+}
+
+int main()
+{
+    int num_errors = 0;
+
+    num_errors += test_access();
+    num_errors += test_tile_ordered_cells();
+    num_errors += test_simulation();
+    std::cout << "Tiled raster number of errors: " << num_errors << std::endl;
+    return num_errors;
+}
+
+#endif  // POPS_TEST
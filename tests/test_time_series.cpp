@@ -0,0 +1,143 @@
+#ifdef POPS_TEST
+
+/*
+ * Tests for the PoPS delta-encoded time series.
+ *
+ * Copyright (C) 2020 by the authors.
+ *
+ * This file is part of PoPS.
+
+ * PoPS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+
+ * PoPS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include <pops/raster.hpp>
+#include <pops/time_series.hpp>
+
+using namespace pops;
+
+/** Creates a series where a few cells change in each frame */
+std::vector<Raster<int>> create_series(int size, unsigned num_frames)
+{
+    std::default_random_engine generator(42);
+    std::uniform_int_distribution<int> cell(0, size - 1);
+    std::vector<Raster<int>> series;
+    Raster<int> raster(size, size);
+    raster.zero();
+    raster(0, 0) = 1;
+    for (unsigned frame = 0; frame < num_frames; ++frame) {
+        for (int i = 0; i < 3; ++i)
+            raster(cell(generator), cell(generator)) += 1;
+        // All cells change in one frame.
+        if (frame == 7)
+            raster += 1;
+        series.push_back(raster);
+    }
+    return series;
+}
+
+int test_read_any_frame()
+{
+    int err = 0;
+    int size = 20;
+    auto series = create_series(size, 30);
+    std::stringstream stream;
+    DeltaTimeSeriesWriter<Raster<int>> writer(stream, size, size, 10);
+    for (const auto& raster : series)
+        writer.append(raster);
+    writer.finish();
+
+    std::size_t full_size = series.size() * size * size * sizeof(int);
+    if (stream.str().size() * 2 > full_size) {
+        std::cout << "read_any_frame: series takes " << stream.str().size()
+                  << " bytes (full rasters " << full_size << ")\n";
+        err++;
+    }
+    DeltaTimeSeriesReader<Raster<int>> reader(stream);
+    if (reader.size() != series.size() || reader.rows() != size) {
+        std::cout << "read_any_frame: wrong number of frames or size\n";
+        return ++err;
+    }
+    // in order, backwards, and in arbitrary order
+    std::vector<unsigned> order;
+    for (unsigned i = 0; i < series.size(); ++i)
+        order.push_back(i);
+    for (unsigned i = series.size(); i > 0; --i)
+        order.push_back(i - 1);
+    for (unsigned i : {17, 3, 25, 8, 7, 29, 0, 12})
+        order.push_back(i);
+    for (unsigned i : order) {
+        if (reader.read(i) != series[i]) {
+            std::cout << "read_any_frame: frame " << i << " differs\n";
+            return ++err;
+        }
+    }
+    try {
+        reader.read(series.size());
+        std::cout << "read_any_frame: frame after the end not detected\n";
+        err++;
+    }
+    catch (const std::out_of_range&) {
+    }
+    return err;
+}
+
+int test_invalid_stream()
+{
+    int err = 0;
+    std::stringstream empty;
+    try {
+        DeltaTimeSeriesReader<Raster<int>> reader(empty);
+        std::cout << "invalid_stream: empty stream not detected\n";
+        err++;
+    }
+    catch (const std::runtime_error&) {
+    }
+    // Writer was not finished, so there is no index.
+    std::stringstream stream;
+    DeltaTimeSeriesWriter<Raster<int>> writer(stream, 2, 2);
+    writer.append({{1, 2}, {3, 4}});
+    try {
+        DeltaTimeSeriesReader<Raster<int>> reader(stream);
+        std::cout << "invalid_stream: missing index not detected\n";
+        err++;
+    }
+    catch (const std::runtime_error&) {
+    }
+    try {
+        writer.append({{1, 2, 3}, {3, 4, 5}});
+        std::cout << "invalid_stream: different raster size not detected\n";
+        err++;
+    }
+    catch (const std::invalid_argument&) {
+    }
+    return err;
+}
+
+int main()
+{
+    int num_errors = 0;
+
+    num_errors += test_read_any_frame();
+    num_errors += test_invalid_stream();
+    std::cout << "Time series number of errors: " << num_errors << std::endl;
+    return num_errors;
+}
+
+#endif  // POPS_TEST
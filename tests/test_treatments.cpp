@@ -24,6 +24,7 @@
  * along with PoPS. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <utility>
 #include <vector>
 #include <pops/raster.hpp>
 #include <pops/treatments.hpp>
@@ -451,6 +452,135 @@ int test_clear()
     return num_errors;
 }
 
+int test_sparse_map()
+{
+    int num_errors = 0;
+    Scheduler scheduler(Date(2020, 1, 1), Date(2020, 12, 31), StepUnit::Day, 7);
+    Treatments<Raster<int>, Raster<double>> treatments(scheduler);
+    Raster<double> tr1(4, 4);
+    tr1.zero();
+    tr1(1, 1) = 1;
+    tr1(1, 2) = 0.5;
+    tr1(2, 3) = 0.75;
+
+    Raster<int> susceptible(4, 4);
+    susceptible.fill(10);
+    Raster<int> resistant(4, 4);
+    resistant.zero();
+    Raster<int> infected(4, 4);
+    infected.fill(4);
+    std::vector<Raster<int>> exposed;
+
+    std::vector<std::vector<int>> suitable_cells;
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            suitable_cells.push_back({i, j});
+
+    treatments.add_treatment(tr1, Date(2020, 1, 1), 7, TreatmentApplication::Ratio);
+    // Treatment uses the map as it was when the treatment was added.
+    tr1.fill(1);
+    unsigned n = scheduler.schedule_action_date(Date(2020, 1, 1));
+    treatments.manage(n, infected, exposed, susceptible, resistant, suitable_cells);
+
+    Raster<int> treated = {
+        {10, 10, 10, 10}, {10, 0, 5, 10}, {10, 10, 10, 3}, {10, 10, 10, 10}};
+    Raster<int> inf_treated = {{4, 4, 4, 4}, {4, 0, 2, 4}, {4, 4, 4, 1}, {4, 4, 4, 4}};
+    Raster<int> resist = {{0, 0, 0, 0}, {0, 14, 7, 0}, {0, 0, 0, 10}, {0, 0, 0, 0}};
+    if (!(susceptible == treated && infected == inf_treated && resist == resistant)) {
+        std::cout << "Treatment with sparse map does not work" << std::endl;
+        std::cout << susceptible << infected << resistant;
+        num_errors++;
+    }
+    n = scheduler.schedule_action_date(Date(2020, 1, 8));
+    treatments.manage(n, infected, exposed, susceptible, resistant, suitable_cells);
+
+    treated = {{10, 10, 10, 10}, {10, 14, 12, 10}, {10, 10, 10, 13}, {10, 10, 10, 10}};
+    resist = {{0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}, {0, 0, 0, 0}};
+    if (!(susceptible == treated && infected == inf_treated && resist == resistant)) {
+        std::cout << "End of treatment with sparse map does not work" << std::endl;
+        std::cout << susceptible << infected << resistant;
+        num_errors++;
+    }
+    return num_errors;
+}
+
+int test_unsuitable_cells()
+{
+    int num_errors = 0;
+    Scheduler scheduler(Date(2020, 1, 1), Date(2020, 12, 31), StepUnit::Day, 7);
+    Treatments<Raster<int>, Raster<double>> treatments(scheduler);
+    Raster<double> tr1 = {{1, 0.5}, {0.75, 0}};
+    Raster<int> susceptible = {{10, 6}, {20, 42}};
+    // Resistant hosts in the unsuitable cell stay there after the end.
+    Raster<int> resistant = {{0, 0}, {3, 0}};
+    Raster<int> infected = {{1, 4}, {16, 40}};
+    std::vector<Raster<int>> exposed;
+
+    // Treated cell (1, 0) is not suitable.
+    std::vector<std::vector<int>> suitable_cells = {{0, 0}, {0, 1}, {1, 1}};
+
+    treatments.add_treatment(tr1, Date(2020, 5, 1), 7, TreatmentApplication::Ratio);
+    unsigned n = scheduler.schedule_action_date(Date(2020, 5, 3));
+    treatments.manage(n, infected, exposed, susceptible, resistant, suitable_cells);
+
+    Raster<int> treated = {{0, 3}, {20, 42}};
+    Raster<int> inf_treated = {{0, 2}, {16, 40}};
+    Raster<int> resist = {{11, 5}, {3, 0}};
+    if (!(susceptible == treated && infected == inf_treated && resist == resistant)) {
+        std::cout << "Treatment is applied to unsuitable cells" << std::endl;
+        std::cout << susceptible << infected << resistant;
+        num_errors++;
+    }
+    n = scheduler.schedule_action_date(Date(2020, 5, 8));
+    treatments.manage(n, infected, exposed, susceptible, resistant, suitable_cells);
+
+    treated = {{11, 8}, {20, 42}};
+    resist = {{0, 0}, {3, 0}};
+    if (!(susceptible == treated && infected == inf_treated && resist == resistant)) {
+        std::cout << "Treatment ends in unsuitable cells" << std::endl;
+        std::cout << susceptible << infected << resistant;
+        num_errors++;
+    }
+    return num_errors;
+}
+
+int test_steps_without_treatment()
+{
+    int num_errors = 0;
+    Scheduler scheduler(Date(2020, 1, 1), Date(2020, 12, 31), StepUnit::Month, 1);
+    Treatments<Raster<int>, Raster<double>> treatments(scheduler);
+    Raster<double> tr1 = {{1, 0.5}, {0.75, 0}};
+    Raster<int> susceptible = {{10, 6}, {20, 42}};
+    Raster<int> resistant = {{0, 0}, {0, 0}};
+    Raster<int> infected = {{1, 4}, {16, 40}};
+    std::vector<Raster<int>> exposed;
+
+    std::vector<std::vector<int>> suitable_cells = {{0, 0}, {0, 1}, {1, 0}, {1, 1}};
+
+    treatments.add_treatment(tr1, Date(2020, 3, 1), 0, TreatmentApplication::Ratio);
+    treatments.add_treatment(tr1, Date(2020, 5, 1), 40, TreatmentApplication::Ratio);
+    // Treatments are movable.
+    auto moved = std::move(treatments);
+    std::vector<unsigned> active_steps;
+    for (unsigned step = 0; step < scheduler.get_num_steps(); ++step) {
+        if (moved.manage(step, infected, exposed, susceptible, resistant, suitable_cells))
+            active_steps.push_back(step);
+        if (moved.manage_mortality(step, infected, suitable_cells)
+            && step != 2 && step != 4) {
+            std::cout << "Mortality treatment applied in step " << step << std::endl;
+            num_errors++;
+        }
+    }
+    if (active_steps != std::vector<unsigned>{2, 4, 5}) {
+        std::cout << "Treatments were not managed in the right steps:";
+        for (auto step : active_steps)
+            std::cout << " " << step;
+        std::cout << std::endl;
+        num_errors++;
+    }
+    return num_errors;
+}
+
 int test_treat_app_from_string()
 {
     int num_errors = 0;
@@ -484,6 +614,9 @@ int main()
     num_errors += test_pesticide_temporal_overlap();
     num_errors += test_steering();
     num_errors += test_clear();
+    num_errors += test_sparse_map();
+    num_errors += test_unsuitable_cells();
+    num_errors += test_steps_without_treatment();
     num_errors += test_treat_app_from_string();
 
     std::cout << "Test treatments number of errors: " << num_errors << std::endl;